@@ -3,15 +3,35 @@ set(kerneltest_HEADERS
   "include/kerneltest.hpp"
   "include/kerneltest/kerneltest.hpp"
   "include/kerneltest/revision.hpp"
+  "include/kerneltest/v1.0/allocations.hpp"
+  "include/kerneltest/v1.0/async_kernel.hpp"
+  "include/kerneltest/v1.0/baseline.hpp"
+  "include/kerneltest/v1.0/batch.hpp"
+  "include/kerneltest/v1.0/benchmark.hpp"
   "include/kerneltest/v1.0/child_process.hpp"
   "include/kerneltest/v1.0/config.hpp"
+  "include/kerneltest/v1.0/counters.hpp"
   "include/kerneltest/v1.0/detail/impl/child_process.ipp"
   "include/kerneltest/v1.0/detail/impl/posix/child_process.ipp"
   "include/kerneltest/v1.0/detail/impl/windows/child_process.ipp"
+  "include/kerneltest/v1.0/differential.hpp"
+  "include/kerneltest/v1.0/executor.hpp"
+  "include/kerneltest/v1.0/hooks/allocations.hpp"
   "include/kerneltest/v1.0/hooks/custom.hpp"
   "include/kerneltest/v1.0/hooks/filesystem_workspace.hpp"
+  "include/kerneltest/v1.0/hooks/timeout.hpp"
   "include/kerneltest/v1.0/kerneltest.hpp"
+  "include/kerneltest/v1.0/parameter_generators.hpp"
+  "include/kerneltest/v1.0/permutation_results.hpp"
   "include/kerneltest/v1.0/permute_parameters.hpp"
+  "include/kerneltest/v1.0/placement.hpp"
+  "include/kerneltest/v1.0/process_isolation.hpp"
+  "include/kerneltest/v1.0/reporters.hpp"
+  "include/kerneltest/v1.0/result_cache.hpp"
+  "include/kerneltest/v1.0/schedule.hpp"
+  "include/kerneltest/v1.0/sharding.hpp"
+  "include/kerneltest/v1.0/signal_capture.hpp"
   "include/kerneltest/v1.0/test_kernel.hpp"
+  "include/kerneltest/v1.0/watchdog.hpp"
   "include/kerneltest/version.hpp"
 )
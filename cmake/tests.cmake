@@ -1,8 +1,35 @@
 # DO NOT EDIT, GENERATED BY SCRIPT
 set(kerneltest_TESTS
+  "test/allocations.cpp"
+  "test/allocations_malloc.cpp"
+  "test/async_kernel.cpp"
   "test/auto_permute_test_kernel1.hpp"
   "test/auto_permute_test_kernel2.hpp"
+  "test/baseline.cpp"
+  "test/batch.cpp"
+  "test/benchmark.cpp"
+  "test/cartesian_product.cpp"
+  "test/constexpr_tables.cpp"
+  "test/counters.cpp"
   "test/coverage_main.cpp"
+  "test/covering_array.cpp"
+  "test/differential.cpp"
+  "test/duplicates.cpp"
+  "test/executor.cpp"
+  "test/fail_fast.cpp"
+  "test/hook_pool.cpp"
+  "test/permutation_results.cpp"
+  "test/permuter_test_kernels.hpp"
+  "test/placement.cpp"
+  "test/process_isolation.cpp"
+  "test/reporters.cpp"
+  "test/result_cache.cpp"
+  "test/schedule.cpp"
+  "test/sharding.cpp"
+  "test/signal_capture.cpp"
+  "test/statistics.cpp"
+  "test/stream.cpp"
+  "test/timeout.cpp"
 )
 # DO NOT EDIT, GENERATED BY SCRIPT
 set(kerneltest_COMPILE_TESTS
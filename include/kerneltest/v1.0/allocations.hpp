@@ -0,0 +1,420 @@
+/* Accounting for the heap allocations made by test kernels
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+
+#ifndef KERNELTEST_ALLOCATIONS_HPP
+#define KERNELTEST_ALLOCATIONS_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <ostream>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#elif defined(__linux__) || defined(__FreeBSD__)
+#include <malloc.h>
+#endif
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+/*! \brief The heap allocations made by the calling thread during a test kernel.
+
+Allocations are only seen if `KERNELTEST_TRACK_ALLOCATIONS()` or `KERNELTEST_TRACK_MALLOC()`
+has been expanded in exactly one source file of the program. Allocations made by other threads
+on behalf of the kernel are not seen.
+*/
+struct allocation_statistics
+{
+  uint64_t allocations{0};      //!< Calls allocating memory
+  uint64_t deallocations{0};    //!< Calls freeing memory, including that allocated before the kernel
+  uint64_t bytes{0};            //!< Bytes requested by the allocating calls
+  uint64_t peak_live_bytes{0};  //!< The most bytes allocated by the kernel and not yet freed, as rounded up by the allocator
+  bool tracked{false};          //!< False if allocation tracking was not installed into the program, so nothing was seen
+};
+
+//! Prints an allocation_statistics
+inline std::ostream &operator<<(std::ostream &s, const allocation_statistics &v)
+{
+  if(!v.tracked)
+    return s << "allocations not tracked";
+  return s << v.allocations << " allocations of " << v.bytes << " bytes, " << v.deallocations << " deallocations, peak live " << v.peak_live_bytes << " bytes";
+}
+
+/*! \brief Upper bounds upon the heap allocations of a test kernel, as checked by `hooks::bounded_allocations()`.
+Members not set are unbounded, so `allocation_limits{0}` asserts that the kernel does not allocate.
+*/
+struct allocation_limits
+{
+  uint64_t allocations{(std::numeric_limits<uint64_t>::max)()};      //!< The most calls allocating memory
+  uint64_t bytes{(std::numeric_limits<uint64_t>::max)()};            //!< The most bytes requested
+  uint64_t peak_live_bytes{(std::numeric_limits<uint64_t>::max)()};  //!< The most bytes live at once
+
+  //! True if v is within these limits
+  bool permits(const allocation_statistics &v) const noexcept { return v.allocations <= allocations && v.bytes <= bytes && v.peak_live_bytes <= peak_live_bytes; }
+};
+
+//! Prints the bounded members of an allocation_limits
+inline std::ostream &operator<<(std::ostream &s, const allocation_limits &v)
+{
+  const char *separator = "";
+  auto field = [&](const char *name, uint64_t value)
+  {
+    if(value != (std::numeric_limits<uint64_t>::max)())
+    {
+      s << separator << name << " <= " << value;
+      separator = ", ";
+    }
+  };
+  field("allocations", v.allocations);
+  field("bytes", v.bytes);
+  field("peak live bytes", v.peak_live_bytes);
+  if(*separator == 0)
+    s << "unbounded allocations";
+  return s;
+}
+
+/*! Sums the allocations of every permutation which tracked them. The peak live bytes is the
+greatest of any permutation.
+\param statistics A sequence of `permutation_statistics`, as filled by the permuter
+*/
+template <class Sequence> inline allocation_statistics total_allocations(const Sequence &statistics)
+{
+  allocation_statistics ret;
+  for(const auto &i : statistics)
+  {
+    if(!i.allocations.tracked)
+      continue;
+    ret.tracked = true;
+    ret.allocations += i.allocations.allocations;
+    ret.deallocations += i.allocations.deallocations;
+    ret.bytes += i.allocations.bytes;
+    if(i.allocations.peak_live_bytes > ret.peak_live_bytes)
+      ret.peak_live_bytes = i.allocations.peak_live_bytes;
+  }
+  return ret;
+}
+
+namespace detail
+{
+  //! True once allocation tracking has been installed into the program
+  inline bool &allocation_tracking_installed() noexcept
+  {
+    static bool v;
+    return v;
+  }
+  // The allocations seen by the calling thread. Trivial, as it is used from within the allocator.
+  struct allocation_tally
+  {
+    bool active;
+    uint64_t allocations, deallocations, bytes;
+    int64_t live, peak_live;
+  };
+  inline allocation_tally &this_thread_allocations() noexcept
+  {
+    static QUICKCPPLIB_THREAD_LOCAL allocation_tally v;
+    return v;
+  }
+  //! The allocations of the kernel most recently executed by the calling thread
+  inline allocation_statistics &last_kernel_allocations() noexcept
+  {
+    static QUICKCPPLIB_THREAD_LOCAL allocation_statistics v;
+    return v;
+  }
+  //! The bytes actually allocated for a block returned by malloc()
+  inline size_t allocated_size(void *p) noexcept
+  {
+#ifdef _WIN32
+    return _msize(p);
+#elif defined(__APPLE__)
+    return malloc_size(p);
+#elif defined(__linux__) || defined(__FreeBSD__)
+    return malloc_usable_size(p);
+#else
+    (void) p;
+    return 0;
+#endif
+  }
+  inline void note_allocation(size_t bytes, size_t allocated) noexcept
+  {
+    allocation_tally &t = this_thread_allocations();
+    if(!t.active)
+      return;
+    t.allocations++;
+    t.bytes += bytes;
+    t.live += static_cast<int64_t>(allocated);
+    if(t.live > t.peak_live)
+      t.peak_live = t.live;
+  }
+  inline void note_deallocation(size_t allocated) noexcept
+  {
+    allocation_tally &t = this_thread_allocations();
+    if(!t.active)
+      return;
+    t.deallocations++;
+    t.live -= static_cast<int64_t>(allocated);
+  }
+
+  /* Tracks the allocations of the calling thread for its lifetime, into `last_kernel_allocations()`
+  and if set `out`. Windows may nest, in which case the allocations of the inner window are also
+  seen by the outer one.
+  */
+  class allocation_window
+  {
+    allocation_tally _outer;
+    allocation_statistics *_out;
+
+  public:
+    explicit allocation_window(allocation_statistics *out) noexcept
+        : _outer(this_thread_allocations())
+        , _out(out)
+    {
+      this_thread_allocations() = allocation_tally{true, 0, 0, 0, 0, 0};
+    }
+    allocation_window(const allocation_window &) = delete;
+    allocation_window &operator=(const allocation_window &) = delete;
+    ~allocation_window()
+    {
+      allocation_tally &t = this_thread_allocations();
+      t.active = false;
+      allocation_statistics ret;
+      ret.allocations = t.allocations;
+      ret.deallocations = t.deallocations;
+      ret.bytes = t.bytes;
+      ret.peak_live_bytes = (t.peak_live > 0) ? static_cast<uint64_t>(t.peak_live) : 0;
+      ret.tracked = allocation_tracking_installed();
+      last_kernel_allocations() = ret;
+      if(_out != nullptr)
+        *_out = ret;
+      if(_outer.active)
+      {
+        if(_outer.live + t.peak_live > _outer.peak_live)
+          _outer.peak_live = _outer.live + t.peak_live;
+        _outer.allocations += t.allocations;
+        _outer.deallocations += t.deallocations;
+        _outer.bytes += t.bytes;
+        _outer.live += t.live;
+      }
+      t = _outer;
+    }
+  };
+
+  //! True if Hook needs the allocations of each kernel tracked (see `hooks::bounded_allocations`)
+  template <class Hook, class = void> struct tracks_allocations : std::false_type
+  {
+  };
+  template <class Hook>
+  struct tracks_allocations<Hook, decltype((void) std::decay<Hook>::type::tracks_allocations)> : std::integral_constant<bool, std::decay<Hook>::type::tracks_allocations>
+  {
+  };
+
+  // Allocates for the replacement operator new
+  inline void *tracked_new(size_t bytes, size_t alignment) noexcept
+  {
+    if(0 == bytes)
+      bytes = 1;
+    void *p = nullptr;
+    if(alignment <= alignof(std::max_align_t))
+      p = ::malloc(bytes);
+    else
+    {
+#ifdef _WIN32
+      p = _aligned_malloc(bytes, alignment);
+#else
+      if(0 != ::posix_memalign(&p, alignment, bytes))
+        p = nullptr;
+#endif
+    }
+    if(p != nullptr)
+    {
+#ifdef _WIN32
+      note_allocation(bytes, (alignment <= alignof(std::max_align_t)) ? _msize(p) : _aligned_msize(p, alignment, 0));
+#else
+      note_allocation(bytes, allocated_size(p));
+#endif
+    }
+    return p;
+  }
+  // Frees for the replacement operator delete
+  inline void tracked_delete(void *p, size_t alignment) noexcept
+  {
+    if(p == nullptr)
+      return;
+#ifdef _WIN32
+    if(alignment > alignof(std::max_align_t))
+    {
+      note_deallocation(_aligned_msize(p, alignment, 0));
+      _aligned_free(p);
+      return;
+    }
+#else
+    (void) alignment;
+#endif
+    note_deallocation(allocated_size(p));
+    ::free(p);
+  }
+  // Allocates for the replacement operator new, reporting failure as the standard requires
+  inline void *tracked_new_or_throw(size_t bytes, size_t alignment)
+  {
+    for(;;)
+    {
+      void *p = tracked_new(bytes, alignment);
+      if(p != nullptr)
+        return p;
+      std::new_handler handler = std::get_new_handler();
+      if(handler == nullptr)
+        throw std::bad_alloc();
+      handler();
+    }
+  }
+}  // namespace detail
+
+/*! \brief Installs tracking of heap allocations made by global operator new and delete.
+
+Expand at global scope in exactly one source file of the program. The replacement operators
+allocate using `malloc()`, so allocations are seen by `permute_options::allocations` and
+`hooks::bounded_allocations()`. Do not use together with `KERNELTEST_TRACK_MALLOC()`, which
+already sees allocations by operator new on most platforms.
+*/
+#define KERNELTEST_TRACK_ALLOCATIONS()                                                                                                                         \
+  static const bool kerneltest_allocation_tracking_installed = (KERNELTEST_V1_NAMESPACE::detail::allocation_tracking_installed() = true);                     \
+  void *operator new(std::size_t n) { return KERNELTEST_V1_NAMESPACE::detail::tracked_new_or_throw(n, 0); }                                                  \
+  void *operator new[](std::size_t n) { return KERNELTEST_V1_NAMESPACE::detail::tracked_new_or_throw(n, 0); }                                                \
+  void *operator new(std::size_t n, const std::nothrow_t &) noexcept { return KERNELTEST_V1_NAMESPACE::detail::tracked_new(n, 0); }                          \
+  void *operator new[](std::size_t n, const std::nothrow_t &) noexcept { return KERNELTEST_V1_NAMESPACE::detail::tracked_new(n, 0); }                        \
+  void *operator new(std::size_t n, std::align_val_t a) { return KERNELTEST_V1_NAMESPACE::detail::tracked_new_or_throw(n, static_cast<std::size_t>(a)); }  \
+  void *operator new[](std::size_t n, std::align_val_t a) { return KERNELTEST_V1_NAMESPACE::detail::tracked_new_or_throw(n, static_cast<std::size_t>(a)); } \
+  void *operator new(std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept                                                                     \
+  {                                                                                                                                                          \
+    return KERNELTEST_V1_NAMESPACE::detail::tracked_new(n, static_cast<std::size_t>(a));                                                                     \
+  }                                                                                                                                                          \
+  void *operator new[](std::size_t n, std::align_val_t a, const std::nothrow_t &) noexcept                                                                   \
+  {                                                                                                                                                          \
+    return KERNELTEST_V1_NAMESPACE::detail::tracked_new(n, static_cast<std::size_t>(a));                                                                     \
+  }                                                                                                                                                          \
+  void operator delete(void *p) noexcept { KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, 0); }                                                          \
+  void operator delete[](void *p) noexcept { KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, 0); }                                                        \
+  void operator delete(void *p, std::size_t) noexcept { KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, 0); }                                             \
+  void operator delete[](void *p, std::size_t) noexcept { KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, 0); }                                           \
+  void operator delete(void *p, const std::nothrow_t &) noexcept { KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, 0); }                                  \
+  void operator delete[](void *p, const std::nothrow_t &) noexcept { KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, 0); }                                \
+  void operator delete(void *p, std::align_val_t a) noexcept { KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, static_cast<std::size_t>(a)); }           \
+  void operator delete[](void *p, std::align_val_t a) noexcept { KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, static_cast<std::size_t>(a)); }         \
+  void operator delete(void *p, std::size_t, std::align_val_t a) noexcept { KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, static_cast<std::size_t>(a)); } \
+  void operator delete[](void *p, std::size_t, std::align_val_t a) noexcept                                                                                  \
+  {                                                                                                                                                          \
+    KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, static_cast<std::size_t>(a));                                                                         \
+  }                                                                                                                                                          \
+  void operator delete(void *p, std::align_val_t a, const std::nothrow_t &) noexcept                                                                         \
+  {                                                                                                                                                          \
+    KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, static_cast<std::size_t>(a));                                                                         \
+  }                                                                                                                                                          \
+  void operator delete[](void *p, std::align_val_t a, const std::nothrow_t &) noexcept                                                                       \
+  {                                                                                                                                                          \
+    KERNELTEST_V1_NAMESPACE::detail::tracked_delete(p, static_cast<std::size_t>(a));                                                                         \
+  }
+
+#ifdef __GLIBC__
+/*! \brief Installs tracking of heap allocations made by `malloc()` and friends, and so also by
+global operator new. Only available on glibc.
+
+Expand at global scope in exactly one source file of the program, which is interposed before
+glibc's allocator. This sees allocations made by C code and by the C++ runtime which operator
+new replacement does not, at the cost of every allocation in the program passing through a
+thread local check.
+*/
+#define KERNELTEST_TRACK_MALLOC()                                                                                                                              \
+  static const bool kerneltest_allocation_tracking_installed = (KERNELTEST_V1_NAMESPACE::detail::allocation_tracking_installed() = true);                     \
+  extern "C" void *malloc(size_t n)                                                                                                                          \
+  {                                                                                                                                                          \
+    void *p = __libc_malloc(n);                                                                                                                              \
+    if(p != nullptr)                                                                                                                                         \
+      KERNELTEST_V1_NAMESPACE::detail::note_allocation(n, malloc_usable_size(p));                                                                            \
+    return p;                                                                                                                                                \
+  }                                                                                                                                                          \
+  extern "C" void *calloc(size_t c, size_t n)                                                                                                                \
+  {                                                                                                                                                          \
+    void *p = __libc_calloc(c, n);                                                                                                                           \
+    if(p != nullptr)                                                                                                                                         \
+      KERNELTEST_V1_NAMESPACE::detail::note_allocation(c * n, malloc_usable_size(p));                                                                        \
+    return p;                                                                                                                                                \
+  }                                                                                                                                                          \
+  extern "C" void *realloc(void *o, size_t n)                                                                                                                \
+  {                                                                                                                                                          \
+    const size_t old = (o != nullptr) ? malloc_usable_size(o) : 0;                                                                                           \
+    void *p = __libc_realloc(o, n);                                                                                                                          \
+    if(p != nullptr || 0 == n)                                                                                                                               \
+    {                                                                                                                                                        \
+      if(o != nullptr)                                                                                                                                       \
+        KERNELTEST_V1_NAMESPACE::detail::note_deallocation(old);                                                                                             \
+      if(p != nullptr)                                                                                                                                       \
+        KERNELTEST_V1_NAMESPACE::detail::note_allocation(n, malloc_usable_size(p));                                                                          \
+    }                                                                                                                                                        \
+    return p;                                                                                                                                                \
+  }                                                                                                                                                          \
+  extern "C" void *memalign(size_t a, size_t n)                                                                                                              \
+  {                                                                                                                                                          \
+    void *p = __libc_memalign(a, n);                                                                                                                         \
+    if(p != nullptr)                                                                                                                                         \
+      KERNELTEST_V1_NAMESPACE::detail::note_allocation(n, malloc_usable_size(p));                                                                            \
+    return p;                                                                                                                                                \
+  }                                                                                                                                                          \
+  extern "C" void *aligned_alloc(size_t a, size_t n) { return memalign(a, n); }                                                                              \
+  extern "C" int posix_memalign(void **out, size_t a, size_t n)                                                                                              \
+  {                                                                                                                                                          \
+    if(0 == a || (a & (a - 1)) != 0 || (a % sizeof(void *)) != 0)                                                                                            \
+      return EINVAL;                                                                                                                                         \
+    void *p = memalign(a, n);                                                                                                                                \
+    if(p == nullptr)                                                                                                                                         \
+      return ENOMEM;                                                                                                                                         \
+    *out = p;                                                                                                                                                \
+    return 0;                                                                                                                                                \
+  }                                                                                                                                                          \
+  extern "C" void free(void *p)                                                                                                                              \
+  {                                                                                                                                                          \
+    if(p != nullptr)                                                                                                                                         \
+      KERNELTEST_V1_NAMESPACE::detail::note_deallocation(malloc_usable_size(p));                                                                             \
+    __libc_free(p);                                                                                                                                          \
+  }
+#endif
+
+KERNELTEST_V1_NAMESPACE_END
+
+#ifdef __GLIBC__
+// glibc's allocator, which KERNELTEST_TRACK_MALLOC() forwards to
+extern "C" void *__libc_malloc(size_t);
+extern "C" void *__libc_calloc(size_t, size_t);
+extern "C" void *__libc_realloc(void *, size_t);
+extern "C" void *__libc_memalign(size_t, size_t);
+extern "C" void __libc_free(void *);
+#endif
+
+#endif
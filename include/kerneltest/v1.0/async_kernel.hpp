@@ -0,0 +1,437 @@
+/* Asynchronous test kernels multiplexed upon an event loop
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "process_isolation.hpp"
+
+#ifndef KERNELTEST_ASYNC_KERNEL_HPP
+#define KERNELTEST_ASYNC_KERNEL_HPP
+
+#include <type_traits>
+
+//! True if test kernels may be coroutines (see `kernel_task`)
+#ifndef KERNELTEST_HAVE_COROUTINES
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>) && defined(__linux__)
+#define KERNELTEST_HAVE_COROUTINES 1
+#else
+#define KERNELTEST_HAVE_COROUTINES 0
+#endif
+#endif
+
+#if KERNELTEST_HAVE_COROUTINES
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+#if KERNELTEST_HAVE_COROUTINES
+template <class T> class kernel_task;
+#endif
+
+namespace detail
+{
+  //! The outcome of a test kernel returning T, which unwraps `kernel_task`
+  template <class T> struct unwrap_kernel_task
+  {
+    using type = T;
+  };
+#if KERNELTEST_HAVE_COROUTINES
+  template <class T> struct unwrap_kernel_task<kernel_task<T>>
+  {
+    using type = T;
+  };
+#endif
+  //! True if a test kernel returning T is asynchronous
+  template <class T> struct is_kernel_task : std::integral_constant<bool, !std::is_same<typename unwrap_kernel_task<T>::type, T>::value>
+  {
+  };
+}  // namespace detail
+
+#if KERNELTEST_HAVE_COROUTINES
+class event_loop;
+
+namespace detail
+{
+  //! The event loop executing upon the calling thread, if any
+  inline event_loop *&this_thread_event_loop() noexcept
+  {
+    static QUICKCPPLIB_THREAD_LOCAL event_loop *v;
+    return v;
+  }
+  // A coroutine executing a whole permutation, whose frame destroys itself once complete
+  struct detached_task
+  {
+    struct promise_type
+    {
+      event_loop *loop{nullptr};
+      promise_type *prev{nullptr}, *next{nullptr};  // within the loop's list of incomplete tasks
+      inline ~promise_type();
+      detached_task get_return_object() noexcept { return detached_task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() noexcept {}
+      void unhandled_exception() noexcept { std::terminate(); }
+    };
+    std::coroutine_handle<promise_type> handle;
+  };
+}  // namespace detail
+
+/*! \class kernel_task
+\brief The return type of a test kernel which is a coroutine, where T is its outcome type.
+
+A test kernel returning `kernel_task<result<T>>` is executed by a `parameter_permuter` as a
+coroutine upon an event loop, so thousands of permutations can await I/O concurrently upon
+a few threads. Such kernels may only `co_await` other `kernel_task`s and the awaitables of
+the `event_loop` executing them, which is `event_loop::current()`:
+
+\code
+auto permuter = mt_permute_parameters<result<size_t>, parameters<int>>(...);
+auto results = permuter([](int fd) -> kernel_task<result<size_t>> {
+  OUTCOME_CO_TRYV(co_await event_loop::current()->readable(fd));
+  ...
+  co_return bytes;
+});
+\endcode
+
+The task does not begin until awaited. Exceptions thrown by the coroutine are rethrown by
+the `co_await`. Awaiting a moved from task throws `std::logic_error`. A permutation awaiting
+anything else is destroyed, failing with `kerneltest_errc::kernel_stalled`, once nothing upon
+its loop remains able to progress.
+*/
+template <class T> class kernel_task
+{
+public:
+  struct promise_type
+  {
+    optional<T> value;
+#ifdef __cpp_exceptions
+    std::exception_ptr exception;
+#endif
+    std::coroutine_handle<> continuation;
+
+    kernel_task get_return_object() noexcept { return kernel_task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    auto final_suspend() noexcept
+    {
+      // Resume whatever awaited us without growing the stack
+      struct awaiter
+      {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+        {
+          std::coroutine_handle<> next = h.promise().continuation;
+          return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+      };
+      return awaiter{};
+    }
+    template <class U> void return_value(U &&v) { value.emplace(std::forward<U>(v)); }
+    void unhandled_exception() noexcept
+    {
+#ifdef __cpp_exceptions
+      exception = std::current_exception();
+#else
+      std::terminate();
+#endif
+    }
+  };
+
+private:
+  std::coroutine_handle<promise_type> _h;
+
+  explicit kernel_task(std::coroutine_handle<promise_type> h) noexcept
+      : _h(h)
+  {
+  }
+
+public:
+  kernel_task(kernel_task &&o) noexcept
+      : _h(std::exchange(o._h, nullptr))
+  {
+  }
+  kernel_task(const kernel_task &) = delete;
+  kernel_task &operator=(kernel_task &&o) noexcept
+  {
+    if(this != &o)
+    {
+      if(_h)
+        _h.destroy();
+      _h = std::exchange(o._h, nullptr);
+    }
+    return *this;
+  }
+  kernel_task &operator=(const kernel_task &) = delete;
+  ~kernel_task()
+  {
+    if(_h)
+      _h.destroy();
+  }
+
+  bool await_ready() const noexcept { return !_h || _h.done(); }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+  {
+    _h.promise().continuation = awaiting;
+    return _h;
+  }
+  T await_resume()
+  {
+    if(!_h)
+#ifdef __cpp_exceptions
+      throw std::logic_error("awaited a kernel_task which was moved from");
+#else
+      abort();
+#endif
+    promise_type &p = _h.promise();
+#ifdef __cpp_exceptions
+    if(p.exception)
+      std::rethrow_exception(p.exception);
+#endif
+    return std::move(*p.value);
+  }
+};
+
+/*! \class event_loop
+\brief A single threaded loop resuming coroutines once the file descriptors or timers they
+await are ready, implemented using epoll.
+
+Each thread executing permutations of asynchronous kernels runs its own loop, and every
+coroutine it executes is resumed upon that thread. At most one coroutine may await each file
+descriptor at a time.
+*/
+class event_loop
+{
+  friend struct detail::detached_task::promise_type;
+
+  // A coroutine awaiting a file descriptor
+  struct fd_waiter
+  {
+    event_loop *loop;
+    int fd;
+    uint32_t events;
+    int error{0};
+    std::coroutine_handle<> awaiting;
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> h) noexcept
+    {
+      awaiting = h;
+      struct epoll_event ev;
+      ev.events = events | EPOLLONESHOT;
+      ev.data.ptr = this;
+      // Descriptors stay registered but disarmed after firing, so rearm them if already known
+      if(-1 == epoll_ctl(loop->_fd, EPOLL_CTL_MOD, fd, &ev) && (ENOENT != errno || -1 == epoll_ctl(loop->_fd, EPOLL_CTL_ADD, fd, &ev)))
+      {
+        error = errno;
+        return false;
+      }
+      loop->_waiting++;
+      return true;
+    }
+    result<void> await_resume() const noexcept
+    {
+      if(0 != error)
+      {
+        detail::portable_error e;
+        e.value = error;
+        return detail::from_portable_error(e);
+      }
+      return success();
+    }
+  };
+  // A coroutine awaiting a time
+  struct timer_waiter
+  {
+    event_loop *loop;
+    std::chrono::steady_clock::time_point deadline;
+
+    bool await_ready() const noexcept { return deadline <= std::chrono::steady_clock::now(); }
+    void await_suspend(std::coroutine_handle<> h) { loop->_timers.push(timer{deadline, loop->_timer_sequence++, h}); }
+    void await_resume() const noexcept {}
+  };
+  struct timer
+  {
+    std::chrono::steady_clock::time_point deadline;
+    uint64_t sequence;  // timers with equal deadlines fire in the order they were set
+    std::coroutine_handle<> awaiting;
+    bool operator>(const timer &o) const noexcept { return (deadline != o.deadline) ? deadline > o.deadline : sequence > o.sequence; }
+  };
+
+  int _fd{-1};
+  event_loop *_previous{nullptr};
+  std::deque<std::coroutine_handle<>> _ready;
+  std::priority_queue<timer, std::vector<timer>, std::greater<timer>> _timers;
+  uint64_t _timer_sequence{0};
+  size_t _active{0}, _waiting{0};
+  detail::detached_task::promise_type *_spawned{nullptr};  // incomplete coroutines spawned
+
+  void _fire_timers()
+  {
+    const auto now = std::chrono::steady_clock::now();
+    while(!_timers.empty() && _timers.top().deadline <= now)
+    {
+      _ready.push_back(_timers.top().awaiting);
+      _timers.pop();
+    }
+  }
+
+public:
+  //! Constructs a loop, which becomes `current()` upon the calling thread until destructed
+  event_loop()
+      : _fd(epoll_create1(EPOLL_CLOEXEC))
+      , _previous(detail::this_thread_event_loop())
+  {
+    detail::this_thread_event_loop() = this;
+  }
+  event_loop(const event_loop &) = delete;
+  event_loop &operator=(const event_loop &) = delete;
+  ~event_loop()
+  {
+    detail::this_thread_event_loop() = _previous;
+    if(-1 != _fd)
+      ::close(_fd);
+  }
+
+  //! The event loop executing upon the calling thread, or null
+  static event_loop *current() noexcept { return detail::this_thread_event_loop(); }
+  //! True if the loop could be created
+  bool is_valid() const noexcept { return -1 != _fd; }
+  //! The number of coroutines spawned which have not yet completed
+  size_t active() const noexcept { return _active; }
+
+  //! Awaits `fd` becoming readable, or failing to be watched (e.g. regular files cannot be)
+  fd_waiter readable(int fd) noexcept { return fd_waiter{this, fd, EPOLLIN | EPOLLRDHUP, 0, {}}; }
+  //! Awaits `fd` becoming writable, or failing to be watched (e.g. regular files cannot be)
+  fd_waiter writable(int fd) noexcept { return fd_waiter{this, fd, EPOLLOUT, 0, {}}; }
+  //! Awaits the passing of `duration`
+  template <class Rep, class Period> timer_waiter sleep_for(std::chrono::duration<Rep, Period> duration)
+  {
+    return timer_waiter{this, std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(duration)};
+  }
+  //! Lets every other ready coroutine execute before resuming
+  timer_waiter yield() noexcept { return timer_waiter{this, std::chrono::steady_clock::time_point()}; }
+
+  //! Begins executing a detached coroutine upon the next call to `run_once()`
+  void spawn(detail::detached_task task)
+  {
+    detail::detached_task::promise_type &p = task.handle.promise();
+    p.loop = this;
+    p.next = _spawned;
+    if(_spawned != nullptr)
+      _spawned->prev = &p;
+    _spawned = &p;
+    _active++;
+    _ready.push_back(task.handle);
+  }
+  /*! Resumes every ready coroutine, then if any remain incomplete waits for at least one to
+  become ready. Returns false if no coroutines remain incomplete.
+
+  If coroutines remain incomplete yet none awaits a file descriptor or timer of this loop, they
+  must await something which this loop can never resume. Rather than spinning forever, every
+  incomplete coroutine is then destroyed, so permutations fail with
+  `kerneltest_errc::kernel_stalled`.
+  */
+  bool run_once()
+  {
+    while(!_ready.empty())
+    {
+      std::coroutine_handle<> h = _ready.front();
+      _ready.pop_front();
+      h.resume();
+    }
+    if(0 == _active)
+      return false;
+    _fire_timers();
+    if(!_ready.empty())
+      return true;
+    int timeout = -1;
+    if(!_timers.empty())
+    {
+      auto wait = std::chrono::ceil<std::chrono::milliseconds>(_timers.top().deadline - std::chrono::steady_clock::now());
+      timeout = (wait.count() > 0) ? static_cast<int>(std::min<std::chrono::milliseconds::rep>(wait.count(), 60000)) : 0;
+    }
+    if(_waiting > 0 || timeout >= 0)
+    {
+      struct epoll_event events[256];
+      int n = epoll_wait(_fd, events, 256, timeout);
+      for(int i = 0; i < n; i++)
+      {
+        auto *w = static_cast<fd_waiter *>(events[i].data.ptr);
+        _waiting--;
+        _ready.push_back(w->awaiting);
+      }
+      _fire_timers();
+    }
+    else
+    {
+      while(_spawned != nullptr)
+        std::coroutine_handle<detail::detached_task::promise_type>::from_promise(*_spawned).destroy();
+      return false;
+    }
+    return true;
+  }
+  //! Executes coroutines until none remain incomplete
+  void run()
+  {
+    while(run_once())
+      ;
+  }
+};
+
+namespace detail
+{
+  inline detached_task::promise_type::~promise_type()
+  {
+    if(loop != nullptr)
+    {
+      loop->_active--;
+      if(prev != nullptr)
+        prev->next = next;
+      else
+        loop->_spawned = next;
+      if(next != nullptr)
+        next->prev = prev;
+    }
+  }
+}  // namespace detail
+#endif
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
@@ -0,0 +1,315 @@
+/* Failing permutations whose kernel times regress from a stored baseline
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "benchmark.hpp"
+#include "process_isolation.hpp"
+#include "sharding.hpp"
+
+#ifndef KERNELTEST_BASELINE_HPP
+#define KERNELTEST_BASELINE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <vector>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+/*! \brief Options for failing permutations whose kernel times regress from a stored baseline.
+
+Whilst a baseline is in use, every permutation is benchmarked (see `permute_options::benchmark`,
+whose defaults are used if it is unset). If recording, the distribution of the kernel times of
+each permutation is written to the baseline, which is a text file per table intended to be
+committed alongside the test. Otherwise a permutation whose outcome was correct fails with
+`kerneltest_errc::performance_regressed` if its median kernel time exceeds that recorded by
+more than `threshold`, and the Mann-Whitney U test finds its kernel times significantly slower.
+
+Permutations are identified by the text printed for them by `pretty_print_failure()` and the
+values of their hook parameters, so tables may be reordered or extended without invalidating
+the baseline, but kernel and hook parameters must be printable to a `std::ostream`. Tables are
+identified by their test kernel and as described by `permute_options::table_name`, so naming
+each table keeps its baseline valid when the types of its kernel or hooks change. Permutations
+without a recorded distribution, those whose outcomes are reused from the result cache, and
+those of batched or coroutine kernels are never judged.
+*/
+struct baseline_options
+{
+  //! The directory holding the baseline of each table, which is created if necessary when recording
+  std::string directory;
+  //! If true, the baseline is replaced with the kernel times of this run rather than compared against
+  bool record{false};
+  //! The fraction by which the median kernel time must exceed that recorded to regress
+  double threshold{0.1};
+  //! The slowdown must also be significant at this level
+  double significance{0.01};
+
+  /*! Returns options using the baseline directory given by the environment variable
+  `KERNELTEST_BASELINE`, if set. `record` is set if the environment variable
+  `KERNELTEST_BASELINE_RECORD` is non-zero, and `threshold` is given as a percentage by
+  `KERNELTEST_BASELINE_THRESHOLD`.
+  */
+  static optional<baseline_options> from_environment()
+  {
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4996)  // Stupid deprecation warning
+#endif
+    const char *directory = getenv("KERNELTEST_BASELINE");
+    const char *record = getenv("KERNELTEST_BASELINE_RECORD");
+    const char *threshold = getenv("KERNELTEST_BASELINE_THRESHOLD");
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+    if(directory == nullptr || directory[0] == 0)
+      return {};
+    baseline_options ret;
+    ret.directory = directory;
+    ret.record = (record != nullptr && atoi(record) != 0);
+    if(threshold != nullptr && threshold[0] != 0)
+      ret.threshold = atof(threshold) / 100;
+    return ret;
+  }
+};
+
+namespace detail
+{
+  //! The most kernel times recorded per permutation, being evenly spaced quantiles of those measured
+  static constexpr size_t baseline_samples = 32;
+  // The recorded kernel time distribution of a permutation. count is zero if none.
+  struct baseline_entry
+  {
+    uint64_t key;
+    uint32_t count;
+    int64_t ns[baseline_samples];
+  };
+  //! Evenly spaced quantiles of sorted samples, at most `baseline_samples` of them
+  inline baseline_entry baseline_quantiles(uint64_t key, std::vector<std::chrono::nanoseconds> samples)
+  {
+    baseline_entry ret{key, 0, {}};
+    if(samples.empty())
+      return ret;
+    std::sort(samples.begin(), samples.end());
+    const size_t count = std::min(samples.size(), baseline_samples);
+    for(size_t n = 0; n < count; n++)
+    {
+      const size_t at = (count > 1) ? n * (samples.size() - 1) / (count - 1) : samples.size() / 2;
+      ret.ns[n] = static_cast<int64_t>(samples[at].count());
+    }
+    ret.count = static_cast<uint32_t>(count);
+    return ret;
+  }
+  /* One sided p-value of the Mann-Whitney U test that values of b tend to exceed those of a,
+  using the normal approximation with corrections for ties and continuity.
+  */
+  inline double mann_whitney_p_value(const std::vector<int64_t> &a, const std::vector<int64_t> &b)
+  {
+    if(a.empty() || b.empty())
+      return 1;
+    std::vector<std::pair<int64_t, bool>> all;  // (value, is from b)
+    all.reserve(a.size() + b.size());
+    for(int64_t v : a)
+      all.emplace_back(v, false);
+    for(int64_t v : b)
+      all.emplace_back(v, true);
+    std::sort(all.begin(), all.end());
+    double rank_sum_b = 0, ties = 0;
+    for(size_t begin = 0; begin < all.size();)
+    {
+      size_t end = begin + 1;
+      while(end < all.size() && all[end].first == all[begin].first)
+        end++;
+      // Tied values share the average of their ranks
+      const double rank = (static_cast<double>(begin + 1) + static_cast<double>(end)) / 2, t = static_cast<double>(end - begin);
+      for(size_t i = begin; i < end; i++)
+      {
+        if(all[i].second)
+          rank_sum_b += rank;
+      }
+      ties += t * t * t - t;
+      begin = end;
+    }
+    const double na = static_cast<double>(a.size()), nb = static_cast<double>(b.size()), n = na + nb;
+    const double u = rank_sum_b - nb * (nb + 1) / 2, mean = na * nb / 2;
+    const double variance = na * nb / 12 * ((n + 1) - ties / (n * (n - 1)));
+    if(variance <= 0)
+      return 1;
+    const double z = (u - mean - 0.5) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0)) / 2;
+  }
+  inline int64_t median_of(std::vector<int64_t> v)
+  {
+    if(v.empty())
+      return 0;
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+  }
+
+  /* The kernel time distributions of the permutations of a table, being a text file with a
+  line per permutation of its key in hex, the count of kernel times, then each in nanoseconds.
+  Permutations not executed by a recording run keep their distributions, and recording merges
+  into the file whilst holding a lock upon it, so shards recording at once keep each other's.
+  */
+  class performance_baseline
+  {
+    baseline_options _options;
+    std::string _path;
+    uint64_t _salt{0};
+    std::vector<baseline_entry> _loaded;  // sorted by key
+    std::vector<uint64_t> _keys;          // of each permutation
+    std::vector<baseline_entry> _recorded;
+
+    // The distributions in the baseline file, sorted by key
+    std::vector<baseline_entry> _read() const
+    {
+      std::vector<baseline_entry> ret;
+      FILE *f = fopen(_path.c_str(), "r");
+      if(f == nullptr)
+        return ret;
+      for(bool ok = true; ok;)
+      {
+        unsigned long long key;
+        unsigned count;
+        if(2 != fscanf(f, "%llx %u", &key, &count) || count > baseline_samples)
+          break;
+        baseline_entry e{static_cast<uint64_t>(key), static_cast<uint32_t>(count), {}};
+        for(unsigned n = 0; ok && n < count; n++)
+        {
+          long long v = 0;
+          ok = (1 == fscanf(f, "%lld", &v));
+          e.ns[n] = static_cast<int64_t>(v);
+        }
+        if(ok)
+          ret.push_back(e);
+      }
+      fclose(f);
+      std::sort(ret.begin(), ret.end(), [](const baseline_entry &a, const baseline_entry &b) { return a.key < b.key; });
+      return ret;
+    }
+
+  public:
+    //! Loads the baseline of the table identified by `table`, having `size` permutations
+    performance_baseline(const baseline_options &options, const std::string &table, size_t size)
+        : _options(options)
+        , _salt(fnv1a(table.data(), table.size()))
+        , _keys(size)
+        , _recorded(options.record ? size : 0, baseline_entry{0, 0, {}})
+    {
+      char name[32];
+      snprintf(name, sizeof(name), "%016llx.ktbaseline", static_cast<unsigned long long>(_salt));
+      _path = (filesystem::path(options.directory) / name).string();
+      _loaded = _read();
+    }
+    const baseline_options &options() const noexcept { return _options; }
+    //! Sets the key of permutation idx from the text printed for it
+    void describe(size_t idx, const std::string &description) noexcept { _keys[idx] = fnv1a(description.data(), description.size(), _salt); }
+    //! The recorded distribution of permutation idx, or null if there is none
+    const baseline_entry *find(size_t idx) const noexcept
+    {
+      auto it = std::lower_bound(_loaded.begin(), _loaded.end(), _keys[idx], [](const baseline_entry &a, uint64_t b) { return a.key < b; });
+      return (it == _loaded.end() || it->key != _keys[idx] || 0 == it->count) ? nullptr : &*it;
+    }
+    //! The distribution to record for permutation idx from its kernel times
+    baseline_entry summarise(size_t idx, const std::vector<std::chrono::nanoseconds> &samples) const { return baseline_quantiles(_keys[idx], samples); }
+    //! Records the distribution of permutation idx. Concurrent calls must be for different permutations.
+    void record(size_t idx, const baseline_entry &e) noexcept
+    {
+      if(idx < _recorded.size())
+        _recorded[idx] = e;
+    }
+    //! The distribution recorded for permutation idx this run, whose count is zero if none was
+    baseline_entry recorded(size_t idx) const noexcept { return (idx < _recorded.size()) ? _recorded[idx] : baseline_entry{0, 0, {}}; }
+    /*! True if the kernel times of permutation idx regressed from those recorded, setting
+    ratio to that of the medians and p to the significance of the slowdown.
+    */
+    bool regressed(size_t idx, const std::vector<std::chrono::nanoseconds> &samples, double &ratio, double &p) const
+    {
+      const baseline_entry *e = find(idx);
+      if(e == nullptr || samples.empty())
+        return false;
+      const std::vector<int64_t> before(e->ns, e->ns + e->count);
+      std::vector<int64_t> after;
+      after.reserve(samples.size());
+      for(auto v : samples)
+        after.push_back(static_cast<int64_t>(v.count()));
+      const int64_t median = median_of(before);
+      ratio = (median > 0) ? static_cast<double>(median_of(after)) / static_cast<double>(median) : 1;
+      p = mann_whitney_p_value(before, after);
+      return ratio > 1 + _options.threshold && p < _options.significance;
+    }
+    /*! Writes the distributions recorded this run, and for permutations not executed, those
+    since saved by another process (e.g. another shard) or else those loaded.
+    */
+    result<void> save() const
+    {
+      auto by_key = [](const baseline_entry &a, const baseline_entry &b) { return a.key < b.key; };
+      std::vector<baseline_entry> entries;
+      for(const auto &e : _recorded)
+      {
+        if(e.count > 0)
+          entries.push_back(e);
+      }
+      std::sort(entries.begin(), entries.end(), by_key);
+      std::error_code ec;
+      filesystem::create_directories(_options.directory, ec);
+      // Serialise with other processes recording this table, so none discards the distributions of another
+      file_lock lock;
+      OUTCOME_TRYV(lock.lock(_path));
+      const size_t recorded = entries.size();
+      for(const std::vector<baseline_entry> &others : {_read(), _loaded})
+      {
+        for(const auto &e : others)
+        {
+          if(!std::binary_search(entries.begin(), entries.begin() + recorded, e, by_key))
+            entries.push_back(e);
+        }
+      }
+      // The first of each key is the most recent, being recorded, else saved, else loaded
+      std::stable_sort(entries.begin(), entries.end(), by_key);
+      entries.erase(std::unique(entries.begin(), entries.end(), [](const baseline_entry &a, const baseline_entry &b) { return a.key == b.key; }), entries.end());
+      return replace_file(_path, "w",
+                          [&](FILE *f)
+                          {
+                            bool ok = true;
+                            for(const auto &e : entries)
+                            {
+                              ok = ok && fprintf(f, "%016llx %u", static_cast<unsigned long long>(e.key), static_cast<unsigned>(e.count)) > 0;
+                              for(uint32_t n = 0; n < e.count; n++)
+                                ok = ok && fprintf(f, " %lld", static_cast<long long>(e.ns[n])) > 0;
+                              ok = ok && fputc('\n', f) != EOF;
+                            }
+                            return ok;
+                          });
+    }
+  };
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
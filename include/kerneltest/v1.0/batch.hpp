@@ -0,0 +1,163 @@
+/* Invoking test kernels upon batches of permutations at once
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+
+#ifndef KERNELTEST_BATCH_HPP
+#define KERNELTEST_BATCH_HPP
+
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+/*! \class parameter_batch
+\brief The kernel parameters of a batch of permutations, as passed to a `batched_kernel`.
+
+If every parameter type is default constructible and copy assignable, the parameters are
+stored column wise, with `column<I>()` returning the Ith parameter of every permutation in the
+batch contiguously, which suits SIMD across permutations. Otherwise only `get<I>(n)` is
+available.
+*/
+template <class Parameters> class parameter_batch;
+template <class... Types> class parameter_batch<parameters<Types...>>
+{
+public:
+  //! True if the parameters are stored column wise
+  static constexpr bool is_columnar = ((std::is_default_constructible<Types>::value && std::is_copy_assignable<Types>::value) && ... && true);
+  //! The type of the Ith parameter
+  template <size_t I> using element_type = typename std::tuple_element<I, std::tuple<Types...>>::type;
+
+private:
+  using columns_type = std::tuple<std::unique_ptr<Types[]>...>;
+  using rows_type = std::vector<parameters<Types...>>;
+  std::conditional_t<is_columnar, columns_type, rows_type> _storage;
+  std::vector<size_t> _indices;
+
+  template <size_t... Idxs> void _assign(size_t n, const parameters<Types...> &row, std::index_sequence<Idxs...>)
+  {
+    ((std::get<Idxs>(_storage)[n] = std::get<Idxs>(row)), ...);
+  }
+
+public:
+  //! Constructs an empty batch able to hold `capacity` permutations
+  explicit parameter_batch(size_t capacity)
+  {
+    if constexpr(is_columnar)
+      _storage = columns_type(std::unique_ptr<Types[]>(new Types[capacity])...);
+    else
+      _storage.reserve(capacity);
+    _indices.reserve(capacity);
+  }
+
+  //! The number of permutations in the batch
+  size_t size() const noexcept { return _indices.size(); }
+  //! True if the batch is empty
+  bool empty() const noexcept { return _indices.empty(); }
+  //! The index within the parameter sequence of each permutation in the batch
+  span<const size_t> indices() const noexcept { return span<const size_t>(_indices.data(), _indices.size()); }
+  //! The Ith parameter of every permutation in the batch
+  template <size_t I, bool _ = is_columnar, typename std::enable_if<_, bool>::type = true> span<const element_type<I>> column() const noexcept
+  {
+    return span<const element_type<I>>(std::get<I>(_storage).get(), _indices.size());
+  }
+  //! The Ith parameter of the nth permutation in the batch
+  template <size_t I> const element_type<I> &get(size_t n) const noexcept
+  {
+    if constexpr(is_columnar)
+      return std::get<I>(_storage)[n];
+    else
+      return std::get<I>(_storage[n]);
+  }
+
+  //! Empties the batch
+  void clear() noexcept
+  {
+    if constexpr(!is_columnar)
+      _storage.clear();
+    _indices.clear();
+  }
+  //! Appends the parameters of permutation `idx`. The batch must not be full.
+  void push_back(size_t idx, const parameters<Types...> &row)
+  {
+    if constexpr(is_columnar)
+      _assign(_indices.size(), row, std::index_sequence_for<Types...>());
+    else
+      _storage.push_back(row);
+    _indices.push_back(idx);
+  }
+};
+
+/*! \brief A test kernel executing many permutations per call, as returned by `batched()`.
+
+The kernel is called as `f(const parameter_batch<parameters<Types...>> &batch, span<optional<Outcome>> outcomes)`,
+and assigns the outcome of the nth permutation of the batch to `outcomes[n]`. Outcomes left
+unassigned fail with `kerneltest_errc::outcome_unassigned`. This removes the cost of
+instantiating hooks, calling the kernel and handling exceptions per permutation, which can
+exceed that of tiny kernels. Batched kernels cannot be used with hooks, and `capture_signals`,
+`isolation`, `timeout` and `benchmark` are ignored for them. If the kernel throws, every
+permutation of the batch fails with `kerneltest_errc::kernel_exception_thrown`. The kernel time
+of each permutation is that of its batch divided by the batch's size.
+*/
+template <class F> struct batched_kernel
+{
+  //! The kernel
+  F f;
+  //! The most permutations per call of the kernel, with zero meaning one
+  size_t size;
+};
+
+//! Wraps `f` as a kernel executing up to `size` permutations per call (see `batched_kernel`)
+template <class F> inline batched_kernel<std::decay_t<F>> batched(F &&f, size_t size = 256)
+{
+  return batched_kernel<std::decay_t<F>>{std::forward<F>(f), (size > 0) ? size : 1};
+}
+
+namespace detail
+{
+  template <class T> struct is_batched_kernel : std::false_type
+  {
+  };
+  template <class F> struct is_batched_kernel<batched_kernel<F>> : std::true_type
+  {
+  };
+  template <bool IsBatched, class Callable, class OutcomeType, class... Types> struct kernel_call_result_impl
+  {
+    using type = decltype(std::declval<Callable>()(std::declval<Types>()...));
+  };
+  template <class Callable, class OutcomeType, class... Types> struct kernel_call_result_impl<true, Callable, OutcomeType, Types...>
+  {
+    using type = OutcomeType;
+  };
+  //! What calling a kernel upon the kernel parameters of a permutation of OutcomeType returns
+  template <class Callable, class OutcomeType, class... Types>
+  using kernel_call_result = kernel_call_result_impl<is_batched_kernel<std::decay_t<Callable>>::value, Callable, OutcomeType, Types...>;
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
@@ -0,0 +1,161 @@
+/* Statistical benchmarking of test kernels
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+
+#ifndef KERNELTEST_BENCHMARK_HPP
+#define KERNELTEST_BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ostream>
+#include <vector>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+//! Options controlling how each permutation is benchmarked (see `bench_permute_parameters()`)
+struct benchmark_options
+{
+  //! Repetitions executed and discarded before measurement begins
+  size_t warmup{3};
+  //! The minimum number of measured repetitions before convergence is checked
+  size_t min_repetitions{10};
+  //! The maximum number of measured repetitions
+  size_t max_repetitions{1000000};
+  //! Stop once the 95% confidence interval on the median is within this fraction of the median
+  double relative_precision{0.01};
+  //! Stop once this much time has been spent measuring a permutation
+  std::chrono::nanoseconds max_time{std::chrono::seconds(1)};
+};
+
+//! The distribution of the kernel times of an individual permutation when benchmarked
+struct benchmark_statistics
+{
+  size_t repetitions{0};                     //!< The number of measured repetitions
+  std::chrono::nanoseconds min{0};           //!< The fastest repetition
+  std::chrono::nanoseconds median{0};        //!< The median repetition
+  std::chrono::nanoseconds p90{0};           //!< The 90th percentile repetition
+  std::chrono::nanoseconds p99{0};           //!< The 99th percentile repetition
+  std::chrono::nanoseconds mad{0};           //!< The median absolute deviation from the median
+  std::chrono::nanoseconds median_error{0};  //!< Half the width of the 95% confidence interval on the median
+  bool converged{false};                     //!< True if `benchmark_options::relative_precision` was reached
+};
+
+//! Prints a benchmark_statistics
+inline std::ostream &operator<<(std::ostream &s, const benchmark_statistics &v)
+{
+  return s << "min " << v.min.count() << "ns, median " << v.median.count() << " +/- " << v.median_error.count() << "ns, p90 " << v.p90.count() << "ns, p99 "
+           << v.p99.count() << "ns, mad " << v.mad.count() << "ns (" << v.repetitions << " repetitions" << (v.converged ? "" : ", did not converge") << ")";
+}
+
+namespace detail
+{
+  // Nearest rank percentile of sorted samples
+  inline std::chrono::nanoseconds percentile(const std::vector<std::chrono::nanoseconds> &sorted, double p) noexcept
+  {
+    size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+    return sorted[(rank > 0) ? rank - 1 : 0];
+  }
+  /* Distribution free 95% confidence interval on the median of sorted samples, using the
+  normal approximation to the binomial distribution for the ranks bounding it.
+  */
+  inline std::chrono::nanoseconds median_error(const std::vector<std::chrono::nanoseconds> &sorted) noexcept
+  {
+    const double n = static_cast<double>(sorted.size()), spread = 1.96 * std::sqrt(n) / 2;
+    double lo = std::floor(n / 2 - spread), hi = std::ceil(n / 2 + spread);
+    size_t lower = (lo < 0) ? 0 : static_cast<size_t>(lo), upper = (hi >= n) ? sorted.size() - 1 : static_cast<size_t>(hi);
+    return (sorted[upper] - sorted[lower]) / 2;
+  }
+  // Summarises the samples, which are reordered
+  inline benchmark_statistics summarise_samples(std::vector<std::chrono::nanoseconds> &samples, const benchmark_options &opts)
+  {
+    benchmark_statistics ret;
+    if(samples.empty())
+      return ret;
+    std::sort(samples.begin(), samples.end());
+    ret.repetitions = samples.size();
+    ret.min = samples.front();
+    ret.median = percentile(samples, 0.5);
+    ret.p90 = percentile(samples, 0.9);
+    ret.p99 = percentile(samples, 0.99);
+    ret.median_error = median_error(samples);
+    ret.converged = samples.size() >= opts.min_repetitions && ret.median_error.count() <= opts.relative_precision * ret.median.count();
+    for(auto &i : samples)
+      i = (i > ret.median) ? i - ret.median : ret.median - i;
+    std::sort(samples.begin(), samples.end());
+    ret.mad = percentile(samples, 0.5);
+    return ret;
+  }
+  //! True if the 95% confidence interval on the median of samples is within `opts.relative_precision` of it
+  inline bool has_converged(const std::vector<std::chrono::nanoseconds> &samples, const benchmark_options &opts)
+  {
+    if(samples.empty())
+      return false;
+    std::vector<std::chrono::nanoseconds> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    return median_error(sorted).count() <= opts.relative_precision * percentile(sorted, 0.5).count();
+  }
+  /* Calls f() until opts say to stop, where f() executes one repetition and returns the time it
+  took, and converged(samples) says whether the samples so far have converged. The time cap
+  takes precedence over the minimum repetitions. Convergence is only checked whenever the sample
+  count grows by a quarter to keep the cost of sorting amortised. If kept is set, it receives
+  the measured times in order of measurement.
+  */
+  template <class F, class Converged>
+  benchmark_statistics benchmark_until(const benchmark_options &opts, F &&f, Converged &&converged, std::vector<std::chrono::nanoseconds> *kept = nullptr)
+  {
+    for(size_t n = 0; n < opts.warmup; n++)
+      f();
+    std::vector<std::chrono::nanoseconds> samples;
+    samples.reserve(std::min<size_t>(opts.max_repetitions, 1024));
+    const auto begin = std::chrono::steady_clock::now();
+    size_t next_check = opts.min_repetitions;
+    while(samples.size() < opts.max_repetitions)
+    {
+      samples.push_back(f());
+      if(std::chrono::steady_clock::now() - begin >= opts.max_time)
+        break;
+      if(samples.size() >= next_check)
+      {
+        if(converged(static_cast<const std::vector<std::chrono::nanoseconds> &>(samples)))
+          break;
+        next_check = samples.size() + samples.size() / 4 + 1;
+      }
+    }
+    if(kept != nullptr)
+      *kept = samples;
+    return summarise_samples(samples, opts);
+  }
+  //! As benchmark_until(), stopping once the times returned by f() have converged
+  template <class F> benchmark_statistics benchmark(const benchmark_options &opts, F &&f, std::vector<std::chrono::nanoseconds> *kept = nullptr)
+  {
+    return benchmark_until(
+    opts, std::forward<F>(f), [&opts](const std::vector<std::chrono::nanoseconds> &samples) { return has_converged(samples, opts); }, kept);
+  }
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
@@ -90,6 +90,11 @@ KERNELTEST_V1_NAMESPACE_END
 KERNELTEST_V1_NAMESPACE_BEGIN
 namespace filesystem = std::filesystem;
 KERNELTEST_V1_NAMESPACE_END
+// Bring in a span implementation
+#include "quickcpplib/span.hpp"
+KERNELTEST_V1_NAMESPACE_BEGIN
+template <class T> using span = QUICKCPPLIB_NAMESPACE::span::span<T>;
+KERNELTEST_V1_NAMESPACE_END
 
 
 // Configure KERNELTEST_DECL
@@ -294,6 +299,22 @@ enum class kerneltest_errc
   kernel_signal_thrown = 13,    //!< A signal was thrown during the kernel execution
   teardown_signal_thrown = 14,  //!< A signal was thrown during the kernel teardown
 
+  permutation_skipped = 16,       //!< The permutation was not executed because the permuter was cancelled
+  permutation_not_executed = 17,  //!< The isolated child process claiming the permutation died before beginning it
+
+  setup_timed_out = 20,     //!< The permutation's deadline expired during the kernel hook setup
+  kernel_timed_out = 21,    //!< The permutation's deadline expired during the kernel execution
+  teardown_timed_out = 22,  //!< The permutation's deadline expired during the kernel teardown
+  kernel_stalled = 23,      //!< A coroutine kernel awaited something its event loop could never resume
+
+  shard_results_invalid = 24,     //!< A shard results file was malformed, or was for a different table
+  shard_results_incomplete = 25,  //!< Merged shard results did not cover every permutation exactly once
+
+  performance_regressed = 28,      //!< The kernel time regressed from that recorded in the baseline
+  allocations_exceeded = 29,       //!< The kernel allocated beyond the limits of hooks::bounded_allocations
+  outcome_unassigned = 30,         //!< A batched kernel did not assign the outcome of a permutation
+  outcome_not_transportable = 31,  //!< The outcome value of an isolated or sharded permutation was not trivially copyable
+
   filesystem_setup_internal_failure = 256,  //!< hooks::filesystem_setup failed during setup or teardown
   filesystem_comparison_internal_failure,   //!< hooks::filesystem_comparison failed during setup or teardown
   filesystem_comparison_failed              //!< hooks::filesystem_comparison found workspaces differed
@@ -331,6 +352,34 @@ namespace detail
     case kerneltest_errc::teardown_signal_thrown:
       return "signal thrown during kernel teardown";
 
+    case kerneltest_errc::permutation_skipped:
+      return "permutation skipped";
+    case kerneltest_errc::permutation_not_executed:
+      return "permutation not executed";
+
+    case kerneltest_errc::setup_timed_out:
+      return "timed out during kernel setup";
+    case kerneltest_errc::kernel_timed_out:
+      return "timed out during kernel execution";
+    case kerneltest_errc::teardown_timed_out:
+      return "timed out during kernel teardown";
+    case kerneltest_errc::kernel_stalled:
+      return "coroutine kernel stalled awaiting something its event loop could never resume";
+
+    case kerneltest_errc::shard_results_invalid:
+      return "shard results file invalid";
+    case kerneltest_errc::shard_results_incomplete:
+      return "shard results incomplete";
+
+    case kerneltest_errc::performance_regressed:
+      return "kernel time regressed from the baseline";
+    case kerneltest_errc::allocations_exceeded:
+      return "kernel allocations exceeded their limits";
+    case kerneltest_errc::outcome_unassigned:
+      return "batched kernel did not assign the outcome";
+    case kerneltest_errc::outcome_not_transportable:
+      return "outcome value not trivially copyable so could not be transported";
+
     case kerneltest_errc::filesystem_setup_internal_failure:
       return "filesystem_setup internal failure";
     case kerneltest_errc::filesystem_comparison_internal_failure:
@@ -0,0 +1,289 @@
+/* Counting hardware and software performance events during test kernels
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+
+#ifndef KERNELTEST_COUNTERS_HPP
+#define KERNELTEST_COUNTERS_HPP
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+/*! \brief The performance events counted by the calling thread during a test kernel.
+
+Each member is -1 if it could not be counted. Hardware counters are read using
+`perf_event_open()`, which containers and `/proc/sys/kernel/perf_event_paranoid` often forbid.
+The software counters then fall back to `getrusage(RUSAGE_THREAD)`, whose resolution is far
+coarser. Only implemented on Linux.
+*/
+struct performance_counters
+{
+  int64_t cycles{-1};            //!< CPU cycles
+  int64_t instructions{-1};      //!< Instructions retired
+  int64_t cache_misses{-1};      //!< Last level cache misses
+  int64_t branch_misses{-1};     //!< Mispredicted branches
+  int64_t task_clock{-1};        //!< Nanoseconds of CPU time consumed
+  int64_t page_faults{-1};       //!< Page faults, both minor and major
+  int64_t context_switches{-1};  //!< Context switches, both voluntary and involuntary
+
+  //! True if any event was counted
+  bool any() const noexcept
+  {
+    return cycles >= 0 || instructions >= 0 || cache_misses >= 0 || branch_misses >= 0 || task_clock >= 0 || page_faults >= 0 || context_switches >= 0;
+  }
+};
+
+//! Prints the events of a performance_counters which were counted
+inline std::ostream &operator<<(std::ostream &s, const performance_counters &v)
+{
+  const char *separator = "";
+  auto field = [&](const char *name, int64_t value, const char *units)
+  {
+    if(value >= 0)
+    {
+      s << separator << name << " " << value << units;
+      separator = ", ";
+    }
+  };
+  field("cycles", v.cycles, "");
+  field("instructions", v.instructions, "");
+  if(v.cycles > 0 && v.instructions >= 0)
+    s << " (IPC " << static_cast<double>(v.instructions) / static_cast<double>(v.cycles) << ")";
+  field("cache misses", v.cache_misses, "");
+  field("branch misses", v.branch_misses, "");
+  field("task clock", v.task_clock, "ns");
+  field("page faults", v.page_faults, "");
+  field("context switches", v.context_switches, "");
+  if(!v.any())
+    s << "no counters available";
+  return s;
+}
+
+/*! Sums the counters of every permutation which counted each event. Each event is -1 if no
+permutation counted it.
+\param statistics A sequence of `permutation_statistics`, as filled by the permuter
+*/
+template <class Sequence> inline performance_counters total_counters(const Sequence &statistics)
+{
+  performance_counters ret;
+  auto add = [](int64_t &total, int64_t v)
+  {
+    if(v >= 0)
+      total = (total < 0) ? v : total + v;
+  };
+  for(const auto &i : statistics)
+  {
+    add(ret.cycles, i.counters.cycles);
+    add(ret.instructions, i.counters.instructions);
+    add(ret.cache_misses, i.counters.cache_misses);
+    add(ret.branch_misses, i.counters.branch_misses);
+    add(ret.task_clock, i.counters.task_clock);
+    add(ret.page_faults, i.counters.page_faults);
+    add(ret.context_switches, i.counters.context_switches);
+  }
+  return ret;
+}
+
+namespace detail
+{
+#ifdef __linux__
+  // A counter to open within a perf_counter_group
+  struct perf_counter_spec
+  {
+    uint32_t type;
+    uint64_t config;
+    int64_t performance_counters::*member;
+  };
+  /* Counters of the calling thread read together with a single syscall. Counters which cannot
+  be opened are left out, so the group may be empty.
+  */
+  class perf_counter_group
+  {
+    int _leader{-1};
+    std::vector<int> _fds;
+    std::vector<int64_t performance_counters::*> _members;  // in group order
+    std::vector<uint64_t> _begin, _end, _buffer;
+    bool _started{false};
+
+    static int _open(const perf_counter_spec &spec, int leader)
+    {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = spec.type;
+      attr.config = spec.config;
+      attr.read_format = PERF_FORMAT_GROUP;
+      int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader, PERF_FLAG_FD_CLOEXEC));
+      if(fd < 0 && (EACCES == errno || EPERM == errno) && PERF_TYPE_HARDWARE == spec.type)
+      {
+        /* Unprivileged processes may usually still count hardware events in user space. Not
+        software events, as faults and context switches are taken within the kernel.
+        */
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader, PERF_FLAG_FD_CLOEXEC));
+      }
+      return fd;
+    }
+    bool _read(uint64_t *out)
+    {
+      const ssize_t bytes = read(_leader, _buffer.data(), _buffer.size() * sizeof(uint64_t));
+      if(bytes != static_cast<ssize_t>(_buffer.size() * sizeof(uint64_t)) || _buffer[0] != _fds.size())
+        return false;
+      memcpy(out, _buffer.data() + 1, _fds.size() * sizeof(uint64_t));
+      return true;
+    }
+
+  public:
+    explicit perf_counter_group(std::initializer_list<perf_counter_spec> specs)
+    {
+      for(const perf_counter_spec &spec : specs)
+      {
+        const int fd = _open(spec, _leader);
+        if(fd < 0)
+          continue;
+        if(_leader < 0)
+          _leader = fd;
+        _fds.push_back(fd);
+        _members.push_back(spec.member);
+      }
+      _begin.resize(_fds.size());
+      _end.resize(_fds.size());
+      _buffer.resize(1 + _fds.size());
+    }
+    perf_counter_group(const perf_counter_group &) = delete;
+    perf_counter_group &operator=(const perf_counter_group &) = delete;
+    ~perf_counter_group()
+    {
+      // Members must be closed before their leader
+      for(size_t n = _fds.size(); n > 0; n--)
+        ::close(_fds[n - 1]);
+    }
+    bool is_valid() const noexcept { return _leader >= 0; }
+    void start() { _started = is_valid() && _read(_begin.data()); }
+    //! Sets the members of out counted since start(), returning false if none were
+    bool stop(performance_counters &out)
+    {
+      if(!_started)
+        return false;
+      _started = false;
+      if(!_read(_end.data()))
+        return false;
+      for(size_t n = 0; n < _members.size(); n++)
+        out.*_members[n] = static_cast<int64_t>(_end[n] - _begin[n]);
+      return true;
+    }
+  };
+#endif
+  /* The performance counters of the calling thread, opened upon first use. They are reopened
+  within forked child processes, as those inherited would count the parent's thread.
+  */
+  class thread_counters
+  {
+#ifdef __linux__
+    pid_t _pid{0};
+    std::unique_ptr<perf_counter_group> _hardware, _software;
+#ifdef RUSAGE_THREAD
+    struct rusage _usage;
+    bool _usage_started{false};
+#endif
+
+    void _open()
+    {
+      if(_pid == getpid())
+        return;
+      _pid = getpid();
+      _hardware.reset(new perf_counter_group{{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, &performance_counters::cycles},
+                                             {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, &performance_counters::instructions},
+                                             {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, &performance_counters::cache_misses},
+                                             {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, &performance_counters::branch_misses}});
+      // Led by a counted event, as members led by the timer based task clock may never count
+      _software.reset(new perf_counter_group{{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, &performance_counters::page_faults},
+                                             {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, &performance_counters::context_switches},
+                                             {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, &performance_counters::task_clock}});
+    }
+#endif
+
+  public:
+    //! Begins counting
+    void start()
+    {
+#ifdef __linux__
+      _open();
+#ifdef RUSAGE_THREAD
+      _usage_started = !_software->is_valid() && 0 == getrusage(RUSAGE_THREAD, &_usage);
+#endif
+      _software->start();
+      _hardware->start();
+#endif
+    }
+    //! Returns the events counted since start()
+    performance_counters stop()
+    {
+      performance_counters ret;
+#ifdef __linux__
+      if(_pid != getpid())
+        return ret;
+      _hardware->stop(ret);
+      _software->stop(ret);
+#ifdef RUSAGE_THREAD
+      struct rusage now;
+      if(_usage_started && 0 == getrusage(RUSAGE_THREAD, &now))
+      {
+        auto ns = [](const struct timeval &tv) { return static_cast<int64_t>(tv.tv_sec) * 1000000000 + static_cast<int64_t>(tv.tv_usec) * 1000; };
+        ret.task_clock = ns(now.ru_utime) + ns(now.ru_stime) - ns(_usage.ru_utime) - ns(_usage.ru_stime);
+        ret.page_faults = (now.ru_minflt + now.ru_majflt) - (_usage.ru_minflt + _usage.ru_majflt);
+        ret.context_switches = (now.ru_nvcsw + now.ru_nivcsw) - (_usage.ru_nvcsw + _usage.ru_nivcsw);
+      }
+      _usage_started = false;
+#endif
+#endif
+      return ret;
+    }
+  };
+  inline thread_counters &this_thread_counters()
+  {
+    // Not QUICKCPPLIB_THREAD_LOCAL, which may be __thread and so cannot hold a type with a destructor
+    static thread_local thread_counters v;
+    return v;
+  }
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
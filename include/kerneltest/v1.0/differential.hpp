@@ -0,0 +1,146 @@
+/* Comparing two implementations of a test kernel over the same permutations
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "benchmark.hpp"
+
+#ifndef KERNELTEST_DIFFERENTIAL_HPP
+#define KERNELTEST_DIFFERENTIAL_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+//! Options controlling `parameter_permuter::differential()`
+struct differential_options
+{
+  /*! How many times each permutation is repeated. Repetition stops once the kernel times of
+  both kernels have converged, or a limit is reached.
+  */
+  benchmark_options benchmark;
+  //! A speedup is significant if the probability of a difference as large arising by chance is below this
+  double significance{0.05};
+};
+
+//! How the kernel times of the two kernels of a permutation compared
+struct differential_statistics
+{
+  benchmark_statistics a;  //!< The kernel time distribution of the first kernel
+  benchmark_statistics b;  //!< The kernel time distribution of the second kernel
+  //! The median kernel time of the first kernel divided by that of the second, so above one if the second is faster
+  double speedup{0};
+  //! The two sided probability of the kernel times differing at least this much by chance, by the Wilcoxon signed rank test
+  double p_value{1};
+  //! True if `p_value` is below `differential_options::significance`
+  bool significant{false};
+};
+
+//! Prints a differential_statistics
+inline std::ostream &operator<<(std::ostream &s, const differential_statistics &v)
+{
+  return s << "speedup " << v.speedup << "x, p = " << v.p_value << (v.significant ? "" : " (not significant)") << ", median " << v.a.median.count() << "ns => "
+           << v.b.median.count() << "ns (" << v.a.repetitions << " repetitions)";
+}
+
+/*! \brief The outcomes of the two kernels of a permutation executed by `parameter_permuter::differential()`
+\tparam A The type returned by the first kernel
+\tparam B The type returned by the second kernel
+*/
+template <class A, class B> struct differential_result
+{
+  //! The outcome of the first kernel
+  optional<A> a;
+  //! The outcome of the second kernel
+  optional<B> b;
+  //! True if the two outcomes compare equal
+  bool agree{false};
+  //! How the kernel times of the two kernels compared
+  differential_statistics timing;
+};
+
+namespace detail
+{
+  /* Two sided p-value of the Wilcoxon signed rank test upon paired samples, using the normal
+  approximation with corrections for ties and continuity. Pairs which are equal are dropped.
+  */
+  inline double signed_rank_p_value(const std::vector<std::chrono::nanoseconds> &a, const std::vector<std::chrono::nanoseconds> &b)
+  {
+    std::vector<std::pair<int64_t, bool>> differences;  // (magnitude, is positive)
+    differences.reserve(a.size());
+    for(size_t n = 0; n < a.size() && n < b.size(); n++)
+    {
+      const int64_t d = static_cast<int64_t>(a[n].count() - b[n].count());
+      if(d != 0)
+        differences.emplace_back((d < 0) ? -d : d, d > 0);
+    }
+    if(differences.empty())
+      return 1;
+    std::sort(differences.begin(), differences.end());
+    const double n = static_cast<double>(differences.size());
+    double positive = 0, ties = 0;
+    for(size_t begin = 0; begin < differences.size();)
+    {
+      size_t end = begin + 1;
+      while(end < differences.size() && differences[end].first == differences[begin].first)
+        end++;
+      // Tied magnitudes share the average of their ranks
+      const double rank = (static_cast<double>(begin + 1) + static_cast<double>(end)) / 2, t = static_cast<double>(end - begin);
+      for(size_t i = begin; i < end; i++)
+      {
+        if(differences[i].second)
+          positive += rank;
+      }
+      ties += t * t * t - t;
+      begin = end;
+    }
+    const double mean = n * (n + 1) / 4, variance = n * (n + 1) * (2 * n + 1) / 24 - ties / 48;
+    if(variance <= 0)
+      return 1;
+    const double z = std::max(std::fabs(positive - mean) - 0.5, 0.0) / std::sqrt(variance);
+    return std::erfc(z / std::sqrt(2.0));
+  }
+  // Summarises paired kernel times
+  inline differential_statistics summarise_differential(std::vector<std::chrono::nanoseconds> &a, std::vector<std::chrono::nanoseconds> &b,
+                                                        const differential_options &opts)
+  {
+    differential_statistics ret;
+    ret.p_value = signed_rank_p_value(a, b);
+    ret.significant = ret.p_value < opts.significance;
+    ret.a = summarise_samples(a, opts.benchmark);
+    ret.b = summarise_samples(b, opts.benchmark);
+    if(ret.b.median.count() > 0)
+      ret.speedup = static_cast<double>(ret.a.median.count()) / static_cast<double>(ret.b.median.count());
+    return ret;
+  }
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
@@ -0,0 +1,434 @@
+/* A persistent work stealing executor for permuters
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "placement.hpp"
+
+#ifndef KERNELTEST_EXECUTOR_HPP
+#define KERNELTEST_EXECUTOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4324)  // structure was padded due to alignment specifier
+#endif
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+class permutation_executor;
+
+namespace detail
+{
+  //! The executor whose worker is the calling thread, if any
+  inline permutation_executor *&this_thread_executor() noexcept
+  {
+    static QUICKCPPLIB_THREAD_LOCAL permutation_executor *v;
+    return v;
+  }
+  // A contiguous range of positions owned by a worker. Other workers steal from its back.
+  struct alignas(64) executor_range
+  {
+    std::mutex lock;
+    size_t begin{0}, end{0};
+  };
+  // A type erased run() call being executed by the workers
+  struct executor_job
+  {
+    void *self{nullptr};
+    void (*call)(void *self, size_t pos, size_t worker){nullptr};
+    void (*enter)(void *self, bool entering){nullptr};
+    std::unique_ptr<executor_range[]> ranges;
+    size_t workers{0}, grain{1}, count{0};
+    bool in_order{false};  // if set, ranges are unused and positions are claimed from next
+    std::atomic<size_t> next{0};
+    std::mutex exception_lock;
+    std::exception_ptr exception;
+  };
+}  // namespace detail
+
+/*! \class permutation_executor
+\brief A persistent pool of worker threads executing permutations using work stealing.
+
+Each call to `run()` divides the positions to be executed into one contiguous range per
+worker. Each worker consumes its own range from the front, and once it is exhausted steals
+the back half of whichever other worker has the most remaining. Permutations taking wildly
+differing amounts of time therefore still keep every worker busy.
+
+The worker threads persist across calls to `run()`, and thus across permuters and test kernels.
+For the duration of each `run()`, every worker sees a copy of the calling thread's
+`current_test_kernel`. Workers may be pinned to CPUs (see `worker_placement_options`).
+
+A worker stuck in a call which will never return can be abandoned (see `abandon()`), whereupon
+a new worker takes its place and the `run()` completes without it.
+*/
+class permutation_executor
+{
+  std::mutex _run_lock;  // serialises run(), set_concurrency() and set_placement()
+  std::mutex _lock;      // protects everything below
+  std::condition_variable _wake, _done;
+  std::vector<std::thread> _threads;
+  std::vector<std::shared_ptr<std::atomic<bool>>> _abandoned;  // set once the worker of the same index is abandoned
+  std::atomic<size_t> _concurrency{0};  // _threads.size(), readable whilst it is being changed
+  worker_placement_options _placement;
+  size_t _generation{0}, _busy{0};
+  bool _shutdown{false};
+  detail::executor_job *_job{nullptr};
+
+  size_t _default_concurrency() const
+  {
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4996)  // Stupid deprecation warning
+#endif
+    const char *env = getenv("KERNELTEST_CONCURRENCY");
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+    if(env != nullptr)
+    {
+      long v = strtol(env, nullptr, 10);
+      if(v > 0)
+        return static_cast<size_t>(v);
+    }
+    size_t ret = std::thread::hardware_concurrency();
+    if(placement_policy::physical_cores == _placement.policy && detail::physical_core_count() > 0)
+      ret = detail::physical_core_count();
+    else if(placement_policy::cpus == _placement.policy)
+      ret = _placement.cpus.size();
+    return (ret > 0) ? ret : 1;
+  }
+  void _start(size_t workers)
+  {
+    if(0 == workers)
+      workers = _default_concurrency();
+    _shutdown = false;
+    const std::vector<int> cpus = detail::placement_cpus(_placement, workers);
+    _threads.reserve(workers);
+    _abandoned.reserve(workers);
+    for(size_t n = 0; n < workers; n++)
+    {
+      _abandoned.push_back(std::make_shared<std::atomic<bool>>(false));
+      _threads.push_back(_spawn(n, _generation, cpus.empty() ? -1 : cpus[n]));
+    }
+    _concurrency.store(workers, std::memory_order_release);
+  }
+  // The thread keeps its own reference to its abandoned flag, as it may outlive the executor
+  std::thread _spawn(size_t no, size_t seen, int cpu)
+  {
+    return std::thread([this, no, seen, cpu, abandoned = _abandoned[no]] { _worker(no, seen, cpu, *abandoned); });
+  }
+  void _stop() noexcept
+  {
+    {
+      std::lock_guard<std::mutex> g(_lock);
+      _shutdown = true;
+    }
+    _wake.notify_all();
+    for(auto &i : _threads)
+      i.join();
+    _threads.clear();
+    _abandoned.clear();
+    _concurrency.store(0, std::memory_order_release);
+  }
+  void _worker(size_t no, size_t seen, int cpu, const std::atomic<bool> &abandoned)
+  {
+    detail::this_thread_executor() = this;
+    detail::place_worker(no, cpu, _placement.scratch_bytes);
+    std::unique_lock<std::mutex> g(_lock);
+    for(;;)
+    {
+      _wake.wait(g, [&] { return _shutdown || _generation != seen; });
+      if(_shutdown)
+        return;
+      seen = _generation;
+      detail::executor_job *job = _job;
+      g.unlock();
+      _execute(*job, no, abandoned);
+      // Another worker took over our part of the job, which may since have been destroyed along with this executor
+      if(abandoned.load(std::memory_order_acquire))
+        return;
+      g.lock();
+      if(0 == --_busy)
+        _done.notify_all();
+    }
+  }
+  // Fetch the next position for worker no, stealing if necessary. Returns false if no work remains.
+  static bool _next(detail::executor_job &job, size_t no, size_t &pos)
+  {
+    if(job.in_order)
+    {
+      pos = job.next.fetch_add(1, std::memory_order_relaxed);
+      return pos < job.count;
+    }
+    detail::executor_range &mine = job.ranges[no];
+    {
+      std::lock_guard<std::mutex> g(mine.lock);
+      if(mine.begin < mine.end)
+      {
+        pos = mine.begin++;
+        return true;
+      }
+    }
+    for(;;)
+    {
+      size_t victim = job.workers, most = 0;
+      for(size_t n = 1; n < job.workers; n++)
+      {
+        detail::executor_range &theirs = job.ranges[(no + n) % job.workers];
+        std::lock_guard<std::mutex> g(theirs.lock);
+        if(theirs.end - theirs.begin > most)
+        {
+          most = theirs.end - theirs.begin;
+          victim = (no + n) % job.workers;
+        }
+      }
+      if(victim == job.workers)
+        return false;
+      size_t begin, end;
+      {
+        detail::executor_range &theirs = job.ranges[victim];
+        std::lock_guard<std::mutex> g(theirs.lock);
+        size_t remaining = theirs.end - theirs.begin;
+        if(0 == remaining)
+          continue;  // someone else got there first
+        end = theirs.end;
+        begin = theirs.end - (remaining + 1) / 2;
+        // Split on a grain boundary if there is one after what the victim is executing
+        size_t aligned = (begin + job.grain - 1) / job.grain * job.grain;
+        if(aligned < end)
+          begin = aligned;
+        theirs.end = begin;
+      }
+      {
+        std::lock_guard<std::mutex> g(mine.lock);
+        mine.begin = begin + 1;
+        mine.end = end;
+      }
+      pos = begin;
+      return true;
+    }
+  }
+  static void _execute(detail::executor_job &job, size_t no, const std::atomic<bool> &abandoned)
+  {
+    job.enter(job.self, true);
+    auto unenter = make_scope_exit(
+    [&]() noexcept
+    {
+      if(!abandoned.load(std::memory_order_acquire))
+        job.enter(job.self, false);
+    });
+    size_t pos;
+    while(_next(job, no, pos))
+    {
+      KERNELTEST_EXCEPTION_TRY { job.call(job.self, pos, no); }
+      KERNELTEST_EXCEPTION_CATCH_ALL
+      {
+        if(abandoned.load(std::memory_order_acquire))
+          return;
+        std::lock_guard<std::mutex> g(job.exception_lock);
+        if(!job.exception)
+          job.exception = std::current_exception();
+      }
+      if(abandoned.load(std::memory_order_acquire))
+        return;
+    }
+  }
+
+public:
+  /*! Constructs an executor with `workers` worker threads placed according to `placement`.
+  Zero means the value of the environment variable `KERNELTEST_CONCURRENCY` if set, else one
+  per CPU selected by the placement policy, else `std::thread::hardware_concurrency()`.
+  */
+  explicit permutation_executor(size_t workers = 0, worker_placement_options placement = worker_placement_options::from_environment())
+      : _placement(std::move(placement))
+  {
+    _start(workers);
+  }
+  permutation_executor(const permutation_executor &) = delete;
+  permutation_executor(permutation_executor &&) = delete;
+  permutation_executor &operator=(const permutation_executor &) = delete;
+  permutation_executor &operator=(permutation_executor &&) = delete;
+  ~permutation_executor() { _stop(); }
+
+  //! The process wide executor used by multithreaded permuters unless told otherwise
+  static permutation_executor &global()
+  {
+    static permutation_executor v;
+    return v;
+  }
+
+  //! The number of worker threads. Zero whilst `set_concurrency()` or `set_placement()` is replacing them.
+  size_t concurrency() const noexcept { return _concurrency.load(std::memory_order_acquire); }
+  //! Changes the number of worker threads, with zero meaning the default. Blocks until any `run()` in progress completes.
+  void set_concurrency(size_t workers)
+  {
+    std::lock_guard<std::mutex> g(_run_lock);
+    _stop();
+    _start(workers);
+  }
+  //! The placement of the worker threads
+  const worker_placement_options &placement() const noexcept { return _placement; }
+  //! Changes the placement of the worker threads, keeping their number. Blocks until any `run()` in progress completes.
+  void set_placement(worker_placement_options placement)
+  {
+    std::lock_guard<std::mutex> g(_run_lock);
+    const size_t workers = _threads.size();
+    _stop();
+    _placement = std::move(placement);
+    _start(workers);
+  }
+  /*! The scratch memory of the calling worker thread, which was first touched by that worker
+  after it was pinned (see `worker_placement_options::scratch_bytes`). Null if the calling
+  thread is not a worker or has no scratch memory.
+  */
+  static char *worker_scratch() noexcept { return detail::this_thread_scratch().data.get(); }
+  //! The size of the calling worker thread's scratch memory
+  static size_t worker_scratch_size() noexcept { return detail::this_thread_scratch().bytes; }
+
+  /*! Calls `f(pos, worker)` for every `pos` in `[0, count)` across the worker threads,
+  returning when all have completed. `worker` is the index of the executing worker in
+  `[0, concurrency())`. If called from one of this executor's own workers, executes
+  `f` serially on the calling thread instead.
+
+  Where possible, work is divided between workers on multiples of `grain` so that workers
+  writing adjacent outputs do not share cache lines.
+  \throws anything The first exception thrown by any call of `f`, after all calls have completed.
+  */
+  template <class F> void run(size_t count, F &&f, size_t grain = 1) { _run(count, std::forward<F>(f), grain, false); }
+  /*! As `run()`, but every worker claims the lowest position not yet begun whenever it becomes
+  free, so positions begin in ascending order. Sorting work longest first and executing it with
+  this approximates an optimal schedule, at the cost of contention upon a shared counter.
+  */
+  template <class F> void run_in_order(size_t count, F &&f) { _run(count, std::forward<F>(f), 1, true); }
+
+  /*! Abandons the worker thread `id`, which must be stuck within a call of `f` by `run()` or
+  `run_in_order()`, replacing it with a new worker which continues executing the rest of the
+  `run()` in its place. The `run()` therefore returns without waiting for the call to return.
+  The abandoned thread is detached, and should the call ever return, the thread exits without
+  touching the executor or the `run()` again. It is up to `f` to not touch anything which may
+  be gone by then.
+  \return False if `id` is not a worker of this executor executing a `run()`.
+  */
+  bool abandon(std::thread::id id)
+  {
+    std::lock_guard<std::mutex> g(_lock);
+    if(_job == nullptr || _shutdown)
+      return false;
+    for(size_t n = 0; n < _threads.size(); n++)
+    {
+      if(_threads[n].get_id() == id)
+      {
+        _abandoned[n]->store(true, std::memory_order_release);
+        _threads[n].detach();
+        _abandoned[n] = std::make_shared<std::atomic<bool>>(false);
+        const std::vector<int> cpus = detail::placement_cpus(_placement, _threads.size());
+        // The new worker joins the job in progress, and accounts for its part of it
+        _threads[n] = _spawn(n, _generation - 1, cpus.empty() ? -1 : cpus[n]);
+        return true;
+      }
+    }
+    return false;
+  }
+
+private:
+  template <class F> void _run(size_t count, F &&f, size_t grain, bool in_order)
+  {
+    if(0 == count)
+      return;
+    auto serial = [&]
+    {
+      for(size_t pos = 0; pos < count; pos++)
+        f(pos, 0);
+    };
+    if(detail::this_thread_executor() == this)
+      return serial();
+    std::lock_guard<std::mutex> rg(_run_lock);
+    if(_threads.size() < 2 || 1 == count)
+      return serial();
+    // These are instantiated in the caller's translation unit, so they see the same current_test_kernel
+    struct state
+    {
+      F &f;
+      current_test_kernel_t test_kernel;
+      static void call(void *self, size_t pos, size_t worker) { static_cast<state *>(self)->f(pos, worker); }
+      static void enter(void *self, bool entering)
+      {
+        if(entering)
+          current_test_kernel = static_cast<state *>(self)->test_kernel;
+        else
+          current_test_kernel = current_test_kernel_t{};
+      }
+    } s{f, current_test_kernel};
+    detail::executor_job job;
+    job.self = &s;
+    job.call = &state::call;
+    job.enter = &state::enter;
+    job.workers = _threads.size();
+    job.grain = (grain > 0) ? grain : 1;
+    job.count = count;
+    job.in_order = in_order;
+    job.ranges.reset(new detail::executor_range[job.workers]);
+    const size_t grains = (count + job.grain - 1) / job.grain;
+    for(size_t n = 0, begin = 0; n < job.workers; n++)
+    {
+      if(in_order)
+        break;
+      size_t len = (grains / job.workers + ((n < grains % job.workers) ? 1 : 0)) * job.grain;
+      job.ranges[n].begin = std::min(begin, count);
+      job.ranges[n].end = std::min(begin + len, count);
+      begin += len;
+    }
+    {
+      std::unique_lock<std::mutex> g(_lock);
+      _job = &job;
+      _busy = job.workers;
+      ++_generation;
+      _wake.notify_all();
+      _done.wait(g, [&] { return 0 == _busy; });
+      _job = nullptr;
+    }
+#ifdef __cpp_exceptions
+    if(job.exception)
+      std::rethrow_exception(job.exception);
+#endif
+  }
+};
+
+KERNELTEST_V1_NAMESPACE_END
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#endif
@@ -0,0 +1,112 @@
+/* Kernel test hooks bounding the heap allocations of test kernels
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../config.hpp"
+#include "../allocations.hpp"
+
+#ifndef KERNELTEST_HOOKS_ALLOCATIONS_HPP
+#define KERNELTEST_HOOKS_ALLOCATIONS_HPP
+
+#include <sstream>
+#include <string>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+namespace hooks
+{
+  namespace bounded_allocations_impl
+  {
+    template <class RetType> struct impl
+    {
+      RetType *testret;
+      size_t idx;
+      allocation_limits limits;
+      impl(RetType &_testret, size_t _idx, allocation_limits _limits) noexcept
+          : testret(&_testret)
+          , idx(_idx)
+          , limits(_limits)
+      {
+      }
+      impl(impl &&o) noexcept
+          : testret(o.testret)
+          , idx(o.idx)
+          , limits(o.limits)
+      {
+        o.testret = nullptr;
+      }
+      impl(const impl &) = delete;
+      ~impl()
+      {
+        // Only check the kernel if it passed, by which time its allocations have been recorded
+        if(testret != nullptr && *testret && (*testret)->has_value())
+        {
+          const allocation_statistics &seen = detail::last_kernel_allocations();
+          if(!seen.tracked)
+          {
+            KERNELTEST_CERR("FATAL: hooks::bounded_allocations requires KERNELTEST_TRACK_ALLOCATIONS() or KERNELTEST_TRACK_MALLOC() to be expanded in one source file." << std::endl);
+            std::terminate();
+          }
+          if(!limits.permits(seen))
+          {
+            KERNELTEST_CERR("WARNING: Permutation " << (idx + 1) << " made " << seen << ", exceeding " << limits << std::endl);
+            *testret = RetType(typename RetType::value_type::error_type(make_error_code(kerneltest_errc::allocations_exceeded)));
+          }
+        }
+      }
+    };
+    // Instantiated during permuter construction
+    struct inst
+    {
+      //! Tells the permuter to track the allocations of each kernel even if `permute_options::allocations` is false
+      static constexpr bool tracks_allocations = true;
+
+      // Called at the beginning of an individual test. Returns object destroyed at the end of an individual test.
+      template <class Parent, class RetType> impl<RetType> operator()(Parent *, RetType &testret, size_t idx, allocation_limits limits) const
+      {
+        return impl<RetType>(testret, idx, limits);
+      }
+      std::string print(allocation_limits limits) const
+      {
+        std::stringstream s;
+        s << "postcondition " << limits;
+        return s.str();
+      }
+    };
+  }  // namespace bounded_allocations_impl
+  //! The parameters for the bounded_allocations hook
+  using bounded_allocations_parameters = parameters<allocation_limits>;
+  /*! Kernel test hook failing permutations whose kernel allocated beyond the limits given by the
+  parameter, for example `allocation_limits{0}` for a kernel which must not allocate. Only
+  allocations by the thread calling the kernel are seen. If the kernel passed and exceeded its
+  limits, the permutation fails with `kerneltest_errc::allocations_exceeded`.
+
+  Requires `KERNELTEST_TRACK_ALLOCATIONS()` or `KERNELTEST_TRACK_MALLOC()` to be expanded in one
+  source file of the program.
+  */
+  inline bounded_allocations_impl::inst bounded_allocations() { return bounded_allocations_impl::inst{}; }
+}  // namespace hooks
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
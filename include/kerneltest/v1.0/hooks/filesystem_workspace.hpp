@@ -32,10 +32,15 @@ Distributed under the Boost Software License, Version 1.0.
 
 #include <fstream>
 #include <mutex>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #ifdef _WIN32
 #include <winioctl.h>  // for FSCTL_GET_REPARSE_POINT
+#else
+#include <sys/stat.h>
 #endif
 
 KERNELTEST_V1_NAMESPACE_BEGIN
@@ -233,9 +238,47 @@ namespace hooks
       }
     }
 
+    // The names of the workspaces in existence, so several upon one thread get different names
+    struct workspace_names
+    {
+      std::mutex lock;
+      std::unordered_set<std::string> names;
+    };
+    inline workspace_names &workspace_names_in_use()
+    {
+      static workspace_names v;
+      return v;
+    }
+
     template <bool is_throwing, class Parent, class RetType> struct impl
     {
-      filesystem::path _current;
+      /* What an item in the workspace was when the workspace was last synchronised with its template.
+      On POSIX the inode and status change time are also compared, as a kernel may replace an item
+      or rewrite its contents while preserving its size and modification time. The status change
+      time of a directory changes with its entries, which are compared themselves, so it is ignored.
+      */
+      struct item_state
+      {
+        filesystem::file_type type{filesystem::file_type::none};
+        uintmax_t size{0};
+        filesystem::file_time_type modified{};
+#ifndef _WIN32
+        dev_t device{0};
+        ino_t inode{0};
+        mode_t mode{0};
+        int64_t changed{0};  // nanoseconds
+#endif
+        bool operator==(const item_state &o) const noexcept
+        {
+          return type == o.type && size == o.size && modified == o.modified
+#ifndef _WIN32
+                 && device == o.device && inode == o.inode && mode == o.mode && changed == o.changed
+#endif
+          ;
+        }
+      };
+      filesystem::path _current, _template;
+      std::unordered_map<filesystem::path, item_state, path_hasher> _snapshot;
 
       void _remove_workspace()  // noexcept(!is_throwing)
       {
@@ -257,11 +300,171 @@ namespace hooks
         std::terminate();
       }
 
+      /* Copies the contents of srcdir into destdir. If only_missing, items already in destdir
+      are kept, with directories being merged.
+      */
+      static void _copy_level(const filesystem::path &srcdir, const filesystem::path &destdir, std::error_code &ec, bool only_missing = false)
+      {
+        for(filesystem::directory_iterator it(srcdir); it != filesystem::directory_iterator(); ++it)
+        {
+          if(only_missing && !filesystem::is_directory(it->symlink_status()))
+          {
+            std::error_code ec2;
+            if(filesystem::exists(filesystem::symlink_status(destdir / it->path().filename(), ec2)))
+              continue;
+          }
+#ifdef _WIN32
+          typedef struct _REPARSE_DATA_BUFFER  // NOLINT
+          {
+            ULONG ReparseTag;
+            USHORT ReparseDataLength;
+            USHORT Reserved;
+            union
+            {
+              struct
+              {
+                USHORT SubstituteNameOffset;
+                USHORT SubstituteNameLength;
+                USHORT PrintNameOffset;
+                USHORT PrintNameLength;
+                ULONG Flags;
+                WCHAR PathBuffer[1];
+              } SymbolicLinkReparseBuffer;
+              struct
+              {
+                USHORT SubstituteNameOffset;
+                USHORT SubstituteNameLength;
+                USHORT PrintNameOffset;
+                USHORT PrintNameLength;
+                WCHAR PathBuffer[1];
+              } MountPointReparseBuffer;
+              struct
+              {
+                UCHAR DataBuffer[1];
+              } GenericReparseBuffer;
+            };
+          } REPARSE_DATA_BUFFER, *PREPARSE_DATA_BUFFER;
+          bool is_symlink = false;
+          HANDLE h = CreateFileW(it->path().c_str(), SYNCHRONIZE | FILE_READ_ATTRIBUTES | STANDARD_RIGHTS_READ,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+                                 FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT, NULL);
+          if(h == INVALID_HANDLE_VALUE)
+          {
+            ec = std::error_code(GetLastError(), std::system_category());
+            return;
+          }
+          TCHAR buffer[32769];
+          auto *rpd = (REPARSE_DATA_BUFFER *) buffer;
+          DWORD read = 0, written = 0;
+          if(DeviceIoControl(h, FSCTL_GET_REPARSE_POINT, NULL, 0, rpd, (DWORD) sizeof(buffer), &read, NULL))
+          {
+            is_symlink = true;
+            CloseHandle(h);
+            auto destpath = destdir / it->path().filename();
+            h = CreateFileW(destpath.c_str(), SYNCHRONIZE | FILE_READ_ATTRIBUTES | STANDARD_RIGHTS_READ | FILE_WRITE_ATTRIBUTES | STANDARD_RIGHTS_WRITE,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_ALWAYS, 0, NULL);
+            if(h == INVALID_HANDLE_VALUE)
+            {
+              ec = std::error_code(GetLastError(), std::system_category());
+              return;
+            }
+            if(!DeviceIoControl(h, FSCTL_SET_REPARSE_POINT, rpd, read, NULL, 0, &written, NULL))
+            {
+              ec = std::error_code(GetLastError(), std::system_category());
+              CloseHandle(h);
+              return;
+            }
+          }
+          CloseHandle(h);
+          if(is_symlink)
+            continue;
+#else
+          if(filesystem::is_symlink(it->status()))
+          {
+            filesystem::copy_symlink(it->path(), destdir / it->path().filename(), ec);
+            if(ec)
+              return;
+          }
+#endif
+          else if(filesystem::is_directory(it->status()))
+          {
+            filesystem::create_directory(destdir / it->path().filename(), ec);
+            ec.clear();
+            _copy_level(it->path(), destdir / it->path().filename(), ec, only_missing);
+            if(ec)
+              return;
+          }
+          else if(filesystem::is_regular_file(it->status()))
+          {
+            filesystem::copy_file(it->path(), destdir / it->path().filename(), ec);
+            if(ec)
+              return;
+          }
+        }
+      }
+
+      static item_state _state_of(const filesystem::directory_entry &item)
+      {
+        item_state ret;
+        std::error_code ec;
+        ret.type = item.symlink_status(ec).type();
+        if(filesystem::file_type::regular == ret.type)
+        {
+          ret.size = item.file_size(ec);
+          ret.modified = item.last_write_time(ec);
+        }
+#ifndef _WIN32
+        struct stat s;
+        if(0 == ::lstat(item.path().c_str(), &s))
+        {
+          ret.device = s.st_dev;
+          ret.inode = s.st_ino;
+          ret.mode = s.st_mode;
+          if(filesystem::file_type::directory != ret.type)
+          {
+#ifdef __APPLE__
+            ret.changed = static_cast<int64_t>(s.st_ctimespec.tv_sec) * 1000000000 + s.st_ctimespec.tv_nsec;
+#else
+            ret.changed = static_cast<int64_t>(s.st_ctim.tv_sec) * 1000000000 + s.st_ctim.tv_nsec;
+#endif
+          }
+        }
+#endif
+        return ret;
+      }
+      void _take_snapshot()
+      {
+        _snapshot.clear();
+        std::error_code ec;
+        for(filesystem::recursive_directory_iterator it(_current, ec), end; !ec && it != end; it.increment(ec))
+          _snapshot[it->path().lexically_relative(_current)] = _state_of(*it);
+      }
+      void _enter()
+      {
+        // Set the working directory to the configured workspace
+        filesystem::current_path(_current);
+        current_test_kernel.working_directory = _current.c_str();
+      }
+      void _leave()
+      {
+        current_test_kernel.working_directory = nullptr;
+        filesystem::current_path(starting_path());
+      }
+
       impl(Parent *, RetType &, size_t, filesystem::path &&workspace)  // noexcept(!is_throwing)
       {
-        auto template_path = workspace_template_path<is_throwing>(workspace);
-        // Make the workspace we choose unique to this thread
-        _current = starting_path() / ("kerneltest_workspace_" + std::to_string(QUICKCPPLIB_NAMESPACE::utils::thread::this_thread_id()));
+        _template = workspace_template_path<is_throwing>(workspace);
+        const filesystem::path &template_path = _template;
+        // Make the workspace we choose unique to this thread, and to this instance if the thread has several
+        {
+          const std::string base = "kerneltest_workspace_" + std::to_string(QUICKCPPLIB_NAMESPACE::utils::thread::this_thread_id());
+          auto &in_use = workspace_names_in_use();
+          std::lock_guard<std::mutex> g(in_use.lock);
+          std::string name = base;
+          for(size_t n = 1; !in_use.names.insert(name).second; n++)
+            name = base + "_" + std::to_string(n);
+          _current = starting_path() / name;
+        }
         // Clear out any stale workspace with the same name at this path just in case
         _remove_workspace();
 
@@ -291,115 +494,17 @@ namespace hooks
           auto begin = std::chrono::steady_clock::now();
           do
           {
-            // VS2017 still doesn't understand symlinks :(, so copy in the starting filesystem environment by hand
-            struct _
-            {
-              static void copy_level(const filesystem::path &srcdir, const filesystem::path &destdir, std::error_code &ec)
-              {
-                for(filesystem::directory_iterator it(srcdir); it != filesystem::directory_iterator(); ++it)
-                {
-#ifdef _WIN32
-                  typedef struct _REPARSE_DATA_BUFFER  // NOLINT
-                  {
-                    ULONG ReparseTag;
-                    USHORT ReparseDataLength;
-                    USHORT Reserved;
-                    union
-                    {
-                      struct
-                      {
-                        USHORT SubstituteNameOffset;
-                        USHORT SubstituteNameLength;
-                        USHORT PrintNameOffset;
-                        USHORT PrintNameLength;
-                        ULONG Flags;
-                        WCHAR PathBuffer[1];
-                      } SymbolicLinkReparseBuffer;
-                      struct
-                      {
-                        USHORT SubstituteNameOffset;
-                        USHORT SubstituteNameLength;
-                        USHORT PrintNameOffset;
-                        USHORT PrintNameLength;
-                        WCHAR PathBuffer[1];
-                      } MountPointReparseBuffer;
-                      struct
-                      {
-                        UCHAR DataBuffer[1];
-                      } GenericReparseBuffer;
-                    };
-                  } REPARSE_DATA_BUFFER, *PREPARSE_DATA_BUFFER;
-                  bool is_symlink = false;
-                  HANDLE h = CreateFileW(it->path().c_str(), SYNCHRONIZE | FILE_READ_ATTRIBUTES | STANDARD_RIGHTS_READ,
-                                         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
-                                         FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OPEN_REPARSE_POINT, NULL);
-                  if(h == INVALID_HANDLE_VALUE)
-                  {
-                    ec = std::error_code(GetLastError(), std::system_category());
-                    return;
-                  }
-                  TCHAR buffer[32769];
-                  auto *rpd = (REPARSE_DATA_BUFFER *) buffer;
-                  DWORD read = 0, written = 0;
-                  if(DeviceIoControl(h, FSCTL_GET_REPARSE_POINT, NULL, 0, rpd, (DWORD) sizeof(buffer), &read, NULL))
-                  {
-                    is_symlink = true;
-                    CloseHandle(h);
-                    auto destpath = destdir / it->path().filename();
-                    h = CreateFileW(destpath.c_str(), SYNCHRONIZE | FILE_READ_ATTRIBUTES | STANDARD_RIGHTS_READ | FILE_WRITE_ATTRIBUTES | STANDARD_RIGHTS_WRITE,
-                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_ALWAYS, 0, NULL);
-                    if(h == INVALID_HANDLE_VALUE)
-                    {
-                      ec = std::error_code(GetLastError(), std::system_category());
-                      return;
-                    }
-                    if(!DeviceIoControl(h, FSCTL_SET_REPARSE_POINT, rpd, read, NULL, 0, &written, NULL))
-                    {
-                      ec = std::error_code(GetLastError(), std::system_category());
-                      CloseHandle(h);
-                      return;
-                    }
-                  }
-                  CloseHandle(h);
-                  if(is_symlink)
-                    continue;
-#else
-                  if(filesystem::is_symlink(it->status()))
-                  {
-                    filesystem::copy_symlink(it->path(), destdir / it->path().filename(), ec);
-                    if(ec)
-                      return;
-                  }
-#endif
-                  else if(filesystem::is_directory(it->status()))
-                  {
-                    filesystem::create_directory(destdir / it->path().filename(), ec);
-                    ec.clear();
-                    copy_level(it->path(), destdir / it->path().filename(), ec);
-                    if(ec)
-                      return;
-                  }
-                  else if(filesystem::is_regular_file(it->status()))
-                  {
-                    filesystem::copy_file(it->path(), destdir / it->path().filename(), ec);
-                    if(ec)
-                      return;
-                  }
-                }
-              }
-            };
             filesystem::create_directory(_current, ec);
             ec.clear();
-            _::copy_level(template_path, _current, ec);
+            _copy_level(template_path, _current, ec);
             if(!ec)
               break;
           } while(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - begin).count() < 5);
           if(ec)
             fatalexit();
         }
-        // Set the working directory to the newly configured workspace
-        filesystem::current_path(_current);
-        current_test_kernel.working_directory = _current.c_str();
+        _take_snapshot();
+        _enter();
       }
       constexpr impl(impl &&) noexcept = default;
       impl(const impl &) = delete;
@@ -407,14 +512,79 @@ namespace hooks
       {
         if(!_current.empty())
         {
-          current_test_kernel.working_directory = nullptr;
-          filesystem::current_path(starting_path());
+          _leave();
           _remove_workspace();
+          auto &in_use = workspace_names_in_use();
+          std::lock_guard<std::mutex> g(in_use.lock);
+          in_use.names.erase(_current.filename().string());
+        }
+      }
+      /*! Reuses the workspace for another permutation with the same precondition. Only what the
+      previous permutation changed is removed, and only what it changed or removed is copied
+      again from the template, which is far cheaper than recreating the workspace.
+      */
+      void reset(Parent *, RetType &, size_t)  // noexcept(!is_throwing)
+      {
+        std::error_code ec;
+        auto fatalexit = [&]
+        {
+#ifdef __cpp_exceptions
+          if(is_throwing)
+            throw std::system_error(ec);
+#endif
+          KERNELTEST_CERR("FATAL: Couldn't resynchronise " << _current << " with " << _template << " due to " << ec.message() << std::endl);
+          std::terminate();
+        };
+        if(!filesystem::is_directory(filesystem::symlink_status(_current, ec)))
+        {
+          filesystem::remove_all(_current, ec);
+          filesystem::create_directory(_current, ec);
+          if(ec)
+            fatalexit();
         }
+        // Remove everything which differs from the last synchronisation
+        std::vector<filesystem::path> stale;
+        size_t unchanged = 0;
+        for(filesystem::recursive_directory_iterator it(_current, ec), end; !ec && it != end; it.increment(ec))
+        {
+          auto found = _snapshot.find(it->path().lexically_relative(_current));
+          if(found != _snapshot.end() && found->second == _state_of(*it))
+            unchanged++;
+          else
+          {
+            stale.push_back(it->path());
+            it.disable_recursion_pending();
+          }
+        }
+        if(ec)
+          fatalexit();
+        for(auto &i : stale)
+        {
+          filesystem::remove_all(i, ec);
+          if(ec)
+            fatalexit();
+        }
+        // Restore everything which was changed or removed
+        if(!stale.empty() || unchanged != _snapshot.size())
+        {
+          if(filesystem::exists(_template, ec))
+          {
+            _copy_level(_template, _current, ec, true);
+            if(ec)
+              fatalexit();
+          }
+          _take_snapshot();
+        }
+        _enter();
       }
+      //! Changes the working directory back to `starting_path()` while the workspace awaits reuse
+      void release() { _leave(); }
     };
     template <bool is_throwing> struct inst
     {
+      //! Tells the permuter to reuse workspaces between permutations with the same precondition
+      static constexpr bool is_resettable = true;
+
       const char *workspacebase;
       template <class Parent, class RetType> auto operator()(Parent *parent, RetType &testret, size_t idx, const char *workspace) const
       {
@@ -437,6 +607,9 @@ namespace hooks
   \return A type which when called configures the workspace and changes the working directory to that
   workspace, and on destruction deletes the workspace and changes the working directory back to `starting_path()`.
   `current_test_kernel.working_directory` is also set to the working directory.
+  The hook is resettable: permuters reuse each workspace for later permutations with the same
+  precondition upon the same worker, removing only what each permutation changed. The working
+  directory is still changed back to `starting_path()` after each permutation.
   \param workspacebase A path fragment inside `test/tests` of the base of the workspaces to choose from.
   */
   template <bool is_throwing = false> constexpr inline auto filesystem_setup(const char *workspacebase = current_test_kernel.test)
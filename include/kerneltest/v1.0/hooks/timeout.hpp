@@ -0,0 +1,74 @@
+/* Timeout test kernel hooks
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "../config.hpp"
+#include "../watchdog.hpp"
+
+#ifndef KERNELTEST_HOOKS_TIMEOUT_HPP
+#define KERNELTEST_HOOKS_TIMEOUT_HPP
+
+#include <chrono>
+#include <string>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+namespace hooks
+{
+  namespace timeout_impl
+  {
+    struct impl
+    {
+    };
+    // Instantiated during permuter construction
+    struct inst
+    {
+      //! Tells the permuter to watch permutations even if `permute_options::timeout` is zero
+      static constexpr bool sets_permutation_deadline = true;
+
+      // Called at the beginning of an individual test. Returns object destroyed at the end of an individual test.
+      template <class Parent, class RetType> impl operator()(Parent *, RetType &, size_t, std::chrono::nanoseconds timeout) const
+      {
+        detail::set_permutation_deadline(timeout);
+        return impl{};
+      }
+      std::string print(std::chrono::nanoseconds timeout) const
+      {
+        return "timeout " + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count()) + "ms";
+      }
+    };
+  }  // namespace timeout_impl
+  //! The parameters for the timeout hook
+  using timeout_parameters = parameters<std::chrono::nanoseconds>;
+  /*! Kernel test hook overriding `permute_options::timeout` for each permutation.
+  The deadline of the permutation is set to the timeout parameter from when the hook is constructed,
+  so hooks constructed before it count towards the permuter's timeout, and those after towards this one.
+  If the deadline expires, the permutation fails with `kerneltest_errc::*_timed_out`. As with
+  `permute_options::timeout`, the permutations are executed isolated so that they can be killed.
+  */
+  inline timeout_impl::inst timeout() { return timeout_impl::inst{}; }
+}  // namespace hooks
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
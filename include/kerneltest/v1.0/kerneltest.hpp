@@ -57,10 +57,30 @@ import KERNELTEST_MODULE_NAME;
 
 #include "test_kernel.hpp"
 
+#include "benchmark.hpp"
+#include "counters.hpp"
+#include "allocations.hpp"
+#include "placement.hpp"
+#include "executor.hpp"
+#include "parameter_generators.hpp"
+#include "permutation_results.hpp"
+#include "signal_capture.hpp"
+#include "watchdog.hpp"
+#include "process_isolation.hpp"
+#include "async_kernel.hpp"
+#include "baseline.hpp"
+#include "batch.hpp"
+#include "differential.hpp"
+#include "sharding.hpp"
+#include "result_cache.hpp"
+#include "schedule.hpp"
 #include "permute_parameters.hpp"
+#include "reporters.hpp"
 #include "child_process.hpp"
 
+#include "hooks/allocations.hpp"
 #include "hooks/custom.hpp"
 #include "hooks/filesystem_workspace.hpp"
+#include "hooks/timeout.hpp"
 
 #endif
@@ -0,0 +1,584 @@
+/* Lazily generated sequences of parameter sets
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+
+#ifndef KERNELTEST_PARAMETER_GENERATORS_HPP
+#define KERNELTEST_PARAMETER_GENERATORS_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+/*! \class power_set
+\brief A dimension of values consisting of every combination of some flags, e.g. of a `QUICKCPPLIB_BITFIELD`.
+
+Element `n` is the bitwise OR of every flag whose index is set in `n`, so element zero is a
+default constructed (i.e. empty) `T`. Only the flags are stored, the combinations are computed
+on demand.
+*/
+template <class T> class power_set
+{
+  std::vector<T> _flags;
+
+  void _check_size() const
+  {
+    if(_flags.size() >= std::numeric_limits<size_t>::digits)
+#ifdef __cpp_exceptions
+      throw std::length_error("power set has too many flags for its size to be representable");
+#else
+      abort();
+#endif
+  }
+
+public:
+  //! The type of an individual combination of flags
+  using value_type = T;
+
+  /*! Constructs the power set of `flags`. There must be fewer flags than bits in `size_t`, else
+  `std::length_error` is thrown.
+  */
+  power_set(std::initializer_list<T> flags)
+      : _flags(flags)
+  {
+    _check_size();
+  }
+  //! \overload
+  explicit power_set(std::vector<T> flags)
+      : _flags(std::move(flags))
+  {
+    _check_size();
+  }
+
+  //! The number of combinations, which is two to the power of the number of flags
+  size_t size() const noexcept { return static_cast<size_t>(1) << _flags.size(); }
+  //! The combination of flags at `idx`
+  T operator[](size_t idx) const
+  {
+    T ret{};
+    for(size_t n = 0; n < _flags.size(); n++)
+    {
+      if(idx & (static_cast<size_t>(1) << n))
+        ret |= _flags[n];
+    }
+    return ret;
+  }
+};
+
+namespace detail
+{
+  template <class Sequence> class generated_sequence_iterator
+  {
+    const Sequence *_parent{nullptr};
+    size_t _idx{0};
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = typename Sequence::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    constexpr generated_sequence_iterator() = default;
+    constexpr generated_sequence_iterator(const Sequence *parent, size_t idx)
+        : _parent(parent)
+        , _idx(idx)
+    {
+    }
+    constexpr value_type operator*() const { return (*_parent)[_idx]; }
+    constexpr value_type operator[](difference_type n) const { return (*_parent)[_idx + n]; }
+    constexpr generated_sequence_iterator &operator++() noexcept
+    {
+      ++_idx;
+      return *this;
+    }
+    constexpr generated_sequence_iterator operator++(int) noexcept
+    {
+      auto ret(*this);
+      ++_idx;
+      return ret;
+    }
+    constexpr generated_sequence_iterator &operator--() noexcept
+    {
+      --_idx;
+      return *this;
+    }
+    constexpr generated_sequence_iterator operator--(int) noexcept
+    {
+      auto ret(*this);
+      --_idx;
+      return ret;
+    }
+    constexpr generated_sequence_iterator &operator+=(difference_type n) noexcept
+    {
+      _idx += n;
+      return *this;
+    }
+    constexpr generated_sequence_iterator &operator-=(difference_type n) noexcept
+    {
+      _idx -= n;
+      return *this;
+    }
+    constexpr generated_sequence_iterator operator+(difference_type n) const noexcept { return {_parent, _idx + n}; }
+    constexpr generated_sequence_iterator operator-(difference_type n) const noexcept { return {_parent, _idx - n}; }
+    constexpr difference_type operator-(const generated_sequence_iterator &o) const noexcept { return static_cast<difference_type>(_idx - o._idx); }
+    constexpr bool operator==(const generated_sequence_iterator &o) const noexcept { return _idx == o._idx; }
+    constexpr bool operator!=(const generated_sequence_iterator &o) const noexcept { return _idx != o._idx; }
+    constexpr bool operator<(const generated_sequence_iterator &o) const noexcept { return _idx < o._idx; }
+    constexpr bool operator>(const generated_sequence_iterator &o) const noexcept { return _idx > o._idx; }
+    constexpr bool operator<=(const generated_sequence_iterator &o) const noexcept { return _idx <= o._idx; }
+    constexpr bool operator>=(const generated_sequence_iterator &o) const noexcept { return _idx >= o._idx; }
+  };
+}  // namespace detail
+
+/*! \class cartesian_product_sequence
+\brief A random access sequence of parameter sets generated on demand from every combination of some dimensions of values.
+\tparam ValueType The type of parameter set, `parameters<OutcomeType, parameters<...>, hook parameters...>`
+\tparam F The callable generating a parameter set from one value of each dimension
+\tparam Dimensions The types of the dimensions, each having `size()` and `operator[]`
+
+Only the dimensions are stored, so memory consumption is independent of the number of
+combinations, and any parameter set can be generated from its index alone. The last
+dimension varies fastest, as it would in the equivalent nested loops.
+
+Use `cartesian_product()` to construct one.
+*/
+template <class ValueType, class F, class... Dimensions> class cartesian_product_sequence
+{
+  static_assert(sizeof...(Dimensions) > 0, "a cartesian product needs at least one dimension");
+  F _f;
+  std::tuple<Dimensions...> _dimensions;
+  size_t _size;
+
+  template <size_t... Idxs> static size_t _product(const std::tuple<Dimensions...> &dimensions, std::index_sequence<Idxs...>)
+  {
+    const size_t sizes[] = {static_cast<size_t>(std::get<Idxs>(dimensions).size())...};
+    size_t ret = 1;
+    bool overflowed = false;
+    for(size_t size : sizes)
+    {
+      if(0 == size)
+        return 0;
+      if(ret > std::numeric_limits<size_t>::max() / size)
+        overflowed = true;
+      ret *= size;
+    }
+    if(overflowed)
+#ifdef __cpp_exceptions
+      throw std::length_error("cartesian product has too many parameter sets for its size to be representable");
+#else
+      abort();
+#endif
+    return ret;
+  }
+  template <size_t... Idxs> ValueType _generate(size_t idx, std::index_sequence<Idxs...>) const
+  {
+    size_t offsets[sizeof...(Dimensions)];
+    // Decompose idx into one offset per dimension, least significant (fastest varying) last
+    (void) std::initializer_list<int>{(offsets[sizeof...(Dimensions) - 1 - Idxs] = idx % std::get<sizeof...(Dimensions) - 1 - Idxs>(_dimensions).size(),
+                                       idx /= std::get<sizeof...(Dimensions) - 1 - Idxs>(_dimensions).size(), 0)...};
+    return _f(std::get<Idxs>(_dimensions)[offsets[Idxs]]...);
+  }
+
+public:
+  //! The type of parameter set
+  using value_type = ValueType;
+  //! The type of size
+  using size_type = size_t;
+  //! A random access iterator yielding parameter sets by value
+  using const_iterator = detail::generated_sequence_iterator<cartesian_product_sequence>;
+  //! \copydoc const_iterator
+  using iterator = const_iterator;
+
+  /*! Constructs an instance. Best to use `cartesian_product()` instead. If the product of the sizes
+  of the dimensions is not representable in `size_t`, `std::length_error` is thrown.
+  */
+  cartesian_product_sequence(F f, std::tuple<Dimensions...> dimensions)
+      : _f(std::move(f))
+      , _dimensions(std::move(dimensions))
+      , _size(_product(_dimensions, std::index_sequence_for<Dimensions...>()))
+  {
+  }
+
+  //! The number of parameter sets, which is the product of the sizes of the dimensions
+  size_t size() const noexcept { return _size; }
+  //! True if any dimension is empty
+  bool empty() const noexcept { return 0 == _size; }
+  //! Generates the parameter set at `idx`
+  value_type operator[](size_t idx) const { return _generate(idx, std::index_sequence_for<Dimensions...>()); }
+
+  const_iterator begin() const noexcept { return const_iterator(this, 0); }
+  const_iterator end() const noexcept { return const_iterator(this, _size); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+};
+
+/*! \brief Makes a lazily generated sequence of parameter sets from every combination of some dimensions of values.
+\tparam ValueType The type of parameter set, `parameters<OutcomeType, parameters<...>, hook parameters...>`
+\param f A callable with callspec `ValueType(const D0 &, const D1 &, ...)` which returns the
+parameter set, including its expected outcome and any hook parameters, for one value from each dimension.
+\param dimensions Any number of dimensions, e.g. `std::vector<T>`, `std::array<T, N>` or `power_set<T>`.
+
+For example:
+\code
+using row = parameters<result<void>, parameters<mode, creation, flag>>;
+auto seq = cartesian_product<row>([](mode m, creation c, flag f) { return row{expected(m, c, f), {m, c, f}}; },
+                                  std::vector<mode>{mode::read, mode::write},
+                                  std::vector<creation>{creation::open_existing, creation::if_needed},
+                                  power_set<flag>{flag::unlink_on_close, flag::disable_safety_fsyncs});
+auto permuter = mt_permute_parameters<result<void>, parameters<mode, creation, flag>>(std::move(seq));
+\endcode
+*/
+template <class ValueType, class F, class... Dimensions>
+cartesian_product_sequence<ValueType, typename std::decay<F>::type, typename std::decay<Dimensions>::type...> cartesian_product(F &&f, Dimensions &&...dimensions)
+{
+  return cartesian_product_sequence<ValueType, typename std::decay<F>::type, typename std::decay<Dimensions>::type...>(
+  std::forward<F>(f), std::tuple<typename std::decay<Dimensions>::type...>(std::forward<Dimensions>(dimensions)...));
+}
+
+namespace detail
+{
+  template <size_t... Ns> struct cartesian_product_size;
+  template <> struct cartesian_product_size<>
+  {
+    static constexpr size_t value = 1;
+  };
+  template <size_t N, size_t... Ns> struct cartesian_product_size<N, Ns...>
+  {
+    static constexpr size_t value = N * cartesian_product_size<Ns...>::value;
+  };
+  // The offset into dimension K of the combination at idx, last dimension fastest
+  template <size_t K, size_t... Ns> constexpr size_t cartesian_product_offset(size_t idx) noexcept
+  {
+    const size_t sizes[] = {Ns...};
+    for(size_t n = sizeof...(Ns) - 1; n > K; n--)
+      idx /= sizes[n];
+    return idx % sizes[K];
+  }
+  template <class ValueType, class F, class... Ts, size_t... Ns, size_t... Ks>
+  constexpr ValueType cartesian_product_row(const F &f, size_t idx, std::index_sequence<Ks...>, const std::array<Ts, Ns> &...dimensions)
+  {
+    return f(dimensions[cartesian_product_offset<Ks, Ns...>(idx)]...);
+  }
+  template <class ValueType, class F, class... Ts, size_t... Ns, size_t... Idxs>
+  constexpr std::array<ValueType, sizeof...(Idxs)> cartesian_product_array(const F &f, std::index_sequence<Idxs...>, const std::array<Ts, Ns> &...dimensions)
+  {
+    return {{cartesian_product_row<ValueType>(f, Idxs, std::index_sequence_for<Ts...>(), dimensions...)...}};
+  }
+}  // namespace detail
+
+/*! \brief Makes a `std::array` of parameter sets from every combination of some constant sized dimensions of values.
+\tparam ValueType The type of parameter set, `parameters<OutcomeType, parameters<...>, hook parameters...>`
+\param f A callable with callspec `ValueType(const D0 &, const D1 &, ...)` which returns the
+parameter set, including its expected outcome and any hook parameters, for one value from each dimension.
+\param dimensions Any number of `std::array<T, N>` dimensions.
+
+This is the eager equivalent of `cartesian_product()` for small, enum valued dimensions. As the
+result is a `std::array`, the number of permutations is a compile time constant, available from
+permuters as `permutation_results_type_constant_size` for statically sizing buffers. The results
+themselves are heap allocated, as a `std::array` of them would overflow the stack for large
+tables. If `ValueType` is a literal type and `f` is usable in constant expressions, the table
+can be `constexpr` and costs nothing at startup:
+\code
+using row = parameters<result<int>, parameters<mode, creation>>;
+static constexpr std::array<mode, 2> modes{{mode::read, mode::write}};
+static constexpr std::array<creation, 2> creations{{creation::open_existing, creation::if_needed}};
+static constexpr auto table = cartesian_product_array<row>([](mode m, creation c) { return row{expected(m, c), {m, c}}; }, modes, creations);
+auto permuter = st_permute_parameters<result<int>, parameters<mode, creation>>(std::array<row, table.size()>(table));
+\endcode
+*/
+template <class ValueType, class F, class... Ts, size_t... Ns>
+constexpr std::array<ValueType, detail::cartesian_product_size<Ns...>::value> cartesian_product_array(const F &f, const std::array<Ts, Ns> &...dimensions)
+{
+  static_assert(sizeof...(Ns) > 0, "a cartesian product needs at least one dimension");
+  return detail::cartesian_product_array<ValueType>(f, std::make_index_sequence<detail::cartesian_product_size<Ns...>::value>(), dimensions...);
+}
+
+namespace detail
+{
+  // A small deterministic generator, so covering arrays are identical on every platform for a given seed
+  struct splitmix64
+  {
+    uint64_t state;
+    uint64_t operator()() noexcept
+    {
+      uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+    size_t operator()(size_t n) noexcept { return static_cast<size_t>((*this)() % n); }
+  };
+
+  /* Greedily builds a covering array of the given strength over dimensions of the given sizes,
+  returning the rows concatenated, each being one offset per dimension. Each row is the best of
+  a number of candidates, each of which starts from a randomly chosen uncovered tuple and then
+  assigns the remaining dimensions in random order to whichever value covers the most new tuples
+  (after Cohen et al's AETG).
+  */
+  inline std::vector<size_t> make_covering_array(const std::vector<size_t> &sizes, size_t strength, uint64_t seed)
+  {
+    static constexpr size_t candidates = 16;
+    const size_t k = sizes.size();
+    std::vector<size_t> ret;
+    if(0 == k)
+      return ret;
+    for(auto i : sizes)
+    {
+      if(0 == i)
+        return ret;
+    }
+    if(strength < 1)
+      strength = 1;
+    if(strength > k)
+      strength = k;
+    // Every combination of `strength` dimensions, and which of its tuples remain uncovered
+    struct interaction
+    {
+      std::vector<size_t> dims, strides;
+      std::vector<bool> covered;
+      size_t index(const std::vector<size_t> &row) const noexcept
+      {
+        size_t ret = 0;
+        for(size_t n = 0; n < dims.size(); n++)
+          ret += row[dims[n]] * strides[n];
+        return ret;
+      }
+    };
+    std::vector<interaction> interactions;
+    std::vector<std::vector<size_t>> interactions_of(k);
+    size_t remaining = 0;
+    {
+      std::vector<size_t> combo(strength);
+      for(size_t n = 0; n < strength; n++)
+        combo[n] = n;
+      for(;;)
+      {
+        interaction i;
+        i.dims = combo;
+        i.strides.resize(strength);
+        size_t total = 1;
+        for(size_t n = strength; n > 0; n--)
+        {
+          i.strides[n - 1] = total;
+          total *= sizes[combo[n - 1]];
+        }
+        i.covered.assign(total, false);
+        remaining += total;
+        for(auto d : combo)
+          interactions_of[d].push_back(interactions.size());
+        interactions.push_back(std::move(i));
+        // Next combination in lexicographical order
+        size_t n = strength;
+        while(n > 0 && combo[n - 1] == k - strength + n - 1)
+          n--;
+        if(0 == n)
+          break;
+        combo[n - 1]++;
+        for(size_t m = n; m < strength; m++)
+          combo[m] = combo[m - 1] + 1;
+      }
+    }
+    splitmix64 rng{seed};
+    std::vector<size_t> row(k), best(k), order;
+    std::vector<bool> assigned(k);
+    // The number of uncovered tuples row covers within the interactions of dimension d, counting only fully assigned ones
+    auto gain_of = [&](size_t d)
+    {
+      size_t ret = 0;
+      for(auto idx : interactions_of[d])
+      {
+        const interaction &i = interactions[idx];
+        bool complete = true;
+        for(auto o : i.dims)
+          complete = complete && assigned[o];
+        if(complete && !i.covered[i.index(row)])
+          ret++;
+      }
+      return ret;
+    };
+    while(remaining > 0)
+    {
+      size_t best_gain = 0;
+      for(size_t candidate = 0; candidate < candidates; candidate++)
+      {
+        std::fill(assigned.begin(), assigned.end(), false);
+        // Seed with a randomly chosen uncovered tuple
+        size_t idx = rng(interactions.size());
+        while(std::find(interactions[idx].covered.begin(), interactions[idx].covered.end(), false) == interactions[idx].covered.end())
+          idx = (idx + 1) % interactions.size();
+        const interaction &seeded = interactions[idx];
+        size_t tuple = rng(seeded.covered.size());
+        while(seeded.covered[tuple])
+          tuple = (tuple + 1) % seeded.covered.size();
+        for(size_t n = 0; n < strength; n++)
+        {
+          row[seeded.dims[n]] = (tuple / seeded.strides[n]) % sizes[seeded.dims[n]];
+          assigned[seeded.dims[n]] = true;
+        }
+        // Greedily assign the remaining dimensions in random order
+        order.clear();
+        for(size_t d = 0; d < k; d++)
+        {
+          if(!assigned[d])
+            order.push_back(d);
+        }
+        for(size_t n = order.size(); n > 1; n--)
+          std::swap(order[n - 1], order[rng(n)]);
+        for(auto d : order)
+        {
+          assigned[d] = true;
+          size_t value = 0, value_gain = 0;
+          const size_t start = rng(sizes[d]);
+          for(size_t n = 0; n < sizes[d]; n++)
+          {
+            row[d] = (start + n) % sizes[d];
+            size_t gain = gain_of(d);
+            if(0 == n || gain > value_gain)
+            {
+              value = row[d];
+              value_gain = gain;
+            }
+          }
+          row[d] = value;
+        }
+        size_t gain = 0;
+        for(auto &i : interactions)
+          gain += i.covered[i.index(row)] ? 0 : 1;
+        if(gain > best_gain)
+        {
+          best = row;
+          best_gain = gain;
+        }
+      }
+      for(auto &i : interactions)
+      {
+        size_t t = i.index(best);
+        if(!i.covered[t])
+        {
+          i.covered[t] = true;
+          remaining--;
+        }
+      }
+      ret.insert(ret.end(), best.begin(), best.end());
+    }
+    return ret;
+  }
+}  // namespace detail
+
+/*! \class covering_array_sequence
+\brief A random access sequence of parameter sets forming a t-way covering array over some dimensions of values.
+\tparam ValueType The type of parameter set, `parameters<OutcomeType, parameters<...>, hook parameters...>`
+\tparam F The callable generating a parameter set from one value of each dimension
+\tparam Dimensions The types of the dimensions, each having `size()` and `operator[]`
+
+Every combination of values of any `strength` dimensions appears in at least one parameter set,
+which needs far fewer parameter sets than `cartesian_product()` once there are more than a few
+dimensions. The covering array is computed upon construction, after which only one offset per
+dimension per parameter set is stored, and parameter sets are generated on demand. For a given
+seed the same parameter sets are generated in the same order on every platform.
+
+Use `covering_array()` or `pairwise()` to construct one.
+*/
+template <class ValueType, class F, class... Dimensions> class covering_array_sequence
+{
+  static_assert(sizeof...(Dimensions) > 0, "a covering array needs at least one dimension");
+  F _f;
+  std::tuple<Dimensions...> _dimensions;
+  std::vector<size_t> _rows;
+
+  template <size_t... Idxs> std::vector<size_t> _sizes(std::index_sequence<Idxs...>) const { return {std::get<Idxs>(_dimensions).size()...}; }
+  template <size_t... Idxs> ValueType _generate(size_t idx, std::index_sequence<Idxs...>) const
+  {
+    const size_t *offsets = _rows.data() + idx * sizeof...(Dimensions);
+    return _f(std::get<Idxs>(_dimensions)[offsets[Idxs]]...);
+  }
+
+public:
+  //! The type of parameter set
+  using value_type = ValueType;
+  //! The type of size
+  using size_type = size_t;
+  //! A random access iterator yielding parameter sets by value
+  using const_iterator = detail::generated_sequence_iterator<covering_array_sequence>;
+  //! \copydoc const_iterator
+  using iterator = const_iterator;
+
+  //! Constructs an instance. Best to use `covering_array()` or `pairwise()` instead.
+  covering_array_sequence(size_t strength, uint64_t seed, F f, std::tuple<Dimensions...> dimensions)
+      : _f(std::move(f))
+      , _dimensions(std::move(dimensions))
+      , _rows(detail::make_covering_array(_sizes(std::index_sequence_for<Dimensions...>()), strength, seed))
+  {
+  }
+
+  //! The number of parameter sets
+  size_t size() const noexcept { return _rows.size() / sizeof...(Dimensions); }
+  //! True if any dimension is empty
+  bool empty() const noexcept { return _rows.empty(); }
+  //! Generates the parameter set at `idx`
+  value_type operator[](size_t idx) const { return _generate(idx, std::index_sequence_for<Dimensions...>()); }
+
+  const_iterator begin() const noexcept { return const_iterator(this, 0); }
+  const_iterator end() const noexcept { return const_iterator(this, size()); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+};
+
+/*! \brief Makes a sequence of parameter sets covering every combination of values of any `strength` of some dimensions of values.
+\tparam ValueType The type of parameter set, `parameters<OutcomeType, parameters<...>, hook parameters...>`
+\param strength The number of dimensions whose every combination of values must appear, e.g. two for pairwise.
+\param seed The seed of the randomised greedy construction. The same seed always generates the same sequence.
+\param f A callable with callspec `ValueType(const D0 &, const D1 &, ...)` as for `cartesian_product()`.
+\param dimensions Any number of dimensions, e.g. `std::vector<T>`, `std::array<T, N>` or `power_set<T>`.
+*/
+template <class ValueType, class F, class... Dimensions>
+covering_array_sequence<ValueType, typename std::decay<F>::type, typename std::decay<Dimensions>::type...> covering_array(size_t strength, uint64_t seed, F &&f,
+                                                                                                                          Dimensions &&...dimensions)
+{
+  return covering_array_sequence<ValueType, typename std::decay<F>::type, typename std::decay<Dimensions>::type...>(
+  strength, seed, std::forward<F>(f), std::tuple<typename std::decay<Dimensions>::type...>(std::forward<Dimensions>(dimensions)...));
+}
+//! Makes a sequence of parameter sets covering every pair of values of any two dimensions (see `covering_array()`)
+template <class ValueType, class F, class... Dimensions>
+covering_array_sequence<ValueType, typename std::decay<F>::type, typename std::decay<Dimensions>::type...> pairwise(F &&f, Dimensions &&...dimensions)
+{
+  return covering_array<ValueType>(2, 0, std::forward<F>(f), std::forward<Dimensions>(dimensions)...);
+}
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
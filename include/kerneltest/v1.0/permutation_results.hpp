@@ -0,0 +1,385 @@
+/* Storage for the results of permuting a test kernel
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "parameter_generators.hpp"
+
+#ifndef KERNELTEST_PERMUTATION_RESULTS_HPP
+#define KERNELTEST_PERMUTATION_RESULTS_HPP
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+template <class T> class permutation_results;
+
+//! \brief What an individual result in a `permutation_results` holds
+enum class permutation_status : unsigned char
+{
+  absent = 0,  //!< There is no outcome
+  value,       //!< The outcome has a value, or is not a result or outcome type
+  error,       //!< The outcome has an error
+  exception    //!< The outcome has an exception
+};
+
+namespace detail
+{
+  template <class T, class = void> struct has_error_state : std::false_type
+  {
+  };
+  template <class T> struct has_error_state<T, decltype((void) std::declval<const T &>().has_error())> : std::true_type
+  {
+  };
+  template <class T, class = void> struct has_exception_state : std::false_type
+  {
+  };
+  template <class T> struct has_exception_state<T, decltype((void) std::declval<const T &>().has_exception())> : std::true_type
+  {
+  };
+  //! The status of a present outcome
+  template <class T> inline permutation_status outcome_status(const T &v) noexcept
+  {
+    if constexpr(has_exception_state<T>::value)
+    {
+      if(v.has_exception())
+        return permutation_status::exception;
+    }
+    if constexpr(has_error_state<T>::value)
+    {
+      if(v.has_error())
+        return permutation_status::error;
+    }
+    (void) v;
+    return permutation_status::value;
+  }
+}  // namespace detail
+
+/*! \class permutation_result
+\brief A read only view of an individual result in a `permutation_results`, which behaves like a `const optional<T> &`.
+*/
+template <class T> class permutation_result
+{
+protected:
+  const T *_v{nullptr};
+
+public:
+  //! The type of outcome
+  using value_type = T;
+
+  constexpr permutation_result() = default;
+  constexpr explicit permutation_result(const T *v) noexcept
+      : _v(v)
+  {
+  }
+  //! True if the permutation produced an outcome
+  constexpr bool has_value() const noexcept { return _v != nullptr; }
+  //! \copydoc has_value
+  constexpr explicit operator bool() const noexcept { return _v != nullptr; }
+  //! The outcome of the permutation
+  constexpr const T &operator*() const noexcept { return *_v; }
+  //! \copydoc operator*
+  constexpr const T *operator->() const noexcept { return _v; }
+  //! The outcome of the permutation, throwing `bad_optional_access` if there is none
+  constexpr const T &value() const
+  {
+    if(_v == nullptr)
+#ifdef __cpp_exceptions
+      throw std::bad_optional_access();
+#else
+      abort();
+#endif
+    return *_v;
+  }
+  //! The outcome of the permutation, or `v` if there is none
+  template <class U> constexpr T value_or(U &&v) const { return (_v != nullptr) ? *_v : static_cast<T>(std::forward<U>(v)); }
+  //! Copies the outcome into an `optional<T>`
+  operator optional<T>() const { return (_v != nullptr) ? optional<T>(*_v) : optional<T>(); }
+};
+
+/*! \class permutation_result_reference
+\brief A modifiable view of an individual result in a `permutation_results`, which behaves like an `optional<T> &`.
+*/
+template <class T> class permutation_result_reference : public permutation_result<T>
+{
+  permutation_results<T> *_results;
+  size_t _idx;
+  mutable bool _modifiable{false};  // if the outcome may have been modified in place, its status is refreshed upon destruction
+
+public:
+  permutation_result_reference(permutation_results<T> *results, size_t idx, T *v) noexcept
+      : permutation_result<T>(v)
+      , _results(results)
+      , _idx(idx)
+  {
+  }
+  permutation_result_reference(const permutation_result_reference &) = default;
+  ~permutation_result_reference()
+  {
+    if(_modifiable && this->_v != nullptr)
+      _results->_refresh(_idx);
+  }
+  //! Sets the outcome of the permutation to that of `o`
+  permutation_result_reference &operator=(const permutation_result_reference &o) { return *this = static_cast<optional<T>>(o); }
+  //! \overload
+  permutation_result_reference &operator=(const permutation_result<T> &o) { return *this = static_cast<optional<T>>(o); }
+  //! Sets the outcome of the permutation, which may be an `optional<T>`
+  template <class U, typename = typename std::enable_if<!std::is_base_of<permutation_result<T>, typename std::decay<U>::type>::value>::type>
+  permutation_result_reference &operator=(U &&v)
+  {
+    _results->assign(_idx, std::forward<U>(v));
+    this->_v = (*_results)[_idx].operator->();
+    return *this;
+  }
+  //! Constructs the outcome of the permutation in place
+  template <class... Args> T &emplace(Args &&...args)
+  {
+    _results->assign(_idx, T(std::forward<Args>(args)...));
+    this->_v = (*_results)[_idx].operator->();
+    return **this;
+  }
+  //! Makes the permutation have no outcome
+  void reset() noexcept
+  {
+    _results->reset(_idx);
+    this->_v = nullptr;
+  }
+  //! The outcome of the permutation
+  T &operator*() const noexcept
+  {
+    _modifiable = true;
+    return *const_cast<T *>(this->_v);
+  }
+  //! \copydoc operator*
+  T *operator->() const noexcept
+  {
+    _modifiable = true;
+    return const_cast<T *>(this->_v);
+  }
+  //! The outcome of the permutation, throwing `bad_optional_access` if there is none
+  T &value() const
+  {
+    _modifiable = true;
+    return const_cast<T &>(permutation_result<T>::value());
+  }
+};
+
+/*! \class permutation_results
+\brief The results of a `parameter_permuter`, one optional outcome per parameter set.
+
+The results are held in a single heap allocation with a struct of arrays layout, so that even
+million entry tables cannot overflow the stack. A column of status bytes records whether each
+result is absent, or holds a value, an error or an exception (see `status()`), so failures can
+be found without reading the outcomes, and a separate column holds the outcomes. Both columns are divided into chunks of
+`chunk_size` results, each of which begins on its own cache line. Multithreaded permuters
+executing permutations in index order divide the work on chunk boundaries, so no two threads
+write the same cache line. This does not hold, as adjacent results may then be written by
+different threads, when permutations are executed in some other order, i.e. when scheduled
+longest first (see `permute_options::schedule`), or when sharding, result caching or
+deduplication execute only some of them.
+
+Individual results are accessed as `permutation_result<T>`, which behaves like a
+`const optional<T> &`, or through a non-const instance as `permutation_result_reference<T>`,
+which behaves like an `optional<T> &`. Code written against the `std::vector<optional<T>>` and
+`std::array<optional<T>, N>` results of earlier versions therefore mostly compiles unchanged.
+*/
+template <class T> class permutation_results
+{
+  static_assert(alignof(T) <= 64, "outcomes must not be overaligned");
+  static constexpr size_t _cache_line = 64;
+  static constexpr size_t _round_up(size_t v) noexcept { return (v + _cache_line - 1) & ~(_cache_line - 1); }
+
+public:
+  //! The type of outcome
+  using outcome_type = T;
+  //! The type of an individual result
+  using value_type = permutation_result<T>;
+  //! The type of size
+  using size_type = size_t;
+  //! A random access iterator yielding `permutation_result<T>`
+  using const_iterator = detail::generated_sequence_iterator<permutation_results>;
+  //! \copydoc const_iterator
+  using iterator = const_iterator;
+
+  //! The number of results in each chunk, each of which is padded to a cache line boundary
+  static constexpr size_t chunk_size = 64;
+
+private:
+  static constexpr size_t _status_stride = _round_up(chunk_size);
+  static constexpr size_t _payload_stride = _round_up(chunk_size * sizeof(T));
+
+  size_t _size{0};
+  unsigned char *_status{nullptr};  // start of the arena, each byte being a permutation_status
+  unsigned char *_payload{nullptr};
+
+  friend class permutation_result_reference<T>;
+
+  T *_at(size_t idx) const noexcept { return reinterpret_cast<T *>(_payload + (idx / chunk_size) * _payload_stride + (idx % chunk_size) * sizeof(T)); }
+  unsigned char &_status_at(size_t idx) const noexcept { return _status[(idx / chunk_size) * _status_stride + (idx % chunk_size)]; }
+  // Updates the status of a present outcome which may have been modified in place
+  void _refresh(size_t idx) noexcept
+  {
+    if(_status_at(idx) != 0)
+      _status_at(idx) = static_cast<unsigned char>(detail::outcome_status(*_at(idx)));
+  }
+  void _destroy() noexcept
+  {
+    if(_status == nullptr)
+      return;
+    for(size_t idx = 0; idx < _size; idx++)
+    {
+      if(_status_at(idx) != 0)
+        _at(idx)->~T();
+    }
+    ::operator delete(_status, std::align_val_t(_cache_line));
+    _status = _payload = nullptr;
+    _size = 0;
+  }
+
+public:
+  //! Constructs an empty instance
+  constexpr permutation_results() = default;
+  /*! Constructs an instance of `size` results, none of which are present.
+  \throws bad_alloc Failure to allocate the arena.
+  */
+  explicit permutation_results(size_t size)
+      : _size(size)
+  {
+    if(0 == size)
+      return;
+    const size_t chunks = (size + chunk_size - 1) / chunk_size;
+    _status = static_cast<unsigned char *>(::operator new(chunks * (_status_stride + _payload_stride), std::align_val_t(_cache_line)));
+    _payload = _status + chunks * _status_stride;
+    memset(_status, 0, chunks * _status_stride);
+  }
+  permutation_results(permutation_results &&o) noexcept
+      : _size(o._size)
+      , _status(o._status)
+      , _payload(o._payload)
+  {
+    o._size = 0;
+    o._status = o._payload = nullptr;
+  }
+  permutation_results(const permutation_results &o)
+      : permutation_results(o._size)
+  {
+    for(size_t idx = 0; idx < _size; idx++)
+    {
+      if(o.present(idx))
+        assign(idx, *o._at(idx));
+    }
+  }
+  permutation_results &operator=(permutation_results &&o) noexcept
+  {
+    if(this != &o)
+    {
+      _destroy();
+      _size = o._size;
+      _status = o._status;
+      _payload = o._payload;
+      o._size = 0;
+      o._status = o._payload = nullptr;
+    }
+    return *this;
+  }
+  permutation_results &operator=(const permutation_results &o)
+  {
+    if(this != &o)
+      *this = permutation_results(o);
+    return *this;
+  }
+  ~permutation_results() { _destroy(); }
+
+  //! The number of results
+  size_t size() const noexcept { return _size; }
+  //! True if there are no results
+  bool empty() const noexcept { return 0 == _size; }
+  //! True if the result at `idx` is present
+  bool present(size_t idx) const noexcept { return _status_at(idx) != 0; }
+  /*! What the result at `idx` holds, read without reading the outcome. Outcomes modified in place
+  through a `permutation_result_reference` have their status updated once it is destroyed.
+  */
+  permutation_status status(size_t idx) const noexcept { return static_cast<permutation_status>(_status_at(idx)); }
+  //! The result at `idx`
+  value_type operator[](size_t idx) const noexcept { return value_type(present(idx) ? _at(idx) : nullptr); }
+  //! \overload
+  permutation_result_reference<T> operator[](size_t idx) noexcept { return permutation_result_reference<T>(this, idx, present(idx) ? _at(idx) : nullptr); }
+
+  const_iterator begin() const noexcept { return const_iterator(this, 0); }
+  const_iterator end() const noexcept { return const_iterator(this, _size); }
+  const_iterator cbegin() const noexcept { return begin(); }
+  const_iterator cend() const noexcept { return end(); }
+
+  //! Sets the result at `idx`
+  template <class U, typename = typename std::enable_if<!std::is_same<typename std::decay<U>::type, optional<T>>::value>::type> void assign(size_t idx, U &&v)
+  {
+    unsigned char &status = _status_at(idx);
+    if(status != 0)
+    {
+      _at(idx)->~T();
+      status = 0;
+    }
+    new(_at(idx)) T(std::forward<U>(v));
+    status = static_cast<unsigned char>(detail::outcome_status(*_at(idx)));
+  }
+  //! \overload
+  void assign(size_t idx, optional<T> &&v)
+  {
+    if(v)
+      assign(idx, std::move(*v));
+    else
+      reset(idx);
+  }
+  //! \overload
+  void assign(size_t idx, const optional<T> &v)
+  {
+    if(v)
+      assign(idx, *v);
+    else
+      reset(idx);
+  }
+  //! Makes the result at `idx` not present
+  void reset(size_t idx) noexcept
+  {
+    unsigned char &status = _status_at(idx);
+    if(status != 0)
+    {
+      _at(idx)->~T();
+      status = 0;
+    }
+  }
+};
+
+namespace detail
+{
+  // Kept for code written against earlier versions, where results were a std::vector or std::array
+  template <class T> T make_permutation_results_type(size_t no) { return T(no); }
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
@@ -23,6 +23,22 @@ Distributed under the Boost Software License, Version 1.0.
 */
 
 #include "config.hpp"
+#include "allocations.hpp"
+#include "async_kernel.hpp"
+#include "baseline.hpp"
+#include "batch.hpp"
+#include "benchmark.hpp"
+#include "counters.hpp"
+#include "differential.hpp"
+#include "executor.hpp"
+#include "parameter_generators.hpp"
+#include "permutation_results.hpp"
+#include "process_isolation.hpp"
+#include "result_cache.hpp"
+#include "schedule.hpp"
+#include "sharding.hpp"
+#include "signal_capture.hpp"
+#include "watchdog.hpp"
 
 #ifndef KERNELTEST_PERMUTE_PARAMETERS_HPP
 #define KERNELTEST_PERMUTE_PARAMETERS_HPP
@@ -30,7 +46,18 @@ Distributed under the Boost Software License, Version 1.0.
 #include "quickcpplib/console_colours.hpp"
 #include "quickcpplib/type_traits.hpp"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
 #include <vector>
 
 #ifdef _MSC_VER
@@ -52,38 +79,26 @@ namespace detail
     static constexpr bool value = true;
     static constexpr size_t size = N;
   };
-  template <class ParamSequence, bool = has_constant_size<ParamSequence>::value> struct permutation_results_type
-  {
-    template <class T> using type = std::vector<optional<T>>;
-    constexpr ParamSequence operator()(size_t no) const { return ParamSequence(no); }
-  };
-  template <class ParamSequence> struct permutation_results_type<ParamSequence, true>
-  {
-    template <class T> using type = std::array<optional<T>, has_constant_size<ParamSequence>::size>;
-    constexpr ParamSequence operator()(size_t) const { return ParamSequence(); }
-  };
-  template <class T> constexpr T make_permutation_results_type(size_t no)
-  {
-    return permutation_results_type<T>()(no);
-  }
-
   template <class ParamSequence, class Callable> struct result_of_parameter_permute;
 #if defined(_MSC_VER) && (_MSC_VER >= 1923 && _MSC_VER <= 1929)  // these MSVCs need help
-  template <class ParamSequence, class Callable> struct msvc_result_of_parameter_permute;
-  template <class... Types, class Callable> struct msvc_result_of_parameter_permute<parameters<Types...>, Callable>
+  template <class OutcomeType, class ParamSequence, class Callable> struct msvc_result_of_parameter_permute;
+  template <class OutcomeType, class... Types, class Callable> struct msvc_result_of_parameter_permute<OutcomeType, parameters<Types...>, Callable>
   {
-    using type = decltype(std::declval<Callable>()(std::declval<Types>()...));
+    using type = typename kernel_call_result<Callable, OutcomeType, Types...>::type;
   };
   template <class OutcomeType, class Innards, class... Excess, class Callable>
   struct result_of_parameter_permute<parameters<OutcomeType, Innards, Excess...>, Callable>
   {
-    using type = typename msvc_result_of_parameter_permute<Innards, Callable>::type;
+    using callable_type = typename msvc_result_of_parameter_permute<OutcomeType, Innards, Callable>::type;
+    using type = typename unwrap_kernel_task<callable_type>::type;
   };
 #endif
+  // type is the outcome of the kernel, and callable_type what calling it returns (see kernel_task)
   template <class OutcomeType, class... Types, class... Excess, class Callable>
   struct result_of_parameter_permute<parameters<OutcomeType, parameters<Types...>, Excess...>, Callable>
   {
-    using type = decltype(std::declval<Callable>()(std::declval<Types>()...));
+    using callable_type = typename kernel_call_result<Callable, OutcomeType, Types...>::type;
+    using type = typename unwrap_kernel_task<callable_type>::type;
   };
 
   // Need a tuple whose destruction order is well known. This fellow destructs in
@@ -107,6 +122,180 @@ namespace detail
     {
     }
   };
+  template <> struct hooks_container<>
+  {
+  };
+
+  // Adds the time between its destruction and that of its partner to *slot, if slot is set
+  struct teardown_stopwatch
+  {
+    std::chrono::nanoseconds *slot;
+    bool is_end;
+    ~teardown_stopwatch()
+    {
+      if(slot != nullptr)
+      {
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch());
+        *slot += is_end ? now : -now;
+      }
+    }
+  };
+  // A hook instance whose destruction is timed. Members destruct in reverse order, so
+  // _begin stamps before the hook instance destructs and _end stamps after.
+  template <class T> struct timed_hook
+  {
+    teardown_stopwatch _end;
+    T _v;
+    teardown_stopwatch _begin;
+    timed_hook(T &&v, std::chrono::nanoseconds *teardown)
+        : _end{teardown, true}
+        , _v(std::move(v))
+        , _begin{teardown, false}
+    {
+    }
+    timed_hook(timed_hook &&o)
+        : _end{o._end.slot, true}
+        , _v(std::move(o._v))
+        , _begin{o._begin.slot, false}
+    {
+      o._end.slot = o._begin.slot = nullptr;
+    }
+    timed_hook(const timed_hook &) = delete;
+  };
+
+  /* True if instances of Hook can be reused for later permutations with the same hook
+  parameters, after calling `instance.reset(parent, testret, idx)` upon them. If instances also
+  have `instance.release()`, it is called whenever a permutation has finished with the instance
+  but it is kept for reuse, to undo anything which should not outlive the permutation.
+  */
+  template <class Hook, class = void> struct is_resettable_hook : std::false_type
+  {
+  };
+  template <class Hook>
+  struct is_resettable_hook<Hook, decltype((void) std::decay<Hook>::type::is_resettable)> : std::integral_constant<bool, std::decay<Hook>::type::is_resettable>
+  {
+  };
+
+  /* True if instances of Hook may be alive for many permutations of a coroutine test kernel
+  interleaving upon one thread, being hooks which neither change process wide state such as the
+  working directory, nor rely upon per thread state.
+  */
+  template <class Hook, class = void> struct is_interleavable_hook : std::false_type
+  {
+  };
+  template <class Hook>
+  struct is_interleavable_hook<Hook, decltype((void) std::decay<Hook>::type::is_interleavable)>
+      : std::integral_constant<bool, std::decay<Hook>::type::is_interleavable>
+  {
+  };
+
+  // Hook parameters are the same if equal, or if C strings with equal contents
+  template <class T> inline bool same_hook_parameter(const T &a, const T &b) { return a == b; }
+  inline bool same_hook_parameter(const char *a, const char *b) { return a == b || (a != nullptr && b != nullptr && 0 == strcmp(a, b)); }
+  template <class... Types, size_t... Idxs> inline bool same_hook_parameters(const std::tuple<Types...> &a, const std::tuple<Types...> &b, std::index_sequence<Idxs...>)
+  {
+    return (same_hook_parameter(std::get<Idxs>(a), std::get<Idxs>(b)) && ... && true);
+  }
+
+  /* The instances of resettable hooks kept by one worker between permutations, one per hook
+  per distinct set of hook parameters. Instances are destroyed newest first.
+  */
+  class hook_pool
+  {
+    struct entry
+    {
+      size_t hook;
+      std::shared_ptr<void> parameters, instance;
+      bool in_use;  // by the permutation being executed
+    };
+    std::vector<entry> _entries;
+
+  public:
+    hook_pool() = default;
+    hook_pool(hook_pool &&) = default;
+    hook_pool(const hook_pool &) = delete;
+    ~hook_pool()
+    {
+      while(!_entries.empty())
+        _entries.pop_back();
+    }
+    // The instance of the hookth hook for pars, or null if there is none yet
+    template <class Instance, class... Types> Instance *find(size_t hook, const std::tuple<Types...> &pars)
+    {
+      for(entry &i : _entries)
+      {
+        if(i.hook == hook && same_hook_parameters(*static_cast<const std::tuple<Types...> *>(i.parameters.get()), pars, std::index_sequence_for<Types...>()))
+        {
+          i.in_use = true;
+          return static_cast<Instance *>(i.instance.get());
+        }
+      }
+      return nullptr;
+    }
+    // Keeps v as the instance of the hookth hook for pars
+    template <class Instance, class... Types> Instance *add(size_t hook, const std::tuple<Types...> &pars, Instance &&v)
+    {
+      auto instance = std::make_shared<Instance>(std::move(v));
+      _entries.push_back(entry{hook, std::make_shared<std::tuple<Types...>>(pars), instance, true});
+      return instance.get();
+    }
+    // Marks all instances as unused, before executing a permutation
+    void begin() noexcept
+    {
+      for(entry &i : _entries)
+        i.in_use = false;
+    }
+    /* Destroys the instances in use by the permutation being executed, newest first, as after it was
+    abandoned they may be in any state.
+    */
+    void discard_in_use()
+    {
+      for(size_t n = _entries.size(); n > 0; n--)
+      {
+        if(_entries[n - 1].in_use)
+          _entries.erase(_entries.begin() + static_cast<ptrdiff_t>(n - 1));
+      }
+    }
+  };
+  template <class T, class = void> struct has_release : std::false_type
+  {
+  };
+  template <class T> struct has_release<T, decltype(std::declval<T &>().release())> : std::true_type
+  {
+  };
+  // A resettable hook instance, which is kept by a hook_pool unless there is none
+  template <class T> struct pooled_hook
+  {
+    T *_v;
+    optional<T> _owned;
+    explicit pooled_hook(T *v)
+        : _v(v)
+    {
+    }
+    explicit pooled_hook(T &&v)
+        : _owned(std::move(v))
+    {
+      _v = &*_owned;
+    }
+    pooled_hook(pooled_hook &&o)
+        : _v(o._v)
+        , _owned(std::move(o._owned))
+    {
+      o._v = nullptr;
+      if(_owned)
+        _v = &*_owned;
+    }
+    pooled_hook(const pooled_hook &) = delete;
+    ~pooled_hook()
+    {
+      if constexpr(has_release<T>::value)
+      {
+        if(_v != nullptr && !_owned)
+          _v->release();
+      }
+    }
+  };
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable : 4100)  // unreferenced formal parameter
@@ -119,19 +308,53 @@ namespace detail
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
+  /* If Hook is resettable and there is a pool, the instance for pars is reused after resetting
+  it if the pool has one, else is added to the pool.
+  */
+  template <size_t HookIdx, class Hook, class Permuter, class Outcome, class Pars, class Seq>
+  auto instantiate_timed_hook(Hook &&hook, Permuter *parent, Outcome &out, size_t idx, const Pars &pars, Seq seq, std::chrono::nanoseconds *setup,
+                              std::chrono::nanoseconds *teardown, hook_pool *pool)
+  {
+    using hook_instance_type = decltype(instantiate_hook(std::forward<Hook>(hook), parent, out, idx, pars, seq));
+    auto begin = (setup != nullptr) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    if constexpr(is_resettable_hook<Hook>::value)
+    {
+      hook_instance_type *v = (pool != nullptr) ? pool->find<hook_instance_type>(HookIdx, pars) : nullptr;
+      if(v != nullptr)
+        v->reset(parent, out, idx);
+      else if(pool != nullptr)
+        v = pool->add(HookIdx, pars, instantiate_hook(std::forward<Hook>(hook), parent, out, idx, pars, seq));
+      timed_hook<pooled_hook<hook_instance_type>> ret(
+      (v != nullptr) ? pooled_hook<hook_instance_type>(v) : pooled_hook<hook_instance_type>(instantiate_hook(std::forward<Hook>(hook), parent, out, idx, pars, seq)),
+      (v != nullptr) ? nullptr : teardown);
+      if(setup != nullptr)
+        *setup = std::chrono::steady_clock::now() - begin;
+      return ret;
+    }
+    else
+    {
+      (void) pool;
+      timed_hook<hook_instance_type> ret(instantiate_hook(std::forward<Hook>(hook), parent, out, idx, pars, seq), teardown);
+      if(setup != nullptr)
+        *setup = std::chrono::steady_clock::now() - begin;
+      return ret;
+    }
+  }
   template <class... Hooks, class Permuter, class Outcome, class ParamSequence, size_t... Idxs>
-  auto instantiate_hooks(const std::tuple<Hooks...> &hooks, Permuter *parent, Outcome &out, size_t idx, const ParamSequence &pars, std::index_sequence<Idxs...>)
+  auto instantiate_hooks(const std::tuple<Hooks...> &hooks, Permuter *parent, Outcome &out, size_t idx, const ParamSequence &pars, std::index_sequence<Idxs...>,
+                         std::chrono::nanoseconds *setup = nullptr, std::chrono::nanoseconds *teardown = nullptr, hook_pool *pool = nullptr)
   {
     // callspec is (parameter_permuter<...> *parent, outcome<T> &testret, size_t, pars)
     // pars<0> is expected outcome, pars<1> is kernel parameter set. pars<2> onwards are the hook parameters
     //
     // Cannot use tuple because can't guarantee order of destruction, it varies by
-    // STL implementation
-    return hooks_container<decltype(instantiate_hook(
+    // STL implementation. Braced initialisation guarantees hooks are constructed in order.
+    return hooks_container<decltype(instantiate_timed_hook<Idxs>(
     std::get<Idxs>(hooks), parent, out, idx, std::get<2 + Idxs>(pars),
-    std::make_index_sequence<parameters_size<typename parameters_element<2 + Idxs, ParamSequence>::type>::value>()))...>{
-    instantiate_hook(std::get<Idxs>(hooks), parent, out, idx, std::get<2 + Idxs>(pars),
-                     std::make_index_sequence<parameters_size<typename parameters_element<2 + Idxs, ParamSequence>::type>::value>())...};
+    std::make_index_sequence<parameters_size<typename parameters_element<2 + Idxs, ParamSequence>::type>::value>(), setup, teardown, pool))...>{
+    instantiate_timed_hook<Idxs>(std::get<Idxs>(hooks), parent, out, idx, std::get<2 + Idxs>(pars),
+                                 std::make_index_sequence<parameters_size<typename parameters_element<2 + Idxs, ParamSequence>::type>::value>(),
+                                 (setup != nullptr) ? setup + Idxs : nullptr, (teardown != nullptr) ? teardown + Idxs : nullptr, pool)...};
   }
 
 #ifdef _MSC_VER
@@ -150,20 +373,51 @@ namespace detail
     return f(std::get<Idxs>(params)...);
   }
 
-  template <class T, class U, class V, class W, class A, class B, class C, class D>
-  bool check_result(const optional<outcome<T, U, V, W>> &kernel_outcome, const outcome<A, B, C, D> &shouldbe)
+  //! The kerneltest_errc for an exception thrown during stage (0 = setup, 1 = kernel, 2 = teardown)
+  inline kerneltest_errc exception_errc(int stage) noexcept
+  {
+    if(1 == stage)
+      return kerneltest_errc::kernel_exception_thrown;
+    if(2 == stage)
+      return kerneltest_errc::teardown_exception_thrown;
+    return kerneltest_errc::setup_exception_thrown;
+  }
+
+  // Stands in for a result not present which ought to have been. Optional is optional<> or permutation_result<>.
+  template <class Optional> inline auto not_executed_result(const Optional &)
+  {
+    using outcome_type = std::decay_t<decltype(*std::declval<const Optional &>())>;
+    optional<outcome_type> ret;
+    ret.emplace(in_place_type<typename outcome_type::error_type>, make_error_code(kerneltest_errc::permutation_not_executed));
+    return ret;
+  }
+  // True if a result is kerneltest_errc::permutation_skipped. Optional is optional<> or permutation_result<>.
+  template <class Optional> inline bool is_skipped(const Optional &result)
+  {
+    if(!result || !result->has_error())
+      return false;
+#if KERNELTEST_EXPERIMENTAL_STATUS_CODE
+    return result->error() == make_error_code(kerneltest_errc::permutation_skipped);
+#else
+    return OUTCOME_V2_NAMESPACE::policy::error_code(result->error()) == make_error_code(kerneltest_errc::permutation_skipped);
+#endif
+  }
+
+  // Optional is optional<> or permutation_result<>
+  template <template <class...> class Optional, class T, class U, class V, class W, class A, class B, class C, class D>
+  bool check_result(const Optional<outcome<T, U, V, W>> &kernel_outcome, const outcome<A, B, C, D> &shouldbe)
   {
     return *kernel_outcome == shouldbe;
   };
-  template <class T, class U, class V, class A, class B, class C>
-  bool check_result(const optional<result<T, U, V>> &kernel_outcome, const result<A, B, C> &shouldbe)
+  template <template <class...> class Optional, class T, class U, class V, class A, class B, class C>
+  bool check_result(const Optional<result<T, U, V>> &kernel_outcome, const result<A, B, C> &shouldbe)
   {
     return *kernel_outcome == shouldbe;
   };
 
   // If should be has type void, we only care kernel_outcome has a value
-  template <class T, class U, class V, class W, class B, class C, class D>
-  bool check_result(const optional<outcome<T, U, V, W>> &kernel_outcome, const outcome<void, B, C, D> &shouldbe)
+  template <template <class...> class Optional, class T, class U, class V, class W, class B, class C, class D>
+  bool check_result(const Optional<outcome<T, U, V, W>> &kernel_outcome, const outcome<void, B, C, D> &shouldbe)
   {
     if(kernel_outcome->has_value() && shouldbe.has_value())
       return kernel_outcome->has_value() == shouldbe.has_value();
@@ -192,7 +446,7 @@ namespace detail
     else
       return false;
   };
-  template <class T, class U, class V, class B, class C> bool check_result(const optional<result<T, U, V>> &kernel_outcome, const result<void, B, C> &shouldbe)
+  template <template <class...> class Optional, class T, class U, class V, class B, class C> bool check_result(const Optional<result<T, U, V>> &kernel_outcome, const result<void, B, C> &shouldbe)
   {
     if(kernel_outcome->has_value() && shouldbe.has_value())
       return kernel_outcome->has_value() == shouldbe.has_value();
@@ -251,8 +505,182 @@ namespace detail
       return a.error() == b.error();
     return false;
   }
+
+  // Prints the kernel and hook parameters of permutation idx
+  template <class Permuter> void print_permutation(std::ostream &os, const Permuter &_permuter, size_t idx);
+  /* As print_permutation(), followed by the values of the hook parameters, as hooks need not print
+  those. Permutations described identically have equal parameters.
+  */
+  template <class Permuter> void describe_permutation(std::ostream &os, const Permuter &_permuter, size_t idx);
+  // Prints the index and parameters of permutation idx to KERNELTEST_COUT
+  template <class Permuter> void pretty_print_preamble(const Permuter &_permuter, size_t idx);
 }  // namespace detail
 
+/*! \brief How long each stage of an individual permutation took, as measured by `std::chrono::steady_clock`.
+\tparam HookCount The number of hooks in the permuter
+*/
+template <size_t HookCount> struct permutation_statistics
+{
+  //! The time taken to construct each hook, in hook order
+  std::array<std::chrono::nanoseconds, HookCount> hook_setup{};
+  //! The time taken by the kernel
+  std::chrono::nanoseconds kernel{0};
+  //! The time taken to destruct each hook, in hook order
+  std::array<std::chrono::nanoseconds, HookCount> hook_teardown{};
+  /*! If benchmarked, the distribution of kernel times. `kernel` is then the median, and the
+  hook times are those of the final repetition.
+  */
+  optional<benchmark_statistics> benchmark;
+  //! Where the permutation was executed when it began (see `worker_placement_options`)
+  worker_placement placement;
+  //! If counted, the performance events of the kernel (see `permute_options::counters`). If benchmarked, those of the final repetition.
+  performance_counters counters;
+  //! If tracked, the heap allocations of the kernel (see `permute_options::allocations`). If benchmarked, those of the final repetition.
+  allocation_statistics allocations;
+
+  //! The total time taken to construct all the hooks
+  std::chrono::nanoseconds setup() const noexcept
+  {
+    std::chrono::nanoseconds ret(0);
+    for(auto &i : hook_setup)
+      ret += i;
+    return ret;
+  }
+  //! The total time taken to destruct all the hooks
+  std::chrono::nanoseconds teardown() const noexcept
+  {
+    std::chrono::nanoseconds ret(0);
+    for(auto &i : hook_teardown)
+      ret += i;
+    return ret;
+  }
+  //! The total time taken by the permutation
+  std::chrono::nanoseconds total() const noexcept { return setup() + kernel + teardown(); }
+};
+
+//! What a permuter does with permutations whose kernel and hook parameters duplicate those of an earlier permutation
+enum class duplicate_policy
+{
+  execute,        //!< Duplicates are executed like any other permutation
+  reuse,          //!< Duplicates are not executed, and receive the outcome of the earlier permutation
+  reuse_and_warn  //!< As `reuse`, also printing how many duplicates there were to `KERNELTEST_CERR()`
+};
+
+//! Options affecting how a `parameter_permuter` executes its permutations
+struct permute_options
+{
+  //! The executor a multithreaded permuter runs upon. Null means `permutation_executor::global()`.
+  permutation_executor *executor{nullptr};
+  //! If set, each permutation is repeated until its kernel time is statistically stable (see `bench_permute_parameters()`)
+  optional<benchmark_options> benchmark;
+  /*! If true, a permutation raising SIGSEGV, SIGBUS, SIGFPE or SIGILL fails with
+  `kerneltest_errc::*_signal_thrown` and the executing thread continues with the next
+  permutation. Each executing thread gets an alternate signal stack so stack overflows are
+  also captured. Unlike `isolation` this costs almost nothing per permutation, but the hooks
+  and any other objects of the faulting permutation are not destructed, and whatever state it
+  corrupted remains corrupted. Pooled instances of resettable hooks it was using are discarded,
+  and allocation tracking and performance counting are restored. Ignored on Windows.
+  */
+  bool capture_signals{false};
+  /*! If non-zero, once this many permutations have failed no more are begun, and those not
+  begun fail with `kerneltest_errc::permutation_skipped`. Permutations already executing
+  complete as normal. `check()` and `stream()` do not report skipped permutations individually.
+  */
+  size_t fail_fast{0};
+  /*! If set, permutations execute in child processes forked from the calling process, so a
+  permutation raising a signal fails with `kerneltest_errc::*_signal_thrown` instead of
+  killing the test. Children are reused until they crash or run out of permutations. Kernel
+  outcome values are only transported back if trivially copyable, else the permutation fails
+  with `kerneltest_errc::outcome_not_transportable`. Ignored on Windows.
+
+  The children are forked by a single threaded fork server, itself forked from the calling
+  thread each time the permuter executes rather than before the executor's worker threads were
+  started. Only the calling thread exists within each child, so kernels must not rely upon
+  locks which another thread of the parent might have held at the moment the fork server was
+  forked (see `process_isolation_options`).
+  */
+  optional<process_isolation_options> isolation;
+  /*! If non-zero, a permutation still executing this long after it began fails with
+  `kerneltest_errc::*_timed_out`. The `hooks::timeout` hook can override this per permutation.
+  When the deadline expires, a warning and the permutation's parameters are printed.
+
+  If isolated, the child process executing the permutation is then killed, and another continues
+  with the next permutation. Otherwise, as a thread cannot safely be interrupted in whatever it is
+  doing, a multithreaded permuter abandons the worker thread executing the permutation, which the
+  executor replaces (see `permutation_executor::abandon()`), so a kernel which never returns cannot
+  hang the permuter. The abandoned thread is leaked along with the permutation's hooks, and should
+  the permutation ever return, the thread blocks forever rather than tear them down. Whilst stuck,
+  the kernel and its hooks must not rely upon anything which the test may since have destroyed.
+  Resettable hook instances are not reused between watched permutations.
+
+  A single threaded permuter has only the calling thread, so setting a timeout (or using a hook
+  which sets deadlines) executes its permutations isolated even if `isolation` is unset, with
+  default `process_isolation_options`, printing a warning saying so. This is not done on Windows,
+  nor if the kernel's outcome value is not trivially copyable, where permutations are only failed
+  once they return, with all their hooks having been torn down as normal. The same goes for
+  multithreaded permuters executing upon the calling thread, such as when the executor has a
+  single worker.
+  */
+  std::chrono::nanoseconds timeout{0};
+  /*! If set, only the permutations of this shard of the parameter sequence are executed, and
+  the results of all others are not present. `check()` ignores those results (see `in_shard()`), and
+  `merge_shards()` rebuilds the results of every permutation from the output of each shard.
+  If unset, `shard_options::from_environment()` is consulted whenever the permuter is called.
+  */
+  optional<shard_options> shard;
+  /*! Tells this table apart from others executed within the same test kernel to the shard
+  results, the result cache and the baseline. If empty, the types of the kernel, of the parameters and of the hooks
+  are used instead (if RTTI is available), which suffices unless one test kernel executes the
+  same kernel over two tables of the same type.
+  */
+  std::string table_name;
+  /*! If set, permutations whose outcomes were cached by an earlier run are not executed, and
+  the outcomes of those executed are cached (see `result_cache_options`). If unset,
+  `result_cache_options::from_environment()` is consulted whenever the permuter is called.
+  */
+  optional<result_cache_options> cache;
+  /*! If set, multithreaded and process isolated permuters begin the permutations predicted to
+  take longest first (see `schedule_options`), and the measured durations may be recorded for
+  later runs. If unset, `schedule_options::from_environment()` is consulted whenever the
+  permuter is called.
+  */
+  optional<schedule_options> schedule;
+  /*! The most permutations of a coroutine test kernel (see `kernel_task`) in flight at once upon
+  each thread. Each thread of a multithreaded permuter runs its own `event_loop`, and a single
+  threaded permuter runs one upon the calling thread. `capture_signals`, `isolation`,
+  `timeout` and `benchmark` are ignored for coroutine kernels. Permutations upon a thread only
+  interleave if every hook says it may by having a `static constexpr bool is_interleavable = true`
+  member, else only one is in flight at a time upon each thread. None of the hooks supplied by
+  this library may, as they change the working directory or rely upon per thread state.
+  */
+  size_t max_in_flight{1024};
+  /*! Permutations are duplicates if their kernel and hook parameters print identically. Reusing
+  outcomes is only correct for deterministic kernels and hooks, so duplicates are executed by
+  default. Each duplicate is still checked against its own expected outcome, and its statistics
+  are left zeroed. Duplicates are always executed if the kernel or hook parameters are not
+  printable to a `std::ostream`, or if the outcome of the kernel is not copyable.
+  */
+  duplicate_policy duplicates{duplicate_policy::execute};
+  /*! If set, every permutation is benchmarked, and those whose kernel times regress from a
+  stored baseline fail with `kerneltest_errc::performance_regressed`, or the baseline is
+  recorded (see `baseline_options`). If unset, `baseline_options::from_environment()` is
+  consulted whenever the permuter is called.
+  */
+  optional<baseline_options> baseline;
+  /*! If true, the performance events of the calling thread during each kernel are counted into
+  `permutation_statistics::counters`, if statistics are being collected. Opening the counters
+  costs a few syscalls per thread, and reading them a few per permutation. Ignored for batched
+  and coroutine kernels.
+  */
+  bool counters{false};
+  /*! If true, the heap allocations made by the calling thread during each kernel are tracked into
+  `permutation_statistics::allocations`, if statistics are being collected. Requires
+  `KERNELTEST_TRACK_ALLOCATIONS()` or `KERNELTEST_TRACK_MALLOC()` to be expanded in one source
+  file of the program. Ignored for batched and coroutine kernels.
+  */
+  bool allocations{false};
+};
+
 /*! \brief A parameter permuter instance
 \tparam is_mt True if this is a multithreaded parameter permuter
 \tparam ParamSequence A sequence of parameter calls
@@ -261,9 +689,7 @@ template <bool is_mt, class ParamSequence, class... Hooks> class parameter_permu
 {
   ParamSequence _params;
   std::tuple<Hooks...> _hooks;
-
-  // syntax helper for MSVC :)
-  using _permutation_results_type = typename detail::permutation_results_type<ParamSequence>;
+  permute_options _options;
 
 public:
   //! True if this parameter permuter is multithreaded
@@ -298,13 +724,21 @@ public:
   //! Accessor for the hook at index N
   template <size_t N> static constexpr const hook_type<N> &hook_value(const hook_sequence_type &v) { return std::get<N>(v); }
 
-  //! The type of the results returned by the call operator. Can be array<> or vector<> depending on ParamSequence
-  template <class T> using permutation_results_type = typename _permutation_results_type::template type<T>;
-  //! True if permutation_results_type is constant sized
+  /*! The type of the results returned by the call operator. This is always heap allocated, even
+  for constant sized parameter sequences, whose size remains available as
+  `permutation_results_type_constant_size`.
+  */
+  template <class T> using permutation_results_type = permutation_results<T>;
+  //! True if the parameter sequence, and so the number of results, is constant sized
   static constexpr bool permutation_results_type_is_constant_sized = parameter_sequence_type_is_constant_sized;
-  //! Any constant size of the permutation_results_type if it is constant sized
+  //! Any constant size of the results if the parameter sequence is constant sized
   static constexpr size_t permutation_results_type_constant_size = parameter_sequence_type_constant_size;
 
+  //! The type of the timings of an individual permutation
+  using statistics_type = permutation_statistics<sizeof...(Hooks)>;
+  //! The type of the sequence of timings optionally filled by the call operator, in the same order as the results
+  using statistics_sequence_type = std::vector<statistics_type>;
+
   //! Constructs an instance. Best to use mt_permute_parameters() or st_permute_parameters() instead.
   constexpr parameter_permuter(ParamSequence &&params, std::tuple<Hooks...> &&hooks)
       : _params(std::move(params))
@@ -316,54 +750,702 @@ public:
   const ParamSequence &parameter_sequence() const { return _params; }
   //! Returns the hooks this permuter was constructed with
   const std::tuple<Hooks...> &hooks() const { return _hooks; }
+  //! Returns the executor this permuter uses if it is multithreaded
+  permutation_executor &executor() const noexcept { return (_options.executor != nullptr) ? *_options.executor : permutation_executor::global(); }
+  //! Returns the options for this permuter, which may be changed before calling it
+  permute_options &options() noexcept { return _options; }
+  //! \overload
+  const permute_options &options() const noexcept { return _options; }
   //! Convenience indexer into parameter sequence
-  auto &operator[](size_t idx) { return _params[idx]; }
+  decltype(auto) operator[](size_t idx) { return _params[idx]; }
   //! Convenience indexer into parameter sequence
-  const auto &operator[](size_t idx) const { return _params[idx]; }
+  decltype(auto) operator[](size_t idx) const { return _params[idx]; }
 
   /*! Permute the callable f with this parameter permuter, returning a sequence of results.
-  \return An array or vector of results (depends on ParamSequence::size() being constexpr).
-  \throws bad_alloc Failure to allocate the vector of results if returning a vector.
+  \return A `permutation_results` of the results.
+  \throws bad_alloc Failure to allocate the results.
   \throws anything Any exception thrown by any call of the callable f
   \param f Some callable with callspec result(typename ParamSequence::value_type ...)
   */
-  template <class U> auto operator()(U &&f) const
+  template <class U> auto operator()(U &&f) const { return _permute(std::forward<U>(f), nullptr); }
+  /*! \overload
+  \param statistics Resized to the length of the parameter sequence, and filled with how long
+  each stage of each permutation took at the same index as its result.
+  */
+  template <class U> auto operator()(U &&f, statistics_sequence_type &statistics) const
+  {
+    statistics.assign(_params.size(), statistics_type());
+    return _permute(std::forward<U>(f), statistics.data());
+  }
+  /*! Permute the callable f with this parameter permuter, checking each result against what
+  it ought to be as soon as its permutation completes rather than after all have completed.
+  Results are not retained, so memory consumption does not grow with the number of permutations,
+  except where options need some state for every permutation of the table. Isolated permutations
+  each have a slot of shared memory holding their outcome and statistics, the result cache keeps
+  the key and outcome of every permutation executed until it is saved, reusing duplicates keeps
+  the printed parameters of every permutation, and scheduling and sharding keep a duration or an
+  index per permutation.
+  \return True if all the results match. Skipped results (see `permute_options::fail_fast`) are
+  neither passed nor failed, but do not match.
+  \throws anything Any exception thrown by any call of the callable f
+  \param f Some callable with callspec result(typename ParamSequence::value_type ...)
+  \param fail Some callable with callspec bool(size_t, value, shouldbe) called if the values do not match
+  \param pass Some callable with callspec bool(size_t, value, shouldbe) called if the values match
+
+  If multithreaded, `fail` and `pass` are called by whichever worker completed the permutation,
+  whilst the other workers continue executing permutations. Calls are serialised, but arrive
+  in order of completion rather than index. If permutations are isolated (see
+  `permute_options::isolation` and `permute_options::timeout`), results are only checked once
+  all the child processes have exited.
+  */
+  template <class U, class V, class W> bool stream(U &&f, V &&fail, W &&pass) const
+  {
+    using return_type = typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::type;
+    std::mutex lock;
+    bool ret = true;
+    _plan_type plan = _plan<U>();
+    _execute_cached(std::forward<U>(f), nullptr, plan,
+                    [&](size_t idx, optional<return_type> &&result)
+                    {
+                      const parameter_sequence_value_type &row = _params[idx];
+                      const outcome_type &shouldbe = outcome_value(row);
+                      if(detail::is_skipped(result))
+                      {
+                        std::lock_guard<std::mutex> g(lock);
+                        ret = false;
+                        return;
+                      }
+                      const bool passed = detail::check_result(result, shouldbe);
+                      std::lock_guard<std::mutex> g(lock);
+                      if(!(passed ? pass(idx, result, shouldbe) : fail(idx, result, shouldbe)))
+                        ret = false;
+                    });
+    _finish(plan);
+    return ret;
+  }
+  //! \overload
+  template <class U, class V> bool stream(U &&f, V &&fail) const
+  {
+    return stream(std::forward<U>(f), std::forward<V>(fail), [](size_t, const auto &, const auto &) { return true; });
+  }
+  /*! Calls two implementations of the test kernel upon every permutation, comparing their
+  outcomes with each other rather than with the expected outcome, and their kernel times.
+  Each permutation is repeated as `opts.benchmark` says, alternating which kernel goes first
+  so that drift affects both equally, and the outcomes are those of the first repetition.
+  Hooks are instantiated for every call of either kernel. The shard, cache, schedule,
+  duplicates and benchmark options are ignored. If multithreaded, permutations execute
+  concurrently, which adds variance to the kernel times.
+  \return A `std::vector<differential_result<A, B>>` in the same order as the parameter sequence.
+  \throws bad_alloc Failure to allocate the results.
+  \param a The first kernel, usually the existing implementation
+  \param b The second kernel, usually its replacement
+  \param opts How many times to repeat each permutation, and the significance level of speedups
+  */
+  template <class U, class V> auto differential(U &&a, V &&b, const differential_options &opts = differential_options()) const
+  {
+    using a_type = typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::type;
+    using b_type = typename detail::result_of_parameter_permute<parameter_sequence_value_type, V>::type;
+    std::vector<differential_result<a_type, b_type>> results(_params.size());
+    auto execute_one = [&](size_t idx, size_t)
+    {
+      differential_result<a_type, b_type> &r = results[idx];
+      std::vector<std::chrono::nanoseconds> times_a, times_b;
+      const benchmark_options &bench = opts.benchmark;
+      size_t n = 0;
+      // Executes one repetition of both kernels, returning their combined time
+      auto paired = [&]
+      {
+        optional<a_type> outcome_a;
+        optional<b_type> outcome_b;
+        std::chrono::nanoseconds time_a, time_b;
+        if(0 == n % 2)
+        {
+          time_a = _call_once(a, idx, outcome_a);
+          time_b = _call_once(b, idx, outcome_b);
+        }
+        else
+        {
+          time_b = _call_once(b, idx, outcome_b);
+          time_a = _call_once(a, idx, outcome_a);
+        }
+        if(0 == n)
+        {
+          r.a = std::move(outcome_a);
+          r.b = std::move(outcome_b);
+        }
+        if(n++ >= bench.warmup)
+        {
+          times_a.push_back(time_a);
+          times_b.push_back(time_b);
+        }
+        return time_a + time_b;
+      };
+      (void) detail::benchmark_until(bench, paired,
+                                     [&](const std::vector<std::chrono::nanoseconds> &) { return detail::has_converged(times_a, bench) && detail::has_converged(times_b, bench); });
+      r.agree = r.a && r.b && detail::compare(*r.a, *r.b);
+      r.timing = detail::summarise_differential(times_a, times_b, opts);
+    };
+    if(is_multithreaded)
+      executor().run(_params.size(), execute_one);
+    else
+    {
+      for(size_t idx = 0; idx < _params.size(); idx++)
+        execute_one(idx, 0);
+    }
+    return results;
+  }
+
+private:
+  template <size_t... Idxs> static constexpr bool _are_parameters_ostreamable(std::index_sequence<Idxs...>)
+  {
+    return (detail::are_parameters_ostreamable<parameter_type<Idxs>>::value && ... && true);
+  }
+  // True if every kernel and hook parameter can be printed, so describe_permutation() tells permutations apart
+  static constexpr bool _is_describable = _are_parameters_ostreamable(std::make_index_sequence<parameters_size>());
+
+  // Calls f upon permutation idx once, with its hooks, returning the kernel time
+  template <class U, class R> std::chrono::nanoseconds _call_once(U &f, size_t idx, optional<R> &result) const
+  {
+    using callable_parameters_type = parameter_type<0>;
+    // Generated parameter sequences return by value, so this may be a temporary
+    const parameter_sequence_value_type &row = _params[idx];
+    const callable_parameters_type &p = parameter_value<0>(row);
+    std::chrono::nanoseconds ret(0);
+    int stage = 0;
+    KERNELTEST_EXCEPTION_TRY
+    {
+      auto hooks(detail::instantiate_hooks(_hooks, this, result, idx, row, std::make_index_sequence<sizeof...(Hooks)>()));
+      (void) hooks;
+      stage = 1;
+      auto begin = std::chrono::steady_clock::now();
+      result = detail::call_f_with_parameters(f, p, std::make_index_sequence<KERNELTEST_V1_NAMESPACE::parameters_size<callable_parameters_type>::value>());
+      ret = std::chrono::steady_clock::now() - begin;
+      stage = 2;
+    }
+    KERNELTEST_EXCEPTION_CATCH_ALL
+    {
+      result.emplace(in_place_type<typename R::error_type>, make_error_code(detail::exception_errc(stage)));
+    }
+    return ret;
+  }
+  template <class U> auto _permute(U &&f, statistics_type *statistics) const
   {
-    // The return type of the kernel callable
     using return_type = typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::type;
-    permutation_results_type<return_type> results(detail::make_permutation_results_type<permutation_results_type<return_type>>(_params.size()));
-    permutation_results_type<const parameter_sequence_value_type *> params(
-    detail::make_permutation_results_type<permutation_results_type<const parameter_sequence_value_type *>>(_params.size()));
+    permutation_results_type<return_type> results(_params.size());
+    _plan_type plan = _plan<U>();
+    _execute_cached(std::forward<U>(f), statistics, plan, [&](size_t idx, optional<return_type> &&result) { results.assign(idx, std::move(result)); });
+    if(plan.shard && !plan.shard->output.empty())
+    {
+      auto written = detail::write_shard_results(plan.shard->output, plan.table, *plan.shard, results, plan.indices);
+      if(!written)
+      {
+        KERNELTEST_CERR("WARNING: Failed to write shard results to " << plan.shard->output << " due to " << written.error().message().c_str() << std::endl);
+      }
+    }
+    _finish(plan);
+    return results;
+  }
+  // Which permutations a call of the permuter executes, and in what order
+  struct _plan_type
+  {
+    // Identifies the table and kernel to the shard results, the result cache and the baseline
+    std::string table;
+    optional<shard_options> shard;
+    std::vector<size_t> indices;  // the indices of the shard, if sharded
+    optional<schedule_options> schedule;
+    // If scheduling, the predicted duration of every permutation, which are replaced by those measured
+    std::vector<std::chrono::nanoseconds> durations;
+    // If scheduling, the durations as predicted, to tell which were measured
+    std::vector<std::chrono::nanoseconds> predicted;
+    // If comparing kernel times against a baseline, or recording one
+    optional<detail::performance_baseline> baseline;
+  };
+  // Identifies the table and the kernel U executing it within the current test kernel
+  template <class U> std::string _table() const
+  {
+    std::string ret = detail::current_test_kernel_path();
+    if(!_options.table_name.empty())
+      ret.append(_options.table_name);
+#ifdef __cpp_rtti
+    else
+      ret.append(typeid(std::tuple<std::decay_t<U>, parameter_sequence_value_type, Hooks...>).name());
+#endif
+    return ret;
+  }
+  // The shard of the permutations which a call of the permuter executes, if sharded
+  optional<shard_options> _shard() const
+  {
+    optional<shard_options> ret = _options.shard ? _options.shard : shard_options::from_environment();
+    if(ret && ret->count <= 1)
+      ret.reset();
+    if(ret && ret->costs.empty())
     {
-      auto it(params.begin());
-      for(auto &i : _params)
-        *it++ = &i;
+      // Only durations given in full balance shards, as the recorded ones change whilst shards execute
+      optional<schedule_options> schedule = _options.schedule ? _options.schedule : schedule_options::from_environment();
+      if(schedule && schedule->durations.size() == _params.size())
+        ret->costs = schedule->durations;
     }
-    auto call_f = [&](size_t idx)
+    return ret;
+  }
+  template <class U> _plan_type _plan() const
+  {
+    _plan_type ret;
+    ret.table = _table<U>();
+    ret.schedule = _options.schedule ? _options.schedule : schedule_options::from_environment();
+    if(ret.schedule)
     {
+      if(ret.schedule->durations.size() == _params.size())
+        ret.durations = ret.schedule->durations;
+      else if(!ret.schedule->directory.empty())
+        ret.durations = detail::read_durations(ret.schedule->directory, ret.table, _params.size());
+      // Durations never measured are zero, and those of permutations not executed are retained when recording
+      ret.durations.resize(_params.size());
+      ret.predicted = ret.durations;
+    }
+    ret.shard = _shard();
+    if(ret.shard)
+      ret.indices = detail::shard_indices(_params.size(), *ret.shard);
+    optional<baseline_options> baseline = _options.baseline ? _options.baseline : baseline_options::from_environment();
+    if(baseline)
+    {
+      // Permutations are identified in the baseline by their printed parameters
+      if constexpr(_is_describable)
+      {
+        ret.baseline.emplace(*baseline, ret.table, _params.size());
+        std::ostringstream description;
+        for(size_t idx = 0; idx < _params.size(); idx++)
+        {
+          description.str(std::string());
+          detail::describe_permutation(description, *this, idx);
+          ret.baseline->describe(idx, description.str());
+        }
+      }
+      else
+      {
+        KERNELTEST_CERR("WARNING: Not comparing kernel times against the baseline as the kernel or hook parameters cannot be printed" << std::endl);
+      }
+    }
+    return ret;
+  }
+  // Records the measured durations and kernel times of a completed plan, if asked to
+  void _finish(const _plan_type &plan) const
+  {
+    if(plan.baseline && plan.baseline->options().record)
+    {
+      auto saved = plan.baseline->save();
+      if(!saved)
+      {
+        KERNELTEST_CERR("WARNING: Failed to record the baseline due to " << saved.error().message().c_str() << std::endl);
+      }
+    }
+    if(!plan.schedule || plan.schedule->directory.empty())
+      return;
+    auto written = detail::write_durations(plan.schedule->directory, plan.table, plan.durations, plan.predicted);
+    if(!written)
+    {
+      KERNELTEST_CERR("WARNING: Failed to record permutation durations due to " << written.error().message().c_str() << std::endl);
+    }
+  }
+  /* As _execute(), but reusing the outcomes of permutations cached by earlier runs if a
+  result cache is enabled, and caching the outcomes of the permutations executed.
+  */
+  template <class U, class Sink> void _execute_cached(U &&f, statistics_type *statistics, _plan_type &plan, Sink &&sink) const
+  {
+    const std::vector<size_t> *indices = plan.shard ? &plan.indices : nullptr;
+    std::vector<std::chrono::nanoseconds> *durations = plan.schedule ? &plan.durations : nullptr;
+    detail::performance_baseline *baseline = plan.baseline ? &*plan.baseline : nullptr;
+    using return_type = typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::type;
+    // Permutations are keyed by their printed parameters, and only lossless outcomes are cached
+    constexpr bool cacheable = detail::result_cache<return_type>::is_supported && _is_describable;
+    optional<result_cache_options> options = _options.cache ? _options.cache : result_cache_options::from_environment();
+    if(options && options->build_identity.empty() && detail::binary_identity().empty())
+    {
+      KERNELTEST_CERR("WARNING: Not caching results as the build identity of the test binary could not be determined" << std::endl);
+      options.reset();
+    }
+    if constexpr(cacheable)
+    {
+      if(options)
+      {
+        detail::result_cache<return_type> cache(*options, plan.table);
+        const size_t count = (indices != nullptr) ? indices->size() : _params.size();
+        std::vector<size_t> pending;
+        std::vector<uint64_t> pending_keys;
+        std::ostringstream description;
+        for(size_t n = 0; n < count; n++)
+        {
+          const size_t idx = (indices != nullptr) ? (*indices)[n] : n;
+          description.str(std::string());
+          detail::describe_permutation(description, *this, idx);
+          const uint64_t key = cache.key(description.str());
+          optional<return_type> cached = cache.find(key);
+          if(cached)
+            sink(idx, std::move(cached));
+          else
+          {
+            pending.push_back(idx);
+            pending_keys.push_back(key);
+          }
+        }
+        // pending is ascending, so the slot of each index can be found by bisection
+        std::vector<detail::portable_outcome<return_type>> executed(pending.size());
+        _execute_unique(std::forward<U>(f), statistics, &pending, durations, baseline,
+                 [&](size_t idx, optional<return_type> &&result)
+                 {
+                   executed[std::lower_bound(pending.begin(), pending.end(), idx) - pending.begin()].store(result);
+                   sink(idx, std::move(result));
+                 });
+        for(size_t n = 0; n < pending.size(); n++)
+          cache.insert(pending_keys[n], executed[n]);
+        auto saved = cache.save();
+        if(!saved)
+        {
+          KERNELTEST_CERR("WARNING: Failed to save the result cache due to " << saved.error().message().c_str() << std::endl);
+        }
+        return;
+      }
+    }
+    _execute_unique(std::forward<U>(f), statistics, indices, durations, baseline, std::forward<Sink>(sink));
+  }
+  /* As _execute(), but if duplicates are to be reused, executing only the first permutation of
+  each set with identically printed parameters and handing its outcome to the others too.
+  */
+  template <class U, class Sink>
+  void _execute_unique(U &&f, statistics_type *statistics, const std::vector<size_t> *indices, std::vector<std::chrono::nanoseconds> *durations,
+                       detail::performance_baseline *baseline, Sink &&sink) const
+  {
+    using return_type = typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::type;
+    if constexpr(_is_describable && std::is_copy_constructible<return_type>::value)
+    {
+      if(duplicate_policy::execute != _options.duplicates)
+      {
+        const size_t count = (indices != nullptr) ? indices->size() : _params.size();
+        std::unordered_map<std::string, size_t> first;
+        std::vector<size_t> unique;
+        std::vector<std::pair<size_t, size_t>> duplicates;  // (index executed, index of duplicate)
+        std::ostringstream description;
+        for(size_t n = 0; n < count; n++)
+        {
+          const size_t idx = (indices != nullptr) ? (*indices)[n] : n;
+          description.str(std::string());
+          detail::describe_permutation(description, *this, idx);
+          auto it = first.emplace(description.str(), idx);
+          if(it.second)
+            unique.push_back(idx);
+          else
+            duplicates.emplace_back(it.first->second, idx);
+        }
+        if(!duplicates.empty())
+        {
+          if(duplicate_policy::reuse_and_warn == _options.duplicates)
+          {
+            KERNELTEST_CERR("WARNING: " << duplicates.size() << " of " << count << " permutations duplicate earlier permutations, and reuse their outcomes" << std::endl);
+          }
+          first.clear();
+          std::sort(duplicates.begin(), duplicates.end());
+          _execute(std::forward<U>(f), statistics, &unique, durations, baseline,
+                   [&](size_t idx, optional<return_type> &&result)
+                   {
+                     auto range = std::equal_range(duplicates.begin(), duplicates.end(), std::pair<size_t, size_t>(idx, 0),
+                                                   [](const auto &a, const auto &b) { return a.first < b.first; });
+                     for(auto it = range.first; it != range.second; ++it)
+                       sink(it->second, optional<return_type>(result));
+                     sink(idx, std::move(result));
+                   });
+          return;
+        }
+      }
+    }
+    _execute(std::forward<U>(f), statistics, indices, durations, baseline, std::forward<Sink>(sink));
+  }
+  /* Executes every permutation at indices, or every permutation if indices is null, calling
+  sink(idx, optional<return_type> &&) with each result once complete. If durations is set, it
+  holds the predicted duration of every permutation, the longest are begun first if concurrent,
+  and the duration of each permutation executed replaces its prediction. If baseline is set,
+  the kernel times of each permutation are compared against it or recorded into it.
+  */
+  template <class U, class Sink>
+  void _execute(U &&f, statistics_type *statistics, const std::vector<size_t> *indices, std::vector<std::chrono::nanoseconds> *durations,
+                detail::performance_baseline *baseline, Sink &&sink) const
+  {
+    if constexpr(detail::is_batched_kernel<std::decay_t<U>>::value)
+      _execute_batched(std::forward<U>(f), statistics, indices, durations, std::forward<Sink>(sink));
+#if KERNELTEST_HAVE_COROUTINES
+    else if constexpr(detail::is_kernel_task<typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::callable_type>::value)
+      _execute_async(std::forward<U>(f), statistics, indices, durations, std::forward<Sink>(sink));
+#endif
+    else
+      _execute_blocking(std::forward<U>(f), statistics, indices, durations, baseline, std::forward<Sink>(sink));
+  }
+  // As _execute(), but for batched kernels
+  template <class U, class Sink>
+  void _execute_batched(U &&f, statistics_type *statistics, const std::vector<size_t> *indices, std::vector<std::chrono::nanoseconds> *durations, Sink &&sink) const
+  {
+    static_assert(sizeof...(Hooks) == 0, "Batched kernels cannot be used with hooks");
+    using return_type = typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::type;
+    using batch_type = parameter_batch<parameter_type<0>>;
+    const size_t count = (indices != nullptr) ? indices->size() : _params.size();
+    // batched_kernel is an aggregate, so may have been constructed with a size of zero directly
+    const size_t batch_size = std::max<size_t>(f.size, 1), batches = (count + batch_size - 1) / batch_size;
+    auto index_of = [&](size_t n) { return (indices != nullptr) ? (*indices)[n] : n; };
+    std::atomic<size_t> failures(0);
+    auto execute_batch = [&](size_t b, size_t)
+    {
+      const size_t begin = b * batch_size, end = std::min(count, begin + batch_size);
+      batch_type batch(end - begin);
+      for(size_t n = begin; n < end; n++)
+      {
+        // Generated parameter sequences return by value, so this may be a temporary
+        const parameter_sequence_value_type &row = _params[index_of(n)];
+        batch.push_back(index_of(n), parameter_value<0>(row));
+      }
+      std::vector<optional<return_type>> outcomes(end - begin);
+      std::chrono::nanoseconds each(0);
+      if(0 != _options.fail_fast && failures.load(std::memory_order_relaxed) >= _options.fail_fast)
+      {
+        for(auto &i : outcomes)
+          i.emplace(in_place_type<typename return_type::error_type>, make_error_code(kerneltest_errc::permutation_skipped));
+      }
+      else
+      {
+        const worker_placement placement = detail::current_placement();
+        auto kernel_begin = std::chrono::steady_clock::now();
+        KERNELTEST_EXCEPTION_TRY { f.f(static_cast<const batch_type &>(batch), span<optional<return_type>>(outcomes.data(), outcomes.size())); }
+        KERNELTEST_EXCEPTION_CATCH_ALL
+        {
+          for(auto &i : outcomes)
+            i.emplace(in_place_type<typename return_type::error_type>, make_error_code(kerneltest_errc::kernel_exception_thrown));
+        }
+        each = (std::chrono::steady_clock::now() - kernel_begin) / outcomes.size();
+        // An outcome left empty would be mistaken for one executed by another shard
+        for(auto &i : outcomes)
+        {
+          if(!i)
+            i.emplace(in_place_type<typename return_type::error_type>, make_error_code(kerneltest_errc::outcome_unassigned));
+        }
+        for(size_t n = begin; n < end; n++)
+        {
+          if(statistics != nullptr)
+          {
+            statistics[index_of(n)].kernel = each;
+            statistics[index_of(n)].placement = placement;
+          }
+          if(0 != _options.fail_fast && !detail::check_result(outcomes[n - begin], outcome_value(_params[index_of(n)])))
+            failures.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+      for(size_t n = begin; n < end; n++)
+      {
+        if(durations != nullptr)
+          (*durations)[index_of(n)] = each;
+        sink(index_of(n), std::move(outcomes[n - begin]));
+      }
+    };
+    if(is_multithreaded)
+      executor().run(batches, execute_batch);
+    else
+    {
+      for(size_t b = 0; b < batches; b++)
+        execute_batch(b, 0);
+    }
+  }
+#if KERNELTEST_HAVE_COROUTINES
+  // As _execute(), but for kernels which are coroutines
+  template <class U, class Sink>
+  void _execute_async(U &&f, statistics_type *statistics, const std::vector<size_t> *indices, std::vector<std::chrono::nanoseconds> *durations, Sink &&sink) const
+  {
+    const size_t count = (indices != nullptr) ? indices->size() : _params.size();
+    std::vector<size_t> order;
+    if(durations != nullptr)
+    {
+      order = detail::longest_first(count, *durations, [&](size_t n) { return (indices != nullptr) ? (*indices)[n] : n; });
+    }
+    auto index_of = [&](size_t n)
+    {
+      if(!order.empty())
+        n = order[n];
+      return (indices != nullptr) ? (*indices)[n] : n;
+    };
+    using return_type = typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::type;
+    std::atomic<size_t> next(0), failures(0);
+    // Each permutation is a coroutine instantiating its hooks, awaiting the kernel, then destroying the hooks
+    auto permute_one = [&](size_t idx) -> detail::detached_task
+    {
+      using callable_parameters_type = parameter_type<0>;
+      const auto begin = std::chrono::steady_clock::now();
+      statistics_type *stats = (statistics != nullptr) ? statistics + idx : nullptr;
+      optional<return_type> result;
       int stage = 0;
+      if(0 != _options.fail_fast && failures.load(std::memory_order_relaxed) >= _options.fail_fast)
+      {
+        result.emplace(in_place_type<typename return_type::error_type>, make_error_code(kerneltest_errc::permutation_skipped));
+        sink(idx, std::move(result));
+        co_return;
+      }
+      // The loop destroys this coroutine if it stalls, whereupon this fails the permutation after its hooks are torn down
+      auto stalled = make_scope_exit(
+      [&]() noexcept
+      {
+        optional<return_type> failed;
+        failed.emplace(in_place_type<typename return_type::error_type>, make_error_code(kerneltest_errc::kernel_stalled));
+        if(0 != _options.fail_fast)
+          failures.fetch_add(1, std::memory_order_relaxed);
+        sink(idx, std::move(failed));
+      });
+      if(stats != nullptr)
+        stats->placement = detail::current_placement();
+      {
+        // Generated parameter sequences return by value, so this may be a temporary
+        const parameter_sequence_value_type &row = _params[idx];
+        const callable_parameters_type &p = parameter_value<0>(row);
+        KERNELTEST_EXCEPTION_TRY
+        {
+          auto hooks(detail::instantiate_hooks(_hooks, this, result, idx, row, std::make_index_sequence<sizeof...(Hooks)>(),
+                                               (stats != nullptr) ? stats->hook_setup.data() : nullptr,
+                                               (stats != nullptr) ? stats->hook_teardown.data() : nullptr));
+          (void) hooks;
+          stage = 1;
+          auto kernel_begin = std::chrono::steady_clock::now();
+          result = co_await detail::call_f_with_parameters(f, p, std::make_index_sequence<KERNELTEST_V1_NAMESPACE::parameters_size<callable_parameters_type>::value>());
+          if(stats != nullptr)
+            stats->kernel = std::chrono::steady_clock::now() - kernel_begin;
+          stage = 2;
+        }
+        KERNELTEST_EXCEPTION_CATCH_ALL
+        {
+          result.emplace(in_place_type<typename return_type::error_type>, make_error_code(detail::exception_errc(stage)));
+        }
+        if(0 != _options.fail_fast && !detail::check_result(result, outcome_value(row)))
+          failures.fetch_add(1, std::memory_order_relaxed);
+      }
+      if(durations != nullptr)
+        (*durations)[idx] = std::chrono::steady_clock::now() - begin;
+      stalled.release();
+      sink(idx, std::move(result));
+    };
+    // Each thread keeps up to max_in_flight permutations executing upon its own loop, or one if any hook cannot interleave
+    const size_t in_flight = (detail::is_interleavable_hook<Hooks>::value && ... && true) ? std::max<size_t>(_options.max_in_flight, 1) : 1;
+    auto run_loop = [&](size_t, size_t)
+    {
+      event_loop loop;
+      if(!loop.is_valid())
+      {
+        KERNELTEST_CERR("FATAL: Could not create an event loop for coroutine kernels" << std::endl);
+        abort();
+      }
+      for(bool more = true; more || loop.active() > 0;)
+      {
+        while(more && loop.active() < in_flight)
+        {
+          const size_t n = next.fetch_add(1, std::memory_order_relaxed);
+          if(n >= count)
+          {
+            more = false;
+            break;
+          }
+          loop.spawn(permute_one(index_of(n)));
+        }
+        loop.run_once();
+      }
+    };
+    if(is_multithreaded && count > in_flight)
+      executor().run(std::max<size_t>(executor().concurrency(), 1), run_loop);
+    else
+      run_loop(0, 0);
+  }
+#endif
+  template <class U, class Sink>
+  void _execute_blocking(U &&f, statistics_type *statistics, const std::vector<size_t> *indices, std::vector<std::chrono::nanoseconds> *durations,
+                         detail::performance_baseline *baseline, Sink &&sink) const
+  {
+    const size_t count = (indices != nullptr) ? indices->size() : _params.size();
+    // The return type of the kernel callable
+    using return_type = typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::type;
+    // Permutations have deadlines if there is a timeout, or if any hook might set one
+    const bool watched = _options.timeout.count() > 0 || (detail::sets_permutation_deadline<Hooks>::value || ... || false);
+    /* A worker of the executor executing a permutation past its deadline is abandoned, but a single
+    threaded permuter's only thread is the caller's, so its permutations are isolated if they can be
+    */
+    optional<process_isolation_options> isolation = _options.isolation;
+#ifndef _WIN32
+    if constexpr(!is_multithreaded)
+    {
+      if(watched && !isolation && (detail::portable_outcome<return_type>::value_is_void || detail::portable_outcome<return_type>::value_is_trivial))
+      {
+        KERNELTEST_CERR("WARNING: Executing the permutations of a single threaded permuter with a timeout in child processes, so that they may be killed"
+                        << std::endl);
+        isolation.emplace();
+      }
+    }
+#endif
+    // If set, the order in which to begin the permutations
+    std::vector<size_t> order;
+    if(durations != nullptr && (is_multithreaded || isolation))
+    {
+      order = detail::longest_first(count, *durations, [&](size_t n) { return (indices != nullptr) ? (*indices)[n] : n; });
+    }
+    auto index_of = [&](size_t n)
+    {
+      if(!order.empty())
+        n = order[n];
+      return (indices != nullptr) ? (*indices)[n] : n;
+    };
+    optional<detail::permutation_watchdog> watchdog;
+    /* Each worker keeps the instances of resettable hooks between its permutations. Not when
+    isolated, as instances created within child processes would never be destroyed, nor when
+    watched, as the instances of an abandoned permutation remain in use by it.
+    */
+    std::vector<detail::hook_pool> pools;
+    if((detail::is_resettable_hook<Hooks>::value || ... || false) && !isolation && !watched)
+      pools.resize(is_multithreaded ? std::max<size_t>(executor().concurrency(), 1) : 1);
+    auto pool_of = [&](size_t worker) { return (worker < pools.size()) ? &pools[worker] : nullptr; };
+    // Kernel allocations are tracked if asked for, or if any hook checks them
+    const bool tracks_allocations = (statistics != nullptr && _options.allocations) || (detail::tracks_allocations<Hooks>::value || ... || false);
+    /* Each permutation works upon its own result, which is only handed to sink once
+    complete. stage is 0 during setup, 1 during the kernel and 2 during teardown.
+    */
+    auto call_f = [&](size_t idx, statistics_type *stats, volatile int &stage, optional<return_type> &result, detail::hook_pool *pool)
+    {
+      stage = 0;
+      if(stats != nullptr)
+        stats->placement = detail::current_placement();
       auto nested_f = [&](size_t idx)
       {
         using callable_parameters_type = parameter_type<0>;
-        const callable_parameters_type &p = parameter_value<0>(**params[idx]);
+        // Generated parameter sequences return by value, so this may be a temporary
+        const parameter_sequence_value_type &row = _params[idx];
+        const callable_parameters_type &p = parameter_value<0>(row);
         KERNELTEST_EXCEPTION_TRY
         {
           // Instantiate the hooks
-          auto hooks(detail::instantiate_hooks(_hooks, this, results[idx], idx, **params[idx], std::make_index_sequence<sizeof...(Hooks)>()));
+          auto hooks(detail::instantiate_hooks(_hooks, this, result, idx, row, std::make_index_sequence<sizeof...(Hooks)>(),
+                                               (stats != nullptr) ? stats->hook_setup.data() : nullptr,
+                                               (stats != nullptr) ? stats->hook_teardown.data() : nullptr, pool));
           (void) hooks;
+          detail::park_if_abandoned();
           stage = 1;
           // Call the kernel
-          results[idx] = detail::call_f_with_parameters(std::forward<U>(f), p,
+          detail::thread_counters *counters = (stats != nullptr && _options.counters) ? &detail::this_thread_counters() : nullptr;
+          if(counters != nullptr)
+            counters->start();
+          optional<detail::allocation_window> allocations;
+          if(tracks_allocations)
+            allocations.emplace((stats != nullptr) ? &stats->allocations : nullptr);
+          auto begin = (stats != nullptr) ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+          result = detail::call_f_with_parameters(std::forward<U>(f), p,
                                                         std::make_index_sequence<KERNELTEST_V1_NAMESPACE::parameters_size<callable_parameters_type>::value>());
+          // Tearing down the hooks of an abandoned permutation would touch a permuter which may have returned
+          detail::park_if_abandoned();
+          if(stats != nullptr)
+            stats->kernel = std::chrono::steady_clock::now() - begin;
+          allocations.reset();
+          if(counters != nullptr)
+            stats->counters = counters->stop();
           stage = 2;
         }
         KERNELTEST_EXCEPTION_CATCH_ALL
         {
-          kerneltest_errc code = kerneltest_errc::setup_exception_thrown;
-          if(1 == stage)
-            code = kerneltest_errc::kernel_exception_thrown;
-          else if(2 == stage)
-            code = kerneltest_errc::teardown_exception_thrown;
+          kerneltest_errc code = detail::exception_errc(stage);
           KERNELTEST_EXCEPTION_TRY
           {
             KERNELTEST_EXCEPTION_RETHROW;
@@ -374,7 +1456,7 @@ public:
           }
           KERNELTEST_EXCEPTION_CATCH_ALL {}
 #if 1
-          results[idx] = return_type(in_place_type<typename return_type::error_type>, make_error_code(code));
+          result.emplace(in_place_type<typename return_type::error_type>, make_error_code(code));
 //! \todo If permuter kernel output is an outcome, return a nested exception ptr assuming compilers have caught up by then
 #else
           KERNELTEST_EXCEPTION_TRY
@@ -383,17 +1465,59 @@ public:
           }
           KERNELTEST_EXCEPTION_CATCH_ALL
           {
-            results[idx].set_exception(std::current_exception());
+            result.set_exception(std::current_exception());
           }
 #endif
         }
       };
-//! \todo Need to install signal handlers for each permutation execution thread somehow
+      // Executes the permutation, recovering from any synchronous signal it raises if capturing them
+      auto guarded_f = [&](size_t idx)
+      {
+#ifndef _WIN32
+        if(_options.capture_signals)
+        {
+          detail::install_signal_capture();
+          detail::signal_recovery_point recovery;
+          // The jump skips the permutation's own cleanup, so whatever it would have restored is saved here
+          const detail::allocation_tally allocations = detail::this_thread_allocations();
+          if(pool != nullptr)
+            pool->begin();
+          if(sigsetjmp(recovery.buf, 0) != 0)
+          {
+            detail::this_thread_allocations() = allocations;
+            if(stats != nullptr && _options.counters)
+              (void) detail::this_thread_counters().stop();
+            if(pool != nullptr)
+              pool->discard_in_use();
+            KERNELTEST_CERR("WARNING: Permutation " << (idx + 1) << " raised signal " << recovery.signo << std::endl);
+            result.emplace(in_place_type<typename return_type::error_type>, make_error_code(detail::signal_errc(stage)));
+            return;
+          }
+          recovery.arm();
+          nested_f(idx);
+          return;
+        }
+#endif
+        nested_f(idx);
+      };
+      if(watchdog)
+      {
+        // Once abandoned, neither the watchdog nor anything else here may still exist
+        detail::watched_permutation watch;
+        watchdog->begin(watch, idx, &stage);
+        guarded_f(idx);
+        if(!detail::permutation_watchdog::finish(watch))
+          detail::park_if_abandoned();
+        watchdog->end(watch);
+        if(watch.expired.load(std::memory_order_acquire))
+          result.emplace(in_place_type<typename return_type::error_type>, make_error_code(detail::timeout_errc(watch.expired_stage.load(std::memory_order_relaxed))));
+        return;
+      }
 #if 0  // def _WIN32
       __try
       {
 #endif
-      nested_f(idx);
+      guarded_f(idx);
 #if 0  // def _WIN32
     }
 #if 0  // def _MSC_VER
@@ -407,31 +1531,273 @@ public:
         code = kerneltest_errc::kernel_seh_exception_thrown;
       else if(2 == stage)
         code = kerneltest_errc::teardown_seh_exception_thrown;
-      results[idx] = {make_error_code(code)};
+      result = {make_error_code(code)};
     }
 #ifdef _MSC_VER
 #pragma warning(pop)
 #endif
 #endif
     };
-#ifdef _OPENMP
-    if(is_multithreaded)
+    // Records the kernel times of the permutation into the baseline, or fails it if they regressed from those recorded
+    auto judge = [&](size_t idx, const std::vector<std::chrono::nanoseconds> &samples, optional<return_type> &result)
+    {
+      if(baseline->options().record)
+        baseline->record(idx, baseline->summarise(idx, samples));
+      else if(detail::check_result(result, outcome_value(_params[idx])))
+      {
+        double ratio = 1, p = 1;
+        if(baseline->regressed(idx, samples, ratio, p))
+        {
+          KERNELTEST_CERR("WARNING: Permutation " << (idx + 1) << " kernel time regressed to " << ratio << "x that of the baseline (p = " << p << ")" << std::endl);
+          result.emplace(in_place_type<typename return_type::error_type>, make_error_code(kerneltest_errc::performance_regressed));
+        }
+      }
+    };
+    // Executes the permutation, repeating it if benchmarking or comparing against a baseline
+    auto permute_one = [&](size_t idx, volatile int &stage, optional<return_type> &result, detail::hook_pool *pool)
     {
-#pragma omp parallel for
-      for(size_t n = 0; n < results.size(); n++)
-        call_f(n);
+      statistics_type *stats = (statistics != nullptr) ? statistics + idx : nullptr;
+      if(!_options.benchmark && baseline == nullptr)
+        return call_f(idx, stats, stage, result, pool);
+      statistics_type sample;
+      std::vector<std::chrono::nanoseconds> samples;
+      benchmark_statistics summary = detail::benchmark(
+      _options.benchmark ? *_options.benchmark : benchmark_options(),
+      [&]
+      {
+        sample = statistics_type();
+        call_f(idx, &sample, stage, result, pool);
+        return sample.kernel;
+      },
+      (baseline != nullptr) ? &samples : nullptr);
+      if(stats != nullptr)
+      {
+        *stats = sample;
+        stats->kernel = summary.median;
+        stats->benchmark = summary;
+      }
+      if(baseline != nullptr)
+        judge(idx, samples, result);
+    };
+    // Counts failures for fail fast cancellation, in shared memory if isolated
+    std::atomic<size_t> local_failures(0), *failures = &local_failures;
+    auto is_failure = [&](size_t idx, const optional<return_type> &result) { return !detail::check_result(result, outcome_value(_params[idx])); };
+    // Executes the permutation unless fail fast cancellation has occurred
+    auto execute_one = [&](size_t idx, volatile int &stage, optional<return_type> &result, detail::hook_pool *pool)
+    {
+      if(0 == _options.fail_fast)
+        return permute_one(idx, stage, result, pool);
+      if(failures->load(std::memory_order_relaxed) >= _options.fail_fast)
+      {
+        result.emplace(in_place_type<typename return_type::error_type>, make_error_code(kerneltest_errc::permutation_skipped));
+        return;
+      }
+      permute_one(idx, stage, result, pool);
+      if(is_failure(idx, result))
+        failures->fetch_add(1, std::memory_order_relaxed);
+    };
+    // Executes the permutation, measuring its duration if scheduling
+    auto measure_one = [&](size_t idx, volatile int &stage, optional<return_type> &result, detail::hook_pool *pool)
+    {
+      if(durations == nullptr)
+        return execute_one(idx, stage, result, pool);
+      auto begin = std::chrono::steady_clock::now();
+      execute_one(idx, stage, result, pool);
+      (*durations)[idx] = std::chrono::steady_clock::now() - begin;
+    };
+    if(watched && !isolation)
+    {
+      /* A permutation upon a worker of the executor is abandoned along with the worker, which
+      the executor replaces, so the permutation's failure is reported from here. Any other is
+      failed once it returns, as nothing can make it return.
+      */
+      watchdog.emplace(_options.timeout,
+                       [&](detail::watched_permutation &w)
+                       {
+                         const size_t idx = w.idx;
+                         bool abandoned = false;
+                         if constexpr(is_multithreaded)
+                           abandoned = executor().abandon(w.thread);
+                         if(abandoned)
+                         {
+                           KERNELTEST_CERR("WARNING: Permutation " << (idx + 1) << " timed out, so its worker thread was abandoned" << std::endl);
+                         }
+                         else
+                         {
+                           KERNELTEST_CERR("WARNING: Permutation " << (idx + 1) << " timed out, and will fail once it returns" << std::endl);
+                         }
+                         if constexpr(detail::are_parameters_ostreamable<parameter_type<0>>::value)
+                           detail::pretty_print_preamble(*this, idx);
+                         if(abandoned)
+                         {
+                           optional<return_type> result;
+                           result.emplace(in_place_type<typename return_type::error_type>,
+                                          make_error_code(detail::timeout_errc(w.expired_stage.load(std::memory_order_relaxed))));
+                           if(_options.fail_fast > 0 && is_failure(idx, result))
+                             failures->fetch_add(1, std::memory_order_relaxed);
+                           sink(idx, std::move(result));
+                         }
+                         return abandoned;
+                       });
+    }
+#ifndef _WIN32
+    if(isolation)
+    {
+      // Each child process writes what it did into shared memory
+      struct isolated_slot
+      {
+        detail::portable_outcome<return_type> result;
+        statistics_type stats;
+        std::chrono::nanoseconds duration;
+        detail::baseline_entry recorded;
+        bool done;
+      };
+      static_assert(std::is_trivially_copyable<statistics_type>::value, "statistics_type must be trivially copyable for process isolation");
+      detail::shared_mapping mapping(sizeof(isolated_slot) * count);
+      auto *slots = static_cast<isolated_slot *>(mapping.data());
+      for(size_t n = 0; n < count; n++)
+        new(slots + n) isolated_slot{};
+      detail::shared_mapping failures_mapping(sizeof(std::atomic<size_t>));
+      failures = new(failures_mapping.data()) std::atomic<size_t>(0);
+      size_t processes = isolation->processes;
+      if(0 == processes)
+        processes = is_multithreaded ? std::max<size_t>(executor().concurrency(), 1) : 1;
+      detail::run_isolated(
+      count, processes, watched, _options.timeout,
+      [&](size_t n, volatile int &stage)
+      {
+        const size_t idx = index_of(n);
+        optional<return_type> result;
+        measure_one(idx, stage, result, nullptr);
+        slots[n].result.store(result);
+        if(statistics != nullptr)
+          slots[n].stats = statistics[idx];
+        if(durations != nullptr)
+          slots[n].duration = (*durations)[idx];
+        if(baseline != nullptr)
+          slots[n].recorded = baseline->recorded(idx);
+        slots[n].done = true;
+      },
+      [&](size_t n, int stage, int signo, bool timed_out)
+      {
+        if(slots[n].done)
+          return;
+        const size_t idx = index_of(n);
+        if(timed_out)
+        {
+          KERNELTEST_CERR("WARNING: Permutation " << (idx + 1) << " timed out, so its child process was killed" << std::endl);
+          if constexpr(detail::are_parameters_ostreamable<parameter_type<0>>::value)
+            detail::pretty_print_preamble(*this, idx);
+        }
+        else if(signo != 0)
+        {
+          KERNELTEST_CERR("WARNING: Permutation " << (idx + 1) << " raised signal " << signo << std::endl);
+        }
+        else
+        {
+          KERNELTEST_CERR("WARNING: Permutation " << (idx + 1) << " exited the process" << std::endl);
+        }
+        optional<return_type> result;
+        result.emplace(in_place_type<typename return_type::error_type>, make_error_code(timed_out ? detail::timeout_errc(stage) : detail::signal_errc(stage)));
+        slots[n].result.store(result);
+        slots[n].done = true;
+        if(_options.fail_fast > 0 && is_failure(idx, result))
+          failures->fetch_add(1, std::memory_order_relaxed);
+      });
+      for(size_t n = 0; n < count; n++)
+      {
+        if(!slots[n].done)
+        {
+          // Claimed by a child which died before it could say so
+          optional<return_type> result;
+          result.emplace(in_place_type<typename return_type::error_type>, make_error_code(kerneltest_errc::permutation_not_executed));
+          slots[n].result.store(result);
+        }
+        sink(index_of(n), slots[n].result.load());
+        if(statistics != nullptr)
+          statistics[index_of(n)] = slots[n].stats;
+        if(durations != nullptr && slots[n].duration.count() > 0)
+          (*durations)[index_of(n)] = slots[n].duration;
+        if(baseline != nullptr && slots[n].recorded.count > 0)
+          baseline->record(index_of(n), slots[n].recorded);
+      }
     }
     else
 #endif
+      if(is_multithreaded)
     {
-      for(size_t n = 0; n < results.size(); n++)
-        call_f(n);
+      auto execute_at = [&](size_t n, size_t worker)
+      {
+        volatile int stage = 0;
+        optional<return_type> result;
+        measure_one(index_of(n), stage, result, pool_of(worker));
+        sink(index_of(n), std::move(result));
+      };
+      if(!order.empty())
+        executor().run_in_order(count, execute_at);
+      else
+        executor().run(count, execute_at, permutation_results_type<return_type>::chunk_size);
+    }
+    else
+    {
+      for(size_t n = 0; n < count; n++)
+      {
+        volatile int stage = 0;
+        optional<return_type> result;
+        measure_one(index_of(n), stage, result, pool_of(0));
+        sink(index_of(n), std::move(result));
+      }
     }
+  }
+
+public:
+  /*! Rebuilds the results of every permutation from the files written by each shard of this
+  permuter's parameter sequence (see `shard_options::output`), ready to be checked with `check()`.
+  As with process isolation, kernel outcome values are only preserved if trivially copyable,
+  else become `kerneltest_errc::outcome_not_transportable`. Only the results of this table and
+  kernel are merged, as identified by the test kernel and `permute_options::table_name`, so
+  this must be called from the same test kernel as the shards were executed from.
+  \return The results, `kerneltest_errc::shard_results_invalid` if a file is malformed, or
+  `kerneltest_errc::shard_results_incomplete` if any permutation was not executed by exactly one shard.
+  \param f The kernel callable which the shards executed, which is not called
+  \param paths The files written by each shard
+  */
+  template <class U>
+  result<permutation_results_type<typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::type>> merge_shards(U &&f,
+                                                                                                                                   const std::vector<std::string> &paths) const
+  {
+    using return_type = typename detail::result_of_parameter_permute<parameter_sequence_value_type, U>::type;
+    (void) f;
+    const std::string table = _table<U>();
+    permutation_results_type<return_type> results(_params.size());
+    std::vector<bool> seen(_params.size());
+    for(const auto &path : paths)
+    {
+      OUTCOME_TRYV(detail::read_shard_results(path, table, results, seen));
+    }
+    if(std::find(seen.begin(), seen.end(), false) != seen.end())
+      return make_error_code(kerneltest_errc::shard_results_incomplete);
     return results;
   }
 
+  /*! Whether a call of the permuter executes each permutation, being all of them unless sharded
+  (see `permute_options::shard`), when only the results of the permutations of the shard are present.
+  */
+  std::vector<bool> in_shard() const
+  {
+    optional<shard_options> shard = _shard();
+    if(!shard)
+      return std::vector<bool>(_params.size(), true);
+    std::vector<bool> ret(_params.size(), false);
+    for(size_t idx : detail::shard_indices(_params.size(), *shard))
+      ret[idx] = true;
+    return ret;
+  }
+
   /*! Checks a sequence of results against what they ought to be, calling the callable f with the results
-  \return True if all the results match
+  \return True if all the results match. Skipped results (see `permute_options::fail_fast`) are
+  neither passed nor failed, but do not match. Results not present are ignored if executed by
+  another shard (see `in_shard()`), else fail as `kerneltest_errc::permutation_not_executed`.
   \throws invalid_argument If the results passed is not of the same length as the parameter permute sequence
   \param results A sequence of results to check
   \param fail Some callable with callspec bool(size_t, value, shouldbe) called if the values do not match
@@ -447,13 +1813,26 @@ public:
       abort();
 #endif
     bool ret = true;
+    const std::vector<bool> executed = in_shard();
     auto it(sequence.cbegin());
     size_t idx = 0;
-    for(auto &i : _params)
+    for(const auto &i : _params)
     {
       const outcome_type &shouldbe = outcome_value(i);
       const auto &outcome = *it;
-      if(detail::check_result(outcome, shouldbe))
+      if(!outcome)
+      {
+        // Not present because executed by some other shard, else it ought to have been
+        if(executed[idx])
+        {
+          const auto missing = detail::not_executed_result(outcome);
+          if(!fail(idx, missing, shouldbe))
+            ret = false;
+        }
+      }
+      else if(detail::is_skipped(outcome))
+        ret = false;
+      else if(detail::check_result(outcome, shouldbe))
       {
         if(!pass(idx, outcome, shouldbe))
           ret = false;
@@ -477,12 +1856,11 @@ public:
 
 namespace detail
 {
-  template <class ParamSequence, class OutcomeType, class... Parameters> struct is_parameters_sequence_type_valid : std::false_type
-  {
-  };
-  template <class OutcomeType, class... Parameters, template <class...> class Container>
-  struct is_parameters_sequence_type_valid<Container<parameters<OutcomeType, Parameters...>>, OutcomeType, Parameters...> : std::true_type
+  template <class ParamSequence, class OutcomeType, class... Parameters> struct is_parameters_sequence_type_valid
   {
+    template <class T> static std::is_same<typename T::value_type, parameters<OutcomeType, Parameters...>> test(T *);
+    template <class T> static std::false_type test(...);
+    static constexpr bool value = decltype(test<ParamSequence>(nullptr))::value;
   };
   template <class T, size_t N, size_t... Idxs> auto array_from_Carray(const T (&seq)[N], std::index_sequence<Idxs...>)
   {
@@ -499,7 +1877,7 @@ namespace detail
 */
 template <class OutcomeType, class... Parameters, class Sequence, class... Hooks,
           typename = typename std::enable_if<detail::is_parameters_sequence_type_valid<Sequence, OutcomeType, Parameters...>::value>::type>
-constexpr parameter_permuter<true, Sequence> st_permute_parameters(Sequence &&seq, Hooks &&...hooks)
+constexpr parameter_permuter<false, Sequence, Hooks...> st_permute_parameters(Sequence &&seq, Hooks &&...hooks)
 {
   return parameter_permuter<false, Sequence, Hooks...>(std::forward<Sequence>(seq), std::tuple<Hooks...>(std::forward<Hooks>(hooks)...));
 }
@@ -520,7 +1898,7 @@ template <class... Parameters, size_t N, class... Hooks> constexpr auto st_permu
 */
 template <class OutcomeType, class... Parameters, class Sequence, class... Hooks,
           typename = typename std::enable_if<detail::is_parameters_sequence_type_valid<Sequence, OutcomeType, Parameters...>::value>::type>
-constexpr parameter_permuter<true, Sequence> mt_permute_parameters(Sequence &&seq, Hooks &&...hooks)
+constexpr parameter_permuter<true, Sequence, Hooks...> mt_permute_parameters(Sequence &&seq, Hooks &&...hooks)
 {
   return parameter_permuter<true, Sequence, Hooks...>(std::forward<Sequence>(seq), std::tuple<Hooks...>(std::forward<Hooks>(hooks)...));
 }
@@ -532,6 +1910,37 @@ template <class... Parameters, size_t N, class... Hooks> constexpr auto mt_permu
   detail::array_from_Carray<parameters<Parameters...>, N>(seq, std::make_index_sequence<N>()), std::tuple<Hooks...>(std::forward<Hooks>(hooks)...));
 }
 
+/*! \brief Create a single threaded parameter permuter which benchmarks each permutation
+\tparam OutcomeType An outcome<T>, result<T> or option<T> for the outcome of the test kernel
+\tparam InputTypes The types of the parameters of the test kernel
+\tparam Sequence The type of the sequence containing the parameter sets
+\tparam Hooks The types of any pretest or posttest hooks
+\param seq The sequence of parameter sets
+
+Each permutation is executed `benchmark_options::warmup` times, and then repeatedly until the 95%
+confidence interval on the median kernel time is tight enough or a time cap is reached, with the
+hooks constructed and destructed around every repetition. Only the kernel is timed. Call the
+permuter with a `statistics_sequence_type` to retrieve the distributions, and the results are
+those of the final repetitions. Adjust `options().benchmark` to change the stopping criteria.
+*/
+template <class OutcomeType, class... Parameters, class Sequence, class... Hooks,
+          typename = typename std::enable_if<detail::is_parameters_sequence_type_valid<Sequence, OutcomeType, Parameters...>::value>::type>
+parameter_permuter<false, Sequence, Hooks...> bench_permute_parameters(Sequence &&seq, Hooks &&...hooks)
+{
+  parameter_permuter<false, Sequence, Hooks...> ret(std::forward<Sequence>(seq), std::tuple<Hooks...>(std::forward<Hooks>(hooks)...));
+  ret.options().benchmark.emplace();
+  return ret;
+}
+//! \overload
+template <class... Parameters, size_t N, class... Hooks> auto bench_permute_parameters(const parameters<Parameters...> (&seq)[N], Hooks &&...hooks)
+{
+  // Convert C type arrays into std::array
+  parameter_permuter<false, std::array<parameters<Parameters...>, N>, Hooks...> ret(
+  detail::array_from_Carray<parameters<Parameters...>, N>(seq, std::make_index_sequence<N>()), std::tuple<Hooks...>(std::forward<Hooks>(hooks)...));
+  ret.options().benchmark.emplace();
+  return ret;
+}
+
 namespace detail
 {
 #ifdef _MSC_VER
@@ -540,26 +1949,32 @@ namespace detail
 #endif
   class _print_params
   {
-    template <bool first> static void _do() {}
-    template <bool first, class T, class... Types> static void _do(T &&v, Types &&...vs)
+    std::ostream &_os;
+    template <bool first> void _do() const {}
+    template <bool first, class T, class... Types> void _do(T &&v, Types &&...vs) const
     {
       if(!first)
-        KERNELTEST_COUT(", ");
-      KERNELTEST_COUT(v);
+        _os << ", ";
+      _os << v;
       _do<false>(std::forward<Types>(vs)...);
     };
 
   public:
+    _print_params(std::ostream &os)
+        : _os(os)
+    {
+    }
     template <class... Types> void operator()(Types &&...vs) const { _do<true>(std::forward<Types>(vs)...); }
   };
   template <class Permuter> class _print_hook
   {
+    std::ostream &_os;
     const typename Permuter::parameter_sequence_value_type &_v;
     template <size_t Idx> void _do() const {}
     template <size_t Idx, class T, class... Types> void _do(T &&v, Types &&...vs) const
     {
       if(Idx > 0)
-        KERNELTEST_COUT(", ");
+        _os << ", ";
       // Fetch the hook parameter set for this hook
       using hook_pars_type = typename Permuter::template parameter_type<1 + Idx>;
       // #ifdef __c2__  // c2 be buggy
@@ -569,40 +1984,60 @@ namespace detail
       // #endif
       //  Each hook instantiator exposes a member function print(...) which takes
       //  the same args as the hook instance
-      detail::call_f_with_parameters([&v](const auto &...vs) { KERNELTEST_COUT(v.print(vs...)); }, hook_pars,
+      detail::call_f_with_parameters([this, &v](const auto &...vs) { _os << v.print(vs...); }, hook_pars,
                                      std::make_index_sequence<parameters_size<hook_pars_type>::value>());
       _do<Idx + 1>(std::forward<Types>(vs)...);
     };
 
   public:
-    _print_hook(const typename Permuter::parameter_sequence_value_type &v)
-        : _v(v)
+    _print_hook(std::ostream &os, const typename Permuter::parameter_sequence_value_type &v)
+        : _os(os)
+        , _v(v)
     {
     }
     template <class... Types> void operator()(Types &&...vs) const { _do<0>(std::forward<Types>(vs)...); }
   };
-  template <class Permuter> void pretty_print_preamble(const Permuter &_permuter, size_t idx)
+  template <class Permuter> void print_permutation(std::ostream &os, const Permuter &_permuter, size_t idx)
   {
-    using namespace QUICKCPPLIB_NAMESPACE::console_colours;
-    KERNELTEST_COUT("  " << yellow << (idx + 1) << "/" << _permuter.parameter_sequence().size() << ": " << normal);
-    auto parameter_sequence_item_it = _permuter.parameter_sequence().cbegin();
-    std::advance(parameter_sequence_item_it, idx);
+    // Generated parameter sequences return by value, so this may be a temporary
+    const typename Permuter::parameter_sequence_value_type &parameter_sequence_item = _permuter.parameter_sequence()[idx];
     // Print kernel parameters we called the kernel with
     {
-      KERNELTEST_COUT("kernel(");
-      const auto &pars = std::get<1>(*parameter_sequence_item_it);
+      os << "kernel(";
+      const auto &pars = std::get<1>(parameter_sequence_item);
       using pars_type = typename std::decay<decltype(pars)>::type;
-      detail::call_f_with_parameters(_print_params(), pars, std::make_index_sequence<parameters_size<pars_type>::value>());
-      KERNELTEST_COUT(")");
+      detail::call_f_with_parameters(_print_params(os), pars, std::make_index_sequence<parameters_size<pars_type>::value>());
+      os << ")";
     }
     // If there are any hooks, print those
     if(Permuter::hook_sequence_size > 0)
     {
-      KERNELTEST_COUT(" with ");
+      os << " with ";
       const auto &hooks = _permuter.hooks();
-      detail::call_f_with_tuple(_print_hook<Permuter>(*parameter_sequence_item_it), hooks, std::make_index_sequence<Permuter::hook_sequence_size>());
+      detail::call_f_with_tuple(_print_hook<Permuter>(os, parameter_sequence_item), hooks, std::make_index_sequence<Permuter::hook_sequence_size>());
     }
-    KERNELTEST_COUT("\n");
+  }
+  template <class Permuter, size_t... Idxs>
+  void print_hook_parameters(std::ostream &os, const typename Permuter::parameter_sequence_value_type &parameter_sequence_item, std::index_sequence<Idxs...>)
+  {
+    ((os << " [",
+      detail::call_f_with_parameters(_print_params(os), Permuter::template parameter_value<1 + Idxs>(parameter_sequence_item),
+                                     std::make_index_sequence<parameters_size<typename Permuter::template parameter_type<1 + Idxs>>::value>()),
+      os << "]"),
+     ...);
+  }
+  template <class Permuter> void describe_permutation(std::ostream &os, const Permuter &_permuter, size_t idx)
+  {
+    print_permutation(os, _permuter, idx);
+    const typename Permuter::parameter_sequence_value_type &parameter_sequence_item = _permuter.parameter_sequence()[idx];
+    print_hook_parameters<Permuter>(os, parameter_sequence_item, std::make_index_sequence<Permuter::hook_sequence_size>());
+  }
+  template <class Permuter> void pretty_print_preamble(const Permuter &_permuter, size_t idx)
+  {
+    using namespace QUICKCPPLIB_NAMESPACE::console_colours;
+    std::ostringstream description;
+    print_permutation(description, _permuter, idx);
+    KERNELTEST_COUT("  " << yellow << (idx + 1) << "/" << _permuter.parameter_sequence().size() << ": " << normal << description.str() << "\n");
   }
 
   template <class Permuter, class U> class pretty_print_failure_impl
@@ -622,7 +2057,7 @@ namespace detail
       using namespace QUICKCPPLIB_NAMESPACE::console_colours;
       pretty_print_preamble(_permuter, idx);
       KERNELTEST_COUT("    " << bold << red << "FAILED" << normal << " (should be " << bold << print(shouldbe) << normal << ", was " << bold << print(*result)
-                             << normal << ")" << std::endl);
+                             << normal << ")\n");
       _f(result, shouldbe);
       return false;
     }
@@ -643,7 +2078,7 @@ namespace detail
     {
       using namespace QUICKCPPLIB_NAMESPACE::console_colours;
       pretty_print_preamble(_permuter, idx);
-      KERNELTEST_COUT("    " << bold << green << "PASSED " << normal << print(*result) << std::endl);
+      KERNELTEST_COUT("    " << bold << green << "PASSED " << normal << print(*result) << "\n");
       _f(result, shouldbe);
       return true;
     }
@@ -662,6 +2097,90 @@ template <class Permuter> auto pretty_print_failure(const Permuter &s)
 {
   return pretty_print_failure(s, [](const auto &, const auto &) {});
 }
+//! Colourfully prints the kernel time distribution of every benchmarked permutation
+template <class Permuter> void pretty_print_benchmark(const Permuter &s, const typename Permuter::statistics_sequence_type &statistics)
+{
+  using namespace QUICKCPPLIB_NAMESPACE::console_colours;
+  for(size_t idx = 0; idx < statistics.size(); idx++)
+  {
+    if(statistics[idx].benchmark)
+    {
+      detail::pretty_print_preamble(s, idx);
+      KERNELTEST_COUT("    " << bold << blue << "BENCHMARK " << normal << *statistics[idx].benchmark);
+      const worker_placement &placement = statistics[idx].placement;
+      if(placement.cpu >= 0)
+      {
+        KERNELTEST_COUT(" on CPU " << placement.cpu << " node " << placement.node << (placement.pinned ? " (pinned)" : ""));
+      }
+      KERNELTEST_COUT("\n");
+    }
+  }
+}
+/*! Colourfully prints the performance events counted for every permutation, followed by their
+totals (see `permute_options::counters`).
+*/
+template <class Permuter> void pretty_print_counters(const Permuter &s, const typename Permuter::statistics_sequence_type &statistics)
+{
+  using namespace QUICKCPPLIB_NAMESPACE::console_colours;
+  for(size_t idx = 0; idx < statistics.size(); idx++)
+  {
+    if(statistics[idx].counters.any())
+    {
+      detail::pretty_print_preamble(s, idx);
+      KERNELTEST_COUT("    " << bold << blue << "COUNTERS " << normal << statistics[idx].counters << "\n");
+    }
+  }
+  const performance_counters total = total_counters(statistics);
+  if(total.any())
+  {
+    KERNELTEST_COUT("  " << bold << blue << "TOTAL COUNTERS " << normal << total << "\n");
+  }
+}
+/*! Colourfully prints the heap allocations tracked for every permutation, followed by their
+totals (see `permute_options::allocations`).
+*/
+template <class Permuter> void pretty_print_allocations(const Permuter &s, const typename Permuter::statistics_sequence_type &statistics)
+{
+  using namespace QUICKCPPLIB_NAMESPACE::console_colours;
+  for(size_t idx = 0; idx < statistics.size(); idx++)
+  {
+    if(statistics[idx].allocations.tracked)
+    {
+      detail::pretty_print_preamble(s, idx);
+      KERNELTEST_COUT("    " << bold << blue << "ALLOCATIONS " << normal << statistics[idx].allocations << "\n");
+    }
+  }
+  const allocation_statistics total = total_allocations(statistics);
+  if(total.tracked)
+  {
+    KERNELTEST_COUT("  " << bold << blue << "TOTAL ALLOCATIONS " << normal << total << "\n");
+  }
+}
+/*! Colourfully prints the outcomes and kernel times of both kernels of every permutation
+executed by `parameter_permuter::differential()`.
+\return True if the outcomes of the two kernels agreed for every permutation.
+*/
+template <class Permuter, class A, class B> bool pretty_print_differential(const Permuter &s, const std::vector<differential_result<A, B>> &results)
+{
+  using namespace QUICKCPPLIB_NAMESPACE::console_colours;
+  bool ret = true;
+  for(size_t idx = 0; idx < results.size(); idx++)
+  {
+    const differential_result<A, B> &r = results[idx];
+    detail::pretty_print_preamble(s, idx);
+    if(!r.agree)
+    {
+      ret = false;
+      KERNELTEST_COUT("    " << bold << red << "DIFFER" << normal << " (a was " << bold << (r.a ? print(*r.a) : std::string("nothing")) << normal << ", b was "
+                             << bold << (r.b ? print(*r.b) : std::string("nothing")) << normal << ")\n");
+      continue;
+    }
+    // Significant speedups are green, significant slowdowns are red
+    std::ostream &(*colour)(std::ostream &) = !r.timing.significant ? normal : (r.timing.speedup >= 1) ? green : red;
+    KERNELTEST_COUT("    " << bold << green << "AGREE " << normal << colour << r.timing << normal << "\n");
+  }
+  return ret;
+}
 //! Colourfully prints a successful result
 template <class Permuter, class U> detail::pretty_print_success_impl<Permuter, U> pretty_print_success(const Permuter &s, U &&f)
 {
@@ -0,0 +1,349 @@
+/* Placing permutation worker threads upon CPUs and NUMA nodes
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+
+#ifndef KERNELTEST_PLACEMENT_HPP
+#define KERNELTEST_PLACEMENT_HPP
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+//! How the worker threads of a `permutation_executor` are placed upon CPUs
+enum class placement_policy
+{
+  none,            //!< Workers are not pinned, and may migrate between CPUs
+  compact,         //!< Workers fill every CPU of a core, then of a package, then of a NUMA node, before the next
+  scatter,         //!< Workers are dealt round the NUMA nodes in turn, each taking a core not yet taken if possible
+  physical_cores,  //!< One worker per physical core, filling a NUMA node before the next
+  cpus             //!< Worker n is pinned to `worker_placement_options::cpus[n]`
+};
+
+/*! \brief Options for pinning the worker threads of a `permutation_executor` to CPUs.
+
+Pinning stops the kernel migrating workers between CPUs mid permutation, and keeping each
+worker's memory upon its own NUMA node avoids remote memory accesses, both of which add much
+variance to timings. Where there are more workers than CPUs selected by the policy, workers
+wrap around. Only CPUs within the affinity mask of the process are used.
+
+Pinning is only implemented on Linux, and is ignored elsewhere.
+*/
+struct worker_placement_options
+{
+  //! The placement policy
+  placement_policy policy{placement_policy::none};
+  //! The CPUs to pin workers to if `policy` is `placement_policy::cpus`. Those outside the affinity mask are skipped.
+  std::vector<int> cpus;
+  /*! If non-zero, each worker allocates this many bytes of scratch memory after it is pinned,
+  and touches every page so the memory resides upon the worker's own NUMA node. Permutations
+  retrieve it using `permutation_executor::worker_scratch()`.
+  */
+  size_t scratch_bytes{0};
+
+  /*! Returns the options given by the environment variable `KERNELTEST_PLACEMENT`, if set,
+  which is one of `compact`, `scatter`, `cores`, or a comma separated list of CPUs. The
+  environment variable `KERNELTEST_SCRATCH_BYTES` sets `scratch_bytes`.
+  */
+  static worker_placement_options from_environment()
+  {
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4996)  // Stupid deprecation warning
+#endif
+    const char *policy = getenv("KERNELTEST_PLACEMENT");
+    const char *scratch = getenv("KERNELTEST_SCRATCH_BYTES");
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+    worker_placement_options ret;
+    if(scratch != nullptr)
+      ret.scratch_bytes = static_cast<size_t>(strtoull(scratch, nullptr, 10));
+    if(policy == nullptr || policy[0] == 0)
+      return ret;
+    if(0 == strcmp(policy, "compact"))
+      ret.policy = placement_policy::compact;
+    else if(0 == strcmp(policy, "scatter"))
+      ret.policy = placement_policy::scatter;
+    else if(0 == strcmp(policy, "cores"))
+      ret.policy = placement_policy::physical_cores;
+    else
+    {
+      for(const char *p = policy; *p != 0;)
+      {
+        char *end;
+        long cpu = strtol(p, &end, 10);
+        if(end == p)
+          break;
+        ret.cpus.push_back(static_cast<int>(cpu));
+        p = (*end == ',') ? end + 1 : end;
+      }
+      if(!ret.cpus.empty())
+        ret.policy = placement_policy::cpus;
+    }
+    return ret;
+  }
+};
+
+//! Where a permutation was executed. Each integer member is -1 if unknown.
+struct worker_placement
+{
+  int worker{-1};      //!< The index of the executor worker thread, or -1 if not executed by one
+  int cpu{-1};         //!< The CPU executing the permutation when it began
+  int node{-1};        //!< The NUMA node of that CPU
+  bool pinned{false};  //!< True if the worker was pinned to that CPU
+};
+
+namespace detail
+{
+  // A CPU available to this process
+  struct cpu_info
+  {
+    int cpu{0}, package{0}, core{0}, node{0};
+  };
+  inline bool is_same_core(const cpu_info &a, const cpu_info &b) noexcept { return a.node == b.node && a.package == b.package && a.core == b.core; }
+#ifdef __linux__
+  inline int read_sysfs_int(const std::string &path, int def) noexcept
+  {
+    FILE *f = fopen(path.c_str(), "r");
+    if(f == nullptr)
+      return def;
+    int ret = def;
+    if(1 != fscanf(f, "%d", &ret))
+      ret = def;
+    fclose(f);
+    return ret;
+  }
+#endif
+  //! The CPUs in the affinity mask of the process when first called, ordered by node, package, core and CPU
+  inline const std::vector<cpu_info> &cpu_topology()
+  {
+    static const std::vector<cpu_info> v = []
+    {
+      std::vector<cpu_info> ret;
+#ifdef __linux__
+      cpu_set_t allowed;
+      CPU_ZERO(&allowed);
+      if(-1 == sched_getaffinity(0, sizeof(allowed), &allowed))
+        return ret;
+      for(int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      {
+        if(!CPU_ISSET(cpu, &allowed))
+          continue;
+        const std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        cpu_info i;
+        i.cpu = cpu;
+        i.package = read_sysfs_int(dir + "/topology/physical_package_id", 0);
+        i.core = read_sysfs_int(dir + "/topology/core_id", cpu);
+        // The CPU's directory contains a link named after its NUMA node
+        std::error_code ec;
+        for(filesystem::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+        {
+          const std::string name = it->path().filename().string();
+          if(name.size() > 4 && 0 == name.compare(0, 4, "node") && name.find_first_not_of("0123456789", 4) == std::string::npos)
+          {
+            i.node = atoi(name.c_str() + 4);
+            break;
+          }
+        }
+        ret.push_back(i);
+      }
+      std::sort(ret.begin(), ret.end(), [](const cpu_info &a, const cpu_info &b)
+                { return std::tie(a.node, a.package, a.core, a.cpu) < std::tie(b.node, b.package, b.core, b.cpu); });
+#endif
+      return ret;
+    }();
+    return v;
+  }
+  //! The NUMA node of cpu, or -1 if unknown
+  inline int numa_node_of(int cpu)
+  {
+    for(const cpu_info &i : cpu_topology())
+    {
+      if(i.cpu == cpu)
+        return i.node;
+    }
+    return -1;
+  }
+  //! The number of physical cores available to this process, or zero if unknown
+  inline size_t physical_core_count()
+  {
+    const auto &topology = cpu_topology();
+    size_t ret = 0;
+    for(size_t n = 0; n < topology.size(); n++)
+    {
+      if(0 == n || !is_same_core(topology[n], topology[n - 1]))
+        ret++;
+    }
+    return ret;
+  }
+  //! The CPU each of `workers` workers should be pinned to under `options`, or empty if they should not be
+  inline std::vector<int> placement_cpus(const worker_placement_options &options, size_t workers)
+  {
+    const auto &topology = cpu_topology();
+    std::vector<int> order;  // the CPUs in the order workers take them
+    switch(options.policy)
+    {
+    case placement_policy::none:
+      break;
+    case placement_policy::compact:
+      for(const cpu_info &i : topology)
+        order.push_back(i.cpu);
+      break;
+    case placement_policy::physical_cores:
+      for(size_t n = 0; n < topology.size(); n++)
+      {
+        if(0 == n || !is_same_core(topology[n], topology[n - 1]))
+          order.push_back(topology[n].cpu);
+      }
+      break;
+    case placement_policy::scatter:
+    {
+      // Within each node, the first CPU of every core comes before the second of any
+      std::vector<std::vector<std::pair<size_t, int>>> nodes;  // (rank within core, CPU)
+      for(size_t n = 0, rank = 0; n < topology.size(); n++)
+      {
+        rank = (n > 0 && is_same_core(topology[n], topology[n - 1])) ? rank + 1 : 0;
+        if(0 == n || topology[n].node != topology[n - 1].node)
+          nodes.emplace_back();
+        nodes.back().emplace_back(rank, topology[n].cpu);
+      }
+      for(auto &node : nodes)
+        std::stable_sort(node.begin(), node.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+      // Deal the nodes round in turn
+      for(size_t taken = 0; order.size() < topology.size(); taken++)
+      {
+        for(auto &node : nodes)
+        {
+          if(taken < node.size())
+            order.push_back(node[taken].second);
+        }
+      }
+      break;
+    }
+    case placement_policy::cpus:
+      for(int cpu : options.cpus)
+      {
+        if(std::any_of(topology.begin(), topology.end(), [cpu](const cpu_info &i) { return i.cpu == cpu; }))
+          order.push_back(cpu);
+      }
+      break;
+    }
+    std::vector<int> ret;
+    if(order.empty())
+      return ret;
+    ret.reserve(workers);
+    for(size_t n = 0; n < workers; n++)
+      ret.push_back(order[n % order.size()]);
+    return ret;
+  }
+
+  // The placement of the calling worker thread, if it is one
+  inline worker_placement &this_thread_placement() noexcept
+  {
+    static QUICKCPPLIB_THREAD_LOCAL worker_placement v;
+    return v;
+  }
+  // The scratch memory of the calling worker thread, if any
+  struct worker_scratch_memory
+  {
+    std::unique_ptr<char[]> data;
+    size_t bytes{0};
+  };
+  inline worker_scratch_memory &this_thread_scratch() noexcept
+  {
+    // Not QUICKCPPLIB_THREAD_LOCAL, which may be __thread and so cannot hold a std::unique_ptr
+    static thread_local worker_scratch_memory v;
+    return v;
+  }
+  /* Pins the calling thread, which is worker `worker`, to cpu unless negative, then allocates
+  and first touches its scratch memory.
+  */
+  inline void place_worker(size_t worker, int cpu, size_t scratch_bytes)
+  {
+    worker_placement &p = this_thread_placement();
+    p = worker_placement();
+    p.worker = static_cast<int>(worker);
+#ifdef __linux__
+    if(cpu >= 0 && cpu < CPU_SETSIZE)
+    {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(cpu, &set);
+      if(0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+      {
+        p.cpu = cpu;
+        p.node = numa_node_of(cpu);
+        p.pinned = true;
+      }
+    }
+#else
+    (void) cpu;
+#endif
+    worker_scratch_memory &scratch = this_thread_scratch();
+    scratch.data.reset();
+    scratch.bytes = 0;
+    if(scratch_bytes > 0)
+    {
+      scratch.data.reset(new(std::nothrow) char[scratch_bytes]);
+      if(scratch.data)
+      {
+        // Under the first touch policy, each page resides upon the node of the thread first writing it
+        memset(scratch.data.get(), 0, scratch_bytes);
+        scratch.bytes = scratch_bytes;
+      }
+    }
+  }
+  //! Where the calling thread is executing now
+  inline worker_placement current_placement()
+  {
+    worker_placement ret = this_thread_placement();
+    if(!ret.pinned)
+    {
+#ifdef __linux__
+      ret.cpu = sched_getcpu();
+      ret.node = (ret.cpu >= 0) ? numa_node_of(ret.cpu) : -1;
+#endif
+    }
+    return ret;
+  }
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
@@ -0,0 +1,425 @@
+/* Executing permutations in crash isolated child processes
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "signal_capture.hpp"
+#include "watchdog.hpp"
+
+#ifndef KERNELTEST_PROCESS_ISOLATION_HPP
+#define KERNELTEST_PROCESS_ISOLATION_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+/*! \brief Options for executing permutations in crash isolated child processes (POSIX only)
+
+Each execution of a permuter forks a single threaded fork server from the thread calling it,
+which then forks the child processes from that warm snapshot of the calling process. Children
+are reused for further permutations until they crash or none remain, and crashed children are
+replaced by forking the fork server again. Only the forking of the fork server copies a process
+which may be multithreaded, and whatever the other threads of the parent were doing at that
+moment is inherited frozen by every child, including any locks they held. The C runtime's own
+locks are made safe by `fork()`, but those of other libraries may not be, so isolated kernels
+and hooks must not rely upon locks which other threads may hold whilst the permuter is called.
+*/
+struct process_isolation_options
+{
+  //! The number of child processes executing permutations concurrently. Zero means one per executor worker for multithreaded permuters, else one.
+  size_t processes{0};
+};
+
+namespace detail
+{
+  // An error code flattened into plain data so it can be passed between processes
+  struct portable_error
+  {
+    enum class category_type : unsigned char
+    {
+      generic,
+      system,
+      kerneltest
+    } category{category_type::generic};
+    int value{0};
+  };
+#if KERNELTEST_EXPERIMENTAL_STATUS_CODE
+  template <class Error> inline portable_error to_portable_error(const Error &ec) noexcept
+  {
+    portable_error ret;
+    ret.value = static_cast<int>(ec.value());
+    if(ec.domain() == kerneltest_domain)
+      ret.category = portable_error::category_type::kerneltest;
+    else if(ec.domain() == SYSTEM_ERROR2_NAMESPACE::posix_code_domain)
+      ret.category = portable_error::category_type::system;
+    else if(ec.domain() != SYSTEM_ERROR2_NAMESPACE::generic_code_domain)
+      ret.value = static_cast<int>(SYSTEM_ERROR2_NAMESPACE::errc::unknown);  // cannot be represented
+    return ret;
+  }
+  inline SYSTEM_ERROR2_NAMESPACE::system_code from_portable_error(const portable_error &v) noexcept
+  {
+    switch(v.category)
+    {
+    case portable_error::category_type::kerneltest:
+      return make_error_code(static_cast<kerneltest_errc>(v.value));
+    case portable_error::category_type::system:
+      return SYSTEM_ERROR2_NAMESPACE::posix_code(v.value);
+    default:
+      return SYSTEM_ERROR2_NAMESPACE::generic_code(static_cast<SYSTEM_ERROR2_NAMESPACE::errc>(v.value));
+    }
+  }
+#else
+  template <class Error> inline portable_error to_portable_error(const Error &e) noexcept
+  {
+    std::error_code ec = OUTCOME_V2_NAMESPACE::policy::error_code(e);
+    portable_error ret;
+    if(ec.category() == KERNELTEST_V1_NAMESPACE::kerneltest_category())
+    {
+      ret.category = portable_error::category_type::kerneltest;
+      ret.value = ec.value();
+    }
+    else if(ec.category() == std::system_category())
+    {
+      ret.category = portable_error::category_type::system;
+      ret.value = ec.value();
+    }
+    else
+    {
+      // Any other category can only be represented by its generic equivalent
+      ret.value = ec.default_error_condition().value();
+    }
+    return ret;
+  }
+  inline std::error_code from_portable_error(const portable_error &v) noexcept
+  {
+    switch(v.category)
+    {
+    case portable_error::category_type::kerneltest:
+      return make_error_code(static_cast<kerneltest_errc>(v.value));
+    case portable_error::category_type::system:
+      return {v.value, std::system_category()};
+    default:
+      return {v.value, std::generic_category()};
+    }
+  }
+#endif
+
+  /* An optional<Outcome> flattened into plain data so it can be passed between processes.
+  Values are transported bitwise if trivially copyable. Any other value cannot be transported,
+  so becomes `kerneltest_errc::outcome_not_transportable` rather than a value the kernel never
+  returned. Exceptions cannot be transported either and become
+  `kerneltest_errc::kernel_exception_thrown`.
+  */
+  template <class Outcome> struct portable_outcome
+  {
+    using value_type = typename Outcome::value_type;
+    static constexpr bool value_is_void = std::is_void<value_type>::value;
+    static constexpr bool value_is_trivial = !value_is_void && std::is_trivially_copyable<value_type>::value;
+    enum class kind_type : unsigned char
+    {
+      empty,
+      value,
+      error,
+      exception
+    } kind{kind_type::empty};
+    portable_error error;
+    alignas(value_is_trivial ? alignof(typename std::conditional<value_is_trivial, value_type, char>::type) : 1) unsigned char
+    value[value_is_trivial ? sizeof(typename std::conditional<value_is_trivial, value_type, char>::type) : 1]{};
+
+    void store(const optional<Outcome> &v) noexcept
+    {
+      if(!v)
+        kind = kind_type::empty;
+      else if(v->has_value())
+      {
+        if constexpr(value_is_void || value_is_trivial)
+        {
+          kind = kind_type::value;
+          _store_value(*v, std::integral_constant<bool, value_is_trivial>());
+        }
+        else
+        {
+          kind = kind_type::error;
+          error = portable_error{portable_error::category_type::kerneltest, static_cast<int>(kerneltest_errc::outcome_not_transportable)};
+        }
+      }
+      else if(v->has_error())
+      {
+        kind = kind_type::error;
+        error = to_portable_error(v->error());
+      }
+      else
+        kind = kind_type::exception;
+    }
+    optional<Outcome> load() const
+    {
+      // Constructed in place, as copying an outcome copies the storage of whichever of value or error it lacks
+      optional<Outcome> ret;
+      switch(kind)
+      {
+      case kind_type::value:
+        _load_value(ret, std::integral_constant<int, value_is_void ? 0 : value_is_trivial ? 1 : 2>());
+        break;
+      case kind_type::error:
+        ret.emplace(in_place_type<typename Outcome::error_type>, from_portable_error(error));
+        break;
+      case kind_type::exception:
+        ret.emplace(in_place_type<typename Outcome::error_type>, make_error_code(kerneltest_errc::kernel_exception_thrown));
+        break;
+      default:
+        break;
+      }
+      return ret;
+    }
+
+  private:
+    void _store_value(const Outcome &v, std::true_type) noexcept { memcpy(value, &v.assume_value(), sizeof(value)); }
+    void _store_value(const Outcome &, std::false_type) noexcept {}
+    void _load_value(optional<Outcome> &ret, std::integral_constant<int, 0>) const { ret.emplace(success()); }
+    void _load_value(optional<Outcome> &ret, std::integral_constant<int, 1>) const
+    {
+      typename std::conditional<value_is_trivial, value_type, char>::type v;
+      memcpy(&v, value, sizeof(value));
+      ret.emplace(in_place_type<value_type>, v);
+    }
+    // Never stored, as such values are not transportable
+    void _load_value(optional<Outcome> &, std::integral_constant<int, 2>) const {}
+  };
+
+#ifndef _WIN32
+  // An anonymous memory mapping shared with child processes forked after its creation
+  class shared_mapping
+  {
+    void *_addr{nullptr};
+    size_t _length{0};
+
+  public:
+    explicit shared_mapping(size_t length)
+        : _length(length)
+    {
+      _addr = ::mmap(nullptr, _length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+      if(MAP_FAILED == _addr)
+      {
+        _addr = nullptr;
+        KERNELTEST_EXCEPTION_THROW(std::bad_alloc());
+      }
+    }
+    shared_mapping(const shared_mapping &) = delete;
+    shared_mapping &operator=(const shared_mapping &) = delete;
+    ~shared_mapping()
+    {
+      if(_addr != nullptr)
+        ::munmap(_addr, _length);
+    }
+    void *data() const noexcept { return _addr; }
+  };
+
+  // What each child process is currently executing, so the fork server can attribute a crash
+  struct alignas(64) isolated_child_state
+  {
+    std::atomic<size_t> current;
+    volatile int stage;
+    std::atomic<int64_t> deadline;  // zero if none
+  };
+  static constexpr size_t isolated_child_idle = static_cast<size_t>(-1);
+
+  /* Executes f(pos, stage) for every pos in [0, count) across up to `processes` child
+  processes, each of which claims positions until none remain. f must publish its progress
+  into stage (0 = setup, 1 = kernel, 2 = teardown). The children are forked by a single
+  threaded fork server, itself forked once from the calling process, so every child (including
+  replacements) starts from the same snapshot of the calling process and only one fork is made
+  from a process which may be multithreaded. If a child dies while executing a position,
+  crashed(pos, stage, signo, timed_out) is called in the fork server, so must only write into
+  memory shared with the calling process, and a replacement child is forked to continue. signo
+  is zero if the child exited rather than being killed by a signal. A child dying between
+  claiming a position and publishing it, or reaped by something else, is replaced without
+  crashed() being called, so callers must treat positions f never completed as not executed.
+
+  If `watched`, each position is given a deadline of `timeout` from when it begins unless zero,
+  which f may change using `set_permutation_deadline()`. Children still executing a position
+  past its deadline are killed, and crashed() is called with timed_out set.
+  */
+  template <class F, class G> inline void run_isolated(size_t count, size_t processes, bool watched, std::chrono::nanoseconds timeout, F &&f, G &&crashed)
+  {
+    if(0 == count)
+      return;
+    if(0 == processes)
+      processes = 1;
+    if(processes > count)
+      processes = count;
+    struct control
+    {
+      std::atomic<size_t> next;
+    };
+    shared_mapping mapping(sizeof(isolated_child_state) * (processes + 1));
+    auto *ctrl = new(mapping.data()) control;
+    auto *children = reinterpret_cast<isolated_child_state *>(static_cast<char *>(mapping.data()) + sizeof(isolated_child_state));
+    for(size_t no = 0; no < processes; no++)
+      new(children + no) isolated_child_state;
+    ctrl->next.store(0, std::memory_order_relaxed);
+    // Don't let the fork server and children inherit and reflush buffered output
+    fflush(stdout);
+    fflush(stderr);
+    // Forks the children and supervises them until every position has been executed
+    auto serve = [&]
+    {
+      std::vector<pid_t> pids(processes, -1);
+      std::vector<char> killed(processes, 0);
+      auto spawn = [&](size_t no)
+      {
+        children[no].current.store(isolated_child_idle, std::memory_order_relaxed);
+        children[no].stage = 0;
+        children[no].deadline.store(0, std::memory_order_relaxed);
+        killed[no] = 0;
+        pid_t pid = ::fork();
+        if(0 == pid)
+        {
+          if(watched)
+            current_permutation_deadline() = &children[no].deadline;
+          for(;;)
+          {
+            size_t pos = ctrl->next.fetch_add(1, std::memory_order_relaxed);
+            if(pos >= count)
+              break;
+            children[no].stage = 0;
+            if(watched)
+              children[no].deadline.store((timeout.count() > 0) ? steady_now() + static_cast<int64_t>(timeout.count()) : 0, std::memory_order_relaxed);
+            children[no].current.store(pos, std::memory_order_release);
+            f(pos, children[no].stage);
+            // Clear the deadline before going idle so the server never kills a child between positions
+            children[no].deadline.store(0, std::memory_order_relaxed);
+            children[no].current.store(isolated_child_idle, std::memory_order_release);
+          }
+          fflush(stdout);
+          fflush(stderr);
+          ::_exit(0);
+        }
+        if(-1 == pid)
+        {
+          KERNELTEST_CERR("FATAL: Failed to fork a permutation child process due to " << strerror(errno) << std::endl);
+          std::terminate();
+        }
+        pids[no] = pid;
+      };
+      for(size_t no = 0; no < processes; no++)
+        spawn(no);
+      // Reaps one of our children, returning its index, or processes if none has exited
+      auto reap = [&](int &status) -> size_t
+      {
+        // Only our own children are waited upon, so those of the test or of other permuters are left alone
+        for(size_t no = 0; no < processes; no++)
+        {
+          if(pids[no] == -1)
+            continue;
+          status = 0;
+          pid_t pid;
+          while(-1 == (pid = ::waitpid(pids[no], &status, WNOHANG)) && EINTR == errno)
+            ;
+          // ECHILD means something else reaped it, so its status is unknown
+          if(pid == pids[no] || -1 == pid)
+            return no;
+        }
+        return processes;
+      };
+      for(size_t running = processes; running > 0;)
+      {
+        int status = 0;
+        const size_t no = reap(status);
+        if(no == processes)
+        {
+          // Kill any child executing a position past its deadline, then poll again shortly
+          const int64_t now = steady_now();
+          for(size_t n = 0; watched && n < processes; n++)
+          {
+            if(pids[n] == -1 || killed[n] || children[n].current.load(std::memory_order_acquire) == isolated_child_idle)
+              continue;
+            // Read after current, so this is never the expired deadline of an earlier position
+            const int64_t deadline = children[n].deadline.load(std::memory_order_acquire);
+            if(deadline != 0 && now >= deadline)
+            {
+              killed[n] = 1;
+              ::kill(pids[n], SIGKILL);
+            }
+          }
+          struct timespec ts = {0, 1000000};
+          ::nanosleep(&ts, nullptr);
+          continue;
+        }
+        pids[no] = -1;
+        --running;
+        size_t pos = children[no].current.load(std::memory_order_acquire);
+        if(pos != isolated_child_idle)
+          crashed(pos, static_cast<int>(children[no].stage), WIFSIGNALED(status) ? WTERMSIG(status) : 0, killed[no] != 0);
+        // Children only exit idle once none remain, unless they died whilst claiming one
+        if(ctrl->next.load(std::memory_order_relaxed) < count)
+        {
+          spawn(no);
+          ++running;
+        }
+      }
+    };
+    const pid_t server = ::fork();
+    if(0 == server)
+    {
+      serve();
+      fflush(stdout);
+      fflush(stderr);
+      ::_exit(0);
+    }
+    if(-1 == server)
+    {
+      KERNELTEST_CERR("FATAL: Failed to fork the permutation fork server due to " << strerror(errno) << std::endl);
+      std::terminate();
+    }
+    int status = 0;
+    pid_t pid;
+    while(-1 == (pid = ::waitpid(server, &status, 0)) && EINTR == errno)
+      ;
+    // ECHILD means something else reaped it, so its status is unknown
+    if(pid == server && !(WIFEXITED(status) && 0 == WEXITSTATUS(status)))
+    {
+      KERNELTEST_CERR("FATAL: The permutation fork server died, so permutations may not have been executed" << std::endl);
+      std::terminate();
+    }
+  }
+#endif
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
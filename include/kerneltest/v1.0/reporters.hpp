@@ -0,0 +1,454 @@
+/* Buffered reporting of permutation results to consoles and machine readable files
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "permute_parameters.hpp"
+
+#ifndef KERNELTEST_REPORTERS_HPP
+#define KERNELTEST_REPORTERS_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+//! A permutation as handed to a `reporter`
+struct report_entry
+{
+  size_t index{0};          //!< The zero based index of the permutation
+  size_t count{0};          //!< How many permutations there are
+  std::string permutation;  //!< The kernel and hook parameters, as printed by `pretty_print_failure()`
+  bool passed{false};       //!< True if the outcome was that expected
+  bool skipped{false};      //!< True if the permutation was not executed (see `permute_options::fail_fast`)
+  std::string outcome;      //!< The outcome of the kernel
+  std::string expected;     //!< The outcome the kernel ought to have had
+  //! The kernel time, or if benchmarked its median. Negative if statistics were not collected.
+  std::chrono::nanoseconds kernel{-1};
+};
+
+/*! \brief The base of reporters of permutation results, which are formatted into a buffer written
+out in large batches.
+
+Whilst reporting, the reporter writes nothing until its buffer exceeds `batch` bytes, so
+printing each permutation costs no more than formatting it. `end()` writes out whatever remains.
+Reporters are not thread safe, but `parameter_permuter::stream()` serialises its calls.
+*/
+class reporter
+{
+  std::ostream *_os;
+  size_t _batch;
+  size_t _written{0};
+
+protected:
+  //! The buffer into which derived reporters format their output
+  std::ostringstream buffer;
+
+  //! Writes out the buffer if it has exceeded the batch size
+  void flush_if_full()
+  {
+    if(static_cast<size_t>(buffer.tellp()) >= _batch)
+      flush();
+  }
+
+public:
+  /*! Constructs a reporter writing to `os`, or if null to `KERNELTEST_COUT`.
+  \param batch How many bytes to buffer before writing them out
+  */
+  explicit reporter(std::ostream *os = nullptr, size_t batch = 1024 * 1024)
+      : _os(os)
+      , _batch(batch)
+  {
+  }
+  reporter(const reporter &) = delete;
+  reporter &operator=(const reporter &) = delete;
+  //! Any buffered output is written out, but `end()` is not called
+  virtual ~reporter() { flush(); }
+
+  //! Called before the first permutation is reported
+  virtual void begin(const char * /*unused*/, size_t /*unused*/) {}
+  //! Called for each permutation with a result
+  virtual void report(const report_entry &entry) = 0;
+  //! Called after the last permutation was reported. By default writes out the buffer.
+  virtual void end() { flush(); }
+
+  //! Writes out the buffer
+  void flush()
+  {
+    const std::string out(buffer.str());
+    if(out.empty())
+      return;
+    if(_os != nullptr)
+    {
+      _os->write(out.data(), static_cast<std::streamsize>(out.size()));
+      _os->flush();
+    }
+    else
+    {
+      KERNELTEST_COUT(out << std::flush);
+    }
+    _written += out.size();
+    buffer.str(std::string());
+  }
+  //! The bytes written out so far
+  size_t written() const noexcept { return _written; }
+};
+
+/*! \brief Colourfully prints permutations to the console like `pretty_print_failure()`, by default
+only those which failed, followed by a summary of how many passed, failed and were skipped.
+*/
+class console_reporter : public reporter
+{
+  bool _successes;
+  size_t _passed{0}, _failed{0}, _skipped{0};
+
+public:
+  /*! \param successes If true, permutations which passed are also printed
+  \param os Where to write, or if null `KERNELTEST_COUT`
+  \param batch How many bytes to buffer before writing them out
+  */
+  explicit console_reporter(bool successes = false, std::ostream *os = nullptr, size_t batch = 64 * 1024)
+      : reporter(os, batch)
+      , _successes(successes)
+  {
+  }
+  virtual void begin(const char * /*unused*/, size_t /*unused*/) override { _passed = _failed = _skipped = 0; }
+  virtual void report(const report_entry &entry) override
+  {
+    using namespace QUICKCPPLIB_NAMESPACE::console_colours;
+    if(entry.skipped)
+      ++_skipped;
+    else if(entry.passed)
+      ++_passed;
+    else
+      ++_failed;
+    if(entry.skipped || (entry.passed && !_successes))
+      return;
+    buffer << "  " << yellow << (entry.index + 1) << "/" << entry.count << ": " << normal << entry.permutation << "\n";
+    if(entry.passed)
+      buffer << "    " << bold << green << "PASSED " << normal << entry.outcome;
+    else
+      buffer << "    " << bold << red << "FAILED" << normal << " (should be " << bold << entry.expected << normal << ", was " << bold << entry.outcome << normal << ")";
+    if(entry.kernel.count() >= 0)
+      buffer << " in " << entry.kernel.count() << "ns";
+    buffer << "\n";
+    flush_if_full();
+  }
+  virtual void end() override
+  {
+    using namespace QUICKCPPLIB_NAMESPACE::console_colours;
+    buffer << "  " << bold << (_failed ? red : green) << _passed << " passed, " << _failed << " failed" << normal;
+    if(_skipped > 0)
+      buffer << ", " << _skipped << " skipped";
+    buffer << "\n";
+    flush();
+  }
+};
+
+namespace detail
+{
+  // Writes s as the contents of a JSON string
+  inline void json_escape(std::ostream &os, const std::string &s)
+  {
+    for(const char c : s)
+    {
+      switch(c)
+      {
+      case '"':
+        os << "\\\"";
+        break;
+      case '\\':
+        os << "\\\\";
+        break;
+      case '\n':
+        os << "\\n";
+        break;
+      case '\r':
+        os << "\\r";
+        break;
+      case '\t':
+        os << "\\t";
+        break;
+      default:
+        if(static_cast<unsigned char>(c) < 0x20)
+        {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+          os << buf;
+        }
+        else
+          os << c;
+      }
+    }
+  }
+  // Writes s as XML attribute text. Control characters are not permitted in XML 1.0, so are dropped.
+  inline void xml_escape(std::ostream &os, const std::string &s)
+  {
+    for(const char c : s)
+    {
+      switch(c)
+      {
+      case '"':
+        os << "&quot;";
+        break;
+      case '&':
+        os << "&amp;";
+        break;
+      case '<':
+        os << "&lt;";
+        break;
+      case '>':
+        os << "&gt;";
+        break;
+      case '\n':
+        os << "&#10;";
+        break;
+      case '\t':
+        os << "&#9;";
+        break;
+      default:
+        if(static_cast<unsigned char>(c) >= 0x20)
+          os << c;
+      }
+    }
+  }
+}  // namespace detail
+
+/*! \brief Writes every permutation as a line of JSON, for example:
+
+\code
+{"test":"foo","index":0,"count":4,"permutation":"kernel(5) with precondition existing1","passed":true,"skipped":false,"outcome":"5","expected":"5","kernel_ns":1234}
+\endcode
+
+`kernel_ns` is omitted if statistics were not collected.
+*/
+class json_lines_reporter : public reporter
+{
+  std::string _test;
+
+public:
+  /*! \param os Where to write, or if null `KERNELTEST_COUT`
+  \param batch How many bytes to buffer before writing them out
+  */
+  explicit json_lines_reporter(std::ostream *os = nullptr, size_t batch = 1024 * 1024)
+      : reporter(os, batch)
+  {
+  }
+  virtual void begin(const char *test, size_t /*unused*/) override { _test = (test != nullptr) ? test : ""; }
+  virtual void report(const report_entry &entry) override
+  {
+    buffer << "{\"test\":\"";
+    detail::json_escape(buffer, _test);
+    buffer << "\",\"index\":" << entry.index << ",\"count\":" << entry.count << ",\"permutation\":\"";
+    detail::json_escape(buffer, entry.permutation);
+    buffer << "\",\"passed\":" << (entry.passed ? "true" : "false") << ",\"skipped\":" << (entry.skipped ? "true" : "false") << ",\"outcome\":\"";
+    detail::json_escape(buffer, entry.outcome);
+    buffer << "\",\"expected\":\"";
+    detail::json_escape(buffer, entry.expected);
+    buffer << "\"";
+    if(entry.kernel.count() >= 0)
+      buffer << ",\"kernel_ns\":" << entry.kernel.count();
+    buffer << "}\n";
+    flush_if_full();
+  }
+};
+
+/*! \brief Writes a JUnit XML test suite with a test case per permutation.
+
+As the test suite's totals precede its test cases, nothing is written until `end()`.
+*/
+class junit_reporter : public reporter
+{
+  std::string _test;
+  size_t _failed{0}, _skipped{0}, _count{0};
+  std::chrono::nanoseconds _total{0};
+  std::ostringstream _cases;
+
+public:
+  /*! \param os Where to write, or if null `KERNELTEST_COUT`
+  */
+  explicit junit_reporter(std::ostream *os = nullptr)
+      : reporter(os)
+  {
+  }
+  virtual void begin(const char *test, size_t /*unused*/) override
+  {
+    _test = (test != nullptr) ? test : "kerneltest";
+    _failed = _skipped = _count = 0;
+    _total = std::chrono::nanoseconds(0);
+    _cases.str(std::string());
+  }
+  virtual void report(const report_entry &entry) override
+  {
+    ++_count;
+    _cases << "    <testcase classname=\"";
+    detail::xml_escape(_cases, _test);
+    _cases << "\" name=\"" << (entry.index + 1) << ": ";
+    detail::xml_escape(_cases, entry.permutation);
+    _cases << "\"";
+    if(entry.kernel.count() >= 0)
+    {
+      _total += entry.kernel;
+      _cases << " time=\"" << static_cast<double>(entry.kernel.count()) / 1000000000.0 << "\"";
+    }
+    if(entry.skipped)
+    {
+      ++_skipped;
+      _cases << "><skipped/></testcase>\n";
+    }
+    else if(!entry.passed)
+    {
+      ++_failed;
+      _cases << "><failure message=\"should be ";
+      detail::xml_escape(_cases, entry.expected);
+      _cases << ", was ";
+      detail::xml_escape(_cases, entry.outcome);
+      _cases << "\"/></testcase>\n";
+    }
+    else
+      _cases << "/>\n";
+  }
+  virtual void end() override
+  {
+    buffer << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n  <testsuite name=\"";
+    detail::xml_escape(buffer, _test);
+    buffer << "\" tests=\"" << _count << "\" failures=\"" << _failed << "\" errors=\"0\" skipped=\"" << _skipped << "\" time=\""
+           << static_cast<double>(_total.count()) / 1000000000.0 << "\">\n"
+           << _cases.str() << "  </testsuite>\n</testsuites>\n";
+    _cases.str(std::string());
+    flush();
+  }
+};
+
+namespace detail
+{
+  template <class Permuter, class Result>
+  report_entry make_report_entry(const Permuter &permuter, size_t idx, const Result &result, bool passed, const typename Permuter::statistics_sequence_type *statistics)
+  {
+    report_entry entry;
+    entry.index = idx;
+    entry.count = permuter.parameter_sequence().size();
+    {
+      std::ostringstream s;
+      print_permutation(s, permuter, idx);
+      entry.permutation = s.str();
+    }
+    entry.passed = passed;
+    entry.skipped = is_skipped(result);
+    if(result)
+      entry.outcome = print(*result);
+    entry.expected = print(Permuter::outcome_value(permuter.parameter_sequence()[idx]));
+    if(statistics != nullptr && idx < statistics->size())
+      entry.kernel = (*statistics)[idx].kernel;
+    return entry;
+  }
+  template <class Permuter> class report_impl
+  {
+    const Permuter &_permuter;
+    reporter &_reporter;
+    bool _passed;
+
+  public:
+    report_impl(const Permuter &permuter, reporter &r, bool passed)
+        : _permuter(permuter)
+        , _reporter(r)
+        , _passed(passed)
+    {
+    }
+    template <class _T, class _U> bool operator()(size_t idx, const _T &result, const _U & /*unused*/) const
+    {
+      _reporter.report(make_report_entry(_permuter, idx, result, _passed, nullptr));
+      return _passed;
+    }
+  };
+}  // namespace detail
+
+/*! Reports every result to a reporter, calling its `begin()` and `end()`. Results not present
+are skipped if executed by another shard (see `parameter_permuter::in_shard()`), else reported
+as failing with `kerneltest_errc::permutation_not_executed`.
+\return True if all the results match, as `parameter_permuter::check()` would.
+\param permuter The permuter which produced the results
+\param results A sequence of results, as returned by the permuter
+\param r The reporter
+\param statistics If set, the statistics collected with the results, for the kernel times
+\param test The name of the test, by default that of `current_test_kernel`
+*/
+template <class Permuter, class Results>
+bool report(const Permuter &permuter, const Results &results, reporter &r, const typename Permuter::statistics_sequence_type *statistics = nullptr,
+            const char *test = current_test_kernel.test)
+{
+  if(results.size() != permuter.parameter_sequence().size())
+#ifdef __cpp_exceptions
+    throw std::invalid_argument("sequence to report does not have same length as parameter permute sequence");
+#else
+    abort();
+#endif
+  r.begin(test, results.size());
+  bool ret = true;
+  const std::vector<bool> executed = permuter.in_shard();
+  size_t idx = 0;
+  for(const auto &result : results)
+  {
+    if(!result)
+    {
+      // Not present because executed by some other shard, else it ought to have been
+      if(executed[idx])
+      {
+        ret = false;
+        r.report(detail::make_report_entry(permuter, idx, detail::not_executed_result(result), false, statistics));
+      }
+    }
+    else
+    {
+      const bool passed = !detail::is_skipped(result) && detail::check_result(result, Permuter::outcome_value(permuter.parameter_sequence()[idx]));
+      if(!passed)
+        ret = false;
+      r.report(detail::make_report_entry(permuter, idx, result, passed, statistics));
+    }
+    ++idx;
+  }
+  r.end();
+  return ret;
+}
+
+/*! Reports failed results to a reporter, for use as the `fail` callable of `parameter_permuter::check()`
+or `parameter_permuter::stream()`. The caller is responsible for calling the reporter's `begin()` and `end()`.
+*/
+template <class Permuter> detail::report_impl<Permuter> report_failure(const Permuter &s, reporter &r)
+{
+  return detail::report_impl<Permuter>(s, r, false);
+}
+//! Reports successful results to a reporter, for use as the `pass` callable of `parameter_permuter::check()` or `parameter_permuter::stream()`.
+template <class Permuter> detail::report_impl<Permuter> report_success(const Permuter &s, reporter &r)
+{
+  return detail::report_impl<Permuter>(s, r, true);
+}
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
@@ -0,0 +1,324 @@
+/* Caching the outcomes of permutations between runs
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "process_isolation.hpp"
+#include "sharding.hpp"
+
+#ifndef KERNELTEST_RESULT_CACHE_HPP
+#define KERNELTEST_RESULT_CACHE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <link.h>
+#endif
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+/*! \brief Options for reusing the outcomes of permutations from earlier runs.
+
+Each permutation is identified by the text printed for it by `pretty_print_failure()` (its
+kernel parameters and hook parameters) followed by the values of its hook parameters, the
+table and kernel executing it (see `permute_options::table_name`), the test kernel executing
+those, and the build identity of the test binary. If all of these match an earlier run, its
+outcome is reused instead of executing the permutation. Rebuilding the test binary therefore
+invalidates its entries, but not those of other test binaries sharing the cache directory.
+
+Only outcomes whose value is void or trivially copyable are cached, and only if every kernel
+and hook parameter can be written to a `std::ostream`. Outcomes which depend upon timing or the
+environment rather than upon the permutation are never cached: those skipped or not executed,
+timed out or stalled, crashed by a signal or SEH exception, regressed from the baseline, not
+transportable, or failed by the internals of a filesystem hook. Permutations whose outcomes are
+reused have zero statistics.
+*/
+struct result_cache_options
+{
+  //! The directory holding the cache, which is created if necessary. Each table has its own file within.
+  std::string directory;
+  //! If true, every permutation is executed and the cache refreshed with the outcomes
+  bool rerun{false};
+  //! Identifies the build of the test binary. If empty, its GNU build id or a hash of its contents is used.
+  std::string build_identity;
+
+  /*! Returns a cache in the directory given by the environment variable `KERNELTEST_RESULT_CACHE`,
+  if set. `rerun` is set if the environment variable `KERNELTEST_RESULT_CACHE_RERUN` is non-zero.
+  */
+  static optional<result_cache_options> from_environment()
+  {
+    const char *directory = getenv("KERNELTEST_RESULT_CACHE");
+    if(directory == nullptr || directory[0] == 0)
+      return {};
+    result_cache_options ret;
+    ret.directory = directory;
+    const char *rerun = getenv("KERNELTEST_RESULT_CACHE_RERUN");
+    ret.rerun = (rerun != nullptr && atoi(rerun) != 0);
+    return ret;
+  }
+};
+
+namespace detail
+{
+  template <class T, class = void> struct is_ostreamable : std::false_type
+  {
+  };
+  template <class T> struct is_ostreamable<T, decltype((void) (std::declval<std::ostream &>() << std::declval<const T &>()))> : std::true_type
+  {
+  };
+  template <class Parameters> struct are_parameters_ostreamable;
+  template <class... Types> struct are_parameters_ostreamable<parameters<Types...>> : std::integral_constant<bool, (is_ostreamable<Types>::value && ... && true)>
+  {
+  };
+
+#if defined(__linux__)
+  inline int binary_build_id_callback(struct dl_phdr_info *info, size_t, void *data)
+  {
+    // The first object is the executable
+    auto *ret = static_cast<std::string *>(data);
+    for(ElfW(Half) n = 0; n < info->dlpi_phnum; n++)
+    {
+      const ElfW(Phdr) &phdr = info->dlpi_phdr[n];
+      if(phdr.p_type != PT_NOTE)
+        continue;
+      const char *p = reinterpret_cast<const char *>(info->dlpi_addr + phdr.p_vaddr), *end = p + phdr.p_memsz;
+      while(p + sizeof(ElfW(Nhdr)) <= end)
+      {
+        const auto *note = reinterpret_cast<const ElfW(Nhdr) *>(p);
+        const char *name = p + sizeof(ElfW(Nhdr)), *desc = name + ((note->n_namesz + 3) & ~3u);
+        if(NT_GNU_BUILD_ID == note->n_type && 4 == note->n_namesz && 0 == memcmp(name, "GNU", 4))
+        {
+          ret->assign(desc, note->n_descsz);
+          return 1;
+        }
+        p = desc + ((note->n_descsz + 3) & ~3u);
+      }
+    }
+    return 1;
+  }
+#endif
+  //! Identifies the build of the calling executable, or is empty if it cannot be determined
+  inline const std::string &binary_identity()
+  {
+    static const std::string v = []
+    {
+      std::string ret;
+#if defined(__linux__)
+      dl_iterate_phdr(binary_build_id_callback, &ret);
+      if(!ret.empty())
+        return ret;
+#endif
+      // Hash the contents of the executable
+#ifdef _WIN32
+      wchar_t path[32769];
+      DWORD len = GetModuleFileNameW(nullptr, path, 32769);
+      FILE *f = (len > 0 && len < 32769) ? _wfopen(path, L"rb") : nullptr;
+#else
+      FILE *f = fopen("/proc/self/exe", "rb");
+#endif
+      if(f == nullptr)
+        return ret;
+      uint64_t h = fnv1a(nullptr, 0);
+      static constexpr size_t buffer_size = 65536;
+      std::vector<char> buffer(buffer_size);
+      for(size_t bytes; (bytes = fread(buffer.data(), 1, buffer_size, f)) > 0;)
+        h = fnv1a(buffer.data(), bytes, h);
+      const bool ok = !ferror(f);
+      fclose(f);
+      if(ok)
+        ret.assign(reinterpret_cast<const char *>(&h), sizeof(h));
+      return ret;
+    }();
+    return v;
+  }
+
+  /* The cached outcomes of the permutations of a table, being a file of a result_cache_header
+  followed by result_cache_entries sorted by key. The file is rewritten after every run with the
+  outcomes of that run merged into those already in the file, whilst holding a lock upon it, so
+  that the shards of a table (which share its file) do not discard each other's outcomes. Files written by a different build
+  are discarded rather than merged, as none of their entries could ever be found again.
+  */
+  struct result_cache_header
+  {
+    char magic[8];
+    uint64_t entry_size, entries, salt;
+  };
+  static constexpr char result_cache_magic[8] = {'K', 'T', 'C', 'A', 'C', 'H', 'E', '2'};
+  template <class Outcome> class result_cache
+  {
+  public:
+    //! True if outcomes of this type are transported losslessly, and so can be cached
+    static constexpr bool is_supported = portable_outcome<Outcome>::value_is_void || portable_outcome<Outcome>::value_is_trivial;
+
+  private:
+    struct entry
+    {
+      uint64_t key;
+      portable_outcome<Outcome> result;
+    };
+    std::string _path;
+    uint64_t _salt{0};
+    std::vector<entry> _loaded, _saved;
+
+    // The entries of the cache file if it was written by this build, else none
+    std::vector<entry> _read() const
+    {
+      std::vector<entry> ret;
+      FILE *f = fopen(_path.c_str(), "rb");
+      if(f == nullptr)
+        return ret;
+      result_cache_header header;
+      if(1 == fread(&header, sizeof(header), 1, f) && 0 == memcmp(header.magic, result_cache_magic, sizeof(header.magic)) && header.entry_size == sizeof(entry) &&
+         header.salt == _salt)
+      {
+        ret.resize(static_cast<size_t>(header.entries));
+        if(header.entries != fread(static_cast<void *>(ret.data()), sizeof(entry), ret.size(), f))
+          ret.clear();
+      }
+      fclose(f);
+      return ret;
+    }
+
+  public:
+    //! Loads the cache of the table identified by `table` from the directory in `options`
+    result_cache(const result_cache_options &options, const std::string &table)
+    {
+      const std::string &identity = options.build_identity.empty() ? binary_identity() : options.build_identity;
+      const uint64_t layout = sizeof(entry);
+      uint64_t h = fnv1a(table.data(), table.size());
+      h = fnv1a(&layout, sizeof(layout), h);
+      char name[32];
+      snprintf(name, sizeof(name), "%016llx.ktcache", static_cast<unsigned long long>(h));
+      _path = (filesystem::path(options.directory) / name).string();
+      _salt = fnv1a(identity.data(), identity.size(), h);
+      if(options.rerun)
+        return;
+      _loaded = _read();
+    }
+    //! The key of the permutation printed as `description`
+    uint64_t key(const std::string &description) const noexcept { return fnv1a(description.data(), description.size(), _salt); }
+    //! Returns any cached outcome for the permutation with `key`, remembering it to be saved again
+    optional<Outcome> find(uint64_t key)
+    {
+      auto it = std::lower_bound(_loaded.begin(), _loaded.end(), key, [](const entry &a, uint64_t b) { return a.key < b; });
+      if(it == _loaded.end() || it->key != key)
+        return {};
+      _saved.push_back(*it);
+      return it->result.load();
+    }
+    //! Remembers the outcome of the permutation with `key` to be saved, unless another run might not reproduce it
+    void insert(uint64_t key, const portable_outcome<Outcome> &result)
+    {
+      if(result.kind == portable_outcome<Outcome>::kind_type::empty)
+        return;
+      if(result.kind == portable_outcome<Outcome>::kind_type::error && result.error.category == portable_error::category_type::kerneltest)
+      {
+        switch(static_cast<kerneltest_errc>(result.error.value))
+        {
+        case kerneltest_errc::setup_seh_exception_thrown:
+        case kerneltest_errc::kernel_seh_exception_thrown:
+        case kerneltest_errc::teardown_seh_exception_thrown:
+        case kerneltest_errc::setup_signal_thrown:
+        case kerneltest_errc::kernel_signal_thrown:
+        case kerneltest_errc::teardown_signal_thrown:
+        case kerneltest_errc::permutation_skipped:
+        case kerneltest_errc::permutation_not_executed:
+        case kerneltest_errc::setup_timed_out:
+        case kerneltest_errc::kernel_timed_out:
+        case kerneltest_errc::teardown_timed_out:
+        case kerneltest_errc::kernel_stalled:
+        case kerneltest_errc::performance_regressed:
+        case kerneltest_errc::outcome_not_transportable:
+        case kerneltest_errc::filesystem_setup_internal_failure:
+        case kerneltest_errc::filesystem_comparison_internal_failure:
+          return;
+        default:
+          break;
+        }
+      }
+      entry e;
+      memset(static_cast<void *>(&e), 0, sizeof(e));  // no uninitialised padding in the file
+      e.key = key;
+      e.result = result;
+      _saved.push_back(e);
+    }
+    /*! Replaces the cache file with the outcomes found or inserted, and those of permutations not
+    executed which were loaded or have since been saved by another process (e.g. another shard).
+    */
+    result<void> save()
+    {
+      std::error_code ec;
+      filesystem::create_directories(filesystem::path(_path).parent_path(), ec);
+      auto by_key = [](const entry &a, const entry &b) { return a.key < b.key; };
+      std::sort(_saved.begin(), _saved.end(), by_key);
+      _saved.erase(std::unique(_saved.begin(), _saved.end(), [](const entry &a, const entry &b) { return a.key == b.key; }), _saved.end());
+      // Serialise with other processes saving this table, so none discards the outcomes of another
+      file_lock lock;
+      OUTCOME_TRYV(lock.lock(_path));
+      std::vector<entry> entries(_saved);
+      for(const std::vector<entry> &others : {_loaded, _read()})
+      {
+        for(const entry &e : others)
+        {
+          if(!std::binary_search(_saved.begin(), _saved.end(), e, by_key))
+            entries.push_back(e);
+        }
+      }
+      std::sort(entries.begin(), entries.end(), by_key);
+      entries.erase(std::unique(entries.begin(), entries.end(), [](const entry &a, const entry &b) { return a.key == b.key; }), entries.end());
+      result_cache_header header;
+      memset(&header, 0, sizeof(header));
+      memcpy(header.magic, result_cache_magic, sizeof(header.magic));
+      header.entry_size = sizeof(entry);
+      header.entries = entries.size();
+      header.salt = _salt;
+      return replace_file(_path, "wb",
+                          [&](FILE *f)
+                          {
+                            bool ok = (1 == fwrite(&header, sizeof(header), 1, f));
+                            if(ok && !entries.empty())
+                              ok = (entries.size() == fwrite(entries.data(), sizeof(entry), entries.size(), f));
+                            return ok;
+                          });
+    }
+  };
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
@@ -0,0 +1,169 @@
+/* Scheduling permutations by their predicted durations
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "sharding.hpp"
+
+#ifndef KERNELTEST_SCHEDULE_HPP
+#define KERNELTEST_SCHEDULE_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <vector>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+/*! \brief Options for beginning the longest permutations first.
+
+Executing permutations in order of index leaves whichever slow permutations happen to be last
+running on a few workers whilst the rest idle. If the duration of each permutation can be
+predicted, multithreaded and process isolated permuters instead begin them longest first,
+with each free worker taking the longest remaining. The order of the results is unaffected.
+
+Durations given in `durations` are also used to balance shards (see `shard_options::costs`) if
+no costs were given. Durations recorded in `directory` never are, as the shards of a run record
+theirs there as they finish, so shards beginning at different moments would read different
+costs and disagree about which permutations each executes.
+*/
+struct schedule_options
+{
+  //! The predicted duration of each permutation. Ignored unless of the same length as the parameter sequence.
+  std::vector<std::chrono::nanoseconds> durations;
+  /*! If not empty, a directory in which the measured duration of every permutation of each
+  table is recorded, which is created if necessary. If `durations` is empty, those recorded by
+  an earlier run are used. Durations of permutations not executed, such as those of other
+  shards, keep whatever was last recorded for them.
+  */
+  std::string directory;
+
+  /*! Returns options recording durations in the directory given by the environment variable
+  `KERNELTEST_DURATIONS`, if set.
+  */
+  static optional<schedule_options> from_environment()
+  {
+    const char *directory = getenv("KERNELTEST_DURATIONS");
+    if(directory == nullptr || directory[0] == 0)
+      return {};
+    schedule_options ret;
+    ret.directory = directory;
+    return ret;
+  }
+};
+
+namespace detail
+{
+  /* The durations of the permutations of a table, being a file of a durations_header followed
+  by the duration of each permutation in nanoseconds, zero if never measured. Tables are
+  identified by the table and kernel executing them (see `permute_options::table_name`) and
+  their size.
+  */
+  struct durations_header
+  {
+    char magic[8];
+    uint64_t size;
+  };
+  static constexpr char durations_magic[8] = {'K', 'T', 'D', 'U', 'R', 'A', 'T', '1'};
+  inline std::string durations_path(const std::string &directory, const std::string &table, size_t size)
+  {
+    const uint64_t layout = size;
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ktdurations", static_cast<unsigned long long>(fnv1a(&layout, sizeof(layout), fnv1a(table.data(), table.size()))));
+    return (filesystem::path(directory) / name).string();
+  }
+  //! The durations of the table identified by `table` of `size` permutations recorded in `directory`, or empty if none were
+  inline std::vector<std::chrono::nanoseconds> read_durations(const std::string &directory, const std::string &table, size_t size)
+  {
+    std::vector<std::chrono::nanoseconds> ret;
+    FILE *f = fopen(durations_path(directory, table, size).c_str(), "rb");
+    if(f == nullptr)
+      return ret;
+    durations_header header;
+    if(1 == fread(&header, sizeof(header), 1, f) && 0 == memcmp(header.magic, durations_magic, sizeof(header.magic)) && header.size == size)
+    {
+      std::vector<int64_t> ns(size);
+      if(size == fread(ns.data(), sizeof(int64_t), size, f))
+      {
+        ret.reserve(size);
+        for(int64_t v : ns)
+          ret.push_back(std::chrono::nanoseconds(v));
+      }
+    }
+    fclose(f);
+    return ret;
+  }
+  /*! Records in `directory` the durations of the table identified by `table` which differ from
+  those `predicted` at the beginning of the run, being those measured. The others keep whatever
+  is recorded at the moment of writing, such as by other shards which finished since, or else
+  their predicted duration.
+  */
+  inline result<void> write_durations(const std::string &directory, const std::string &table, const std::vector<std::chrono::nanoseconds> &durations,
+                                      const std::vector<std::chrono::nanoseconds> &predicted)
+  {
+    std::error_code ec;
+    filesystem::create_directories(directory, ec);
+    const std::string path = durations_path(directory, table, durations.size());
+    // Serialise with other processes recording this table, so none discards the durations of another
+    file_lock lock;
+    OUTCOME_TRYV(lock.lock(path));
+    const std::vector<std::chrono::nanoseconds> recorded = read_durations(directory, table, durations.size());
+    durations_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, durations_magic, sizeof(header.magic));
+    header.size = durations.size();
+    std::vector<int64_t> ns;
+    ns.reserve(durations.size());
+    for(size_t idx = 0; idx < durations.size(); idx++)
+    {
+      const bool measured = (idx >= predicted.size() || durations[idx] != predicted[idx]);
+      ns.push_back(static_cast<int64_t>((measured || recorded.empty()) ? durations[idx].count() : recorded[idx].count()));
+    }
+    return replace_file(path, "wb",
+                        [&](FILE *f)
+                        {
+                          bool ok = (1 == fwrite(&header, sizeof(header), 1, f));
+                          if(ok && !ns.empty())
+                            ok = (ns.size() == fwrite(ns.data(), sizeof(int64_t), ns.size(), f));
+                          return ok;
+                        });
+  }
+  //! The positions [0, count) ordered by descending duration of the permutation at each, ties in ascending order
+  template <class IndexOf> inline std::vector<size_t> longest_first(size_t count, const std::vector<std::chrono::nanoseconds> &durations, IndexOf &&index_of)
+  {
+    std::vector<size_t> ret(count);
+    std::iota(ret.begin(), ret.end(), size_t(0));
+    std::stable_sort(ret.begin(), ret.end(), [&](size_t a, size_t b) { return durations[index_of(a)] > durations[index_of(b)]; });
+    return ret;
+  }
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
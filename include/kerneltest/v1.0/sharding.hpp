@@ -0,0 +1,387 @@
+/* Splitting the permutations of a table across processes
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "permutation_results.hpp"
+#include "process_isolation.hpp"
+
+#ifndef KERNELTEST_SHARDING_HPP
+#define KERNELTEST_SHARDING_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+/*! \brief Options for executing a deterministic subset of the permutations of a table, so the
+table can be split across many processes.
+
+Every process executing shard `index` of `count` of the same table with the same `costs`
+executes the same permutations, and the shards are disjoint and together cover the table.
+*/
+struct shard_options
+{
+  //! The shard executed by this process, in [0, count)
+  size_t index{0};
+  //! The number of shards
+  size_t count{1};
+  /*! The predicted cost of each permutation, typically the kernel times from an earlier run.
+  If of the same length as the parameter sequence, shards are balanced by total cost, else
+  each shard is a contiguous block of the table of near equal length.
+  */
+  std::vector<std::chrono::nanoseconds> costs;
+  /*! If not empty, `parameter_permuter::operator()` appends the results of this shard to this
+  file, from which `parameter_permuter::merge_shards()` can rebuild the results of the table.
+  */
+  std::string output;
+
+  /*! Returns the shard configured by the environment variables `KERNELTEST_SHARD_INDEX`,
+  `KERNELTEST_SHARD_COUNT` and `KERNELTEST_SHARD_OUTPUT`, if the count is more than one.
+  */
+  static optional<shard_options> from_environment()
+  {
+    const char *count = getenv("KERNELTEST_SHARD_COUNT");
+    if(count == nullptr || strtoull(count, nullptr, 10) <= 1)
+      return {};
+    shard_options ret;
+    ret.count = static_cast<size_t>(strtoull(count, nullptr, 10));
+    if(const char *index = getenv("KERNELTEST_SHARD_INDEX"))
+      ret.index = static_cast<size_t>(strtoull(index, nullptr, 10));
+    if(const char *output = getenv("KERNELTEST_SHARD_OUTPUT"))
+      ret.output = output;
+    return ret;
+  }
+};
+
+namespace detail
+{
+  inline uint64_t fnv1a(const void *data, size_t bytes, uint64_t h = 0xcbf29ce484222325ULL) noexcept
+  {
+    for(size_t n = 0; n < bytes; n++)
+    {
+      h ^= static_cast<const unsigned char *>(data)[n];
+      h *= 0x100000001b3ULL;
+    }
+    return h;
+  }
+
+  //! The indices in [0, size) belonging to a shard, in ascending order
+  inline std::vector<size_t> shard_indices(size_t size, const shard_options &shard)
+  {
+    std::vector<size_t> ret;
+    if(shard.count <= 1)
+    {
+      ret.resize(size);
+      std::iota(ret.begin(), ret.end(), size_t(0));
+      return ret;
+    }
+    if(shard.index >= shard.count)
+      return ret;
+    if(shard.costs.size() != size)
+    {
+      const size_t begin = static_cast<size_t>(static_cast<unsigned long long>(size) * shard.index / shard.count);
+      const size_t end = static_cast<size_t>(static_cast<unsigned long long>(size) * (shard.index + 1) / shard.count);
+      ret.resize(end - begin);
+      std::iota(ret.begin(), ret.end(), begin);
+      return ret;
+    }
+    // Longest processing time first: the most costly remaining permutation goes to the least loaded shard
+    std::vector<size_t> order(size);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return shard.costs[a] > shard.costs[b]; });
+    using load_type = std::pair<std::chrono::nanoseconds::rep, size_t>;  // ties go to the lowest shard
+    std::priority_queue<load_type, std::vector<load_type>, std::greater<load_type>> loads;
+    for(size_t n = 0; n < shard.count; n++)
+      loads.push(load_type(0, n));
+    for(size_t idx : order)
+    {
+      load_type least = loads.top();
+      loads.pop();
+      if(least.second == shard.index)
+        ret.push_back(idx);
+      least.first += shard.costs[idx].count();
+      loads.push(least);
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  }
+
+  /* A shard results file is a sequence of sections, one per table executed, each being a
+  shard_results_header followed by `entries` shard_results_records of `record_size` bytes.
+  Tables are identified by the table and kernel executing them (see `permute_options::table_name`),
+  their size and the layout of their records.
+  */
+  struct shard_results_header
+  {
+    char magic[8];
+    uint64_t key, table, size, index, count, entries, record_size;
+  };
+  static constexpr char shard_results_magic[8] = {'K', 'T', 'S', 'H', 'A', 'R', 'D', '2'};
+  template <class Outcome> struct shard_results_record
+  {
+    uint64_t idx;
+    portable_outcome<Outcome> result;
+  };
+  //! The category/product/test/name of the current test kernel, each being empty if not set
+  inline std::string current_test_kernel_path()
+  {
+    std::string ret;
+    for(const char *s : {current_test_kernel.category, current_test_kernel.product, current_test_kernel.test, current_test_kernel.name})
+    {
+      if(s != nullptr)
+        ret.append(s);
+      ret.push_back('/');
+    }
+    return ret;
+  }
+  template <class Outcome> inline uint64_t shard_results_key(const std::string &table, size_t size)
+  {
+    const uint64_t layout[2] = {size, sizeof(shard_results_record<Outcome>)};
+    return fnv1a(layout, sizeof(layout), fnv1a(table.data(), table.size()));
+  }
+  inline portable_error portable_errno() noexcept
+  {
+    portable_error ret;
+    ret.value = errno;
+    return ret;
+  }
+
+  /* An advisory lock upon the file beside `path` named `path + ".lock"`, which is held from
+  lock() until destruction. Processes (and threads) replacing a file shared with others take
+  the lock around reading, merging and replacing it, so none loses the changes of another.
+  */
+  class file_lock
+  {
+#ifdef _WIN32
+    HANDLE _h{INVALID_HANDLE_VALUE};
+#else
+    int _fd{-1};
+#endif
+
+  public:
+    file_lock() = default;
+    file_lock(const file_lock &) = delete;
+    file_lock &operator=(const file_lock &) = delete;
+    ~file_lock()
+    {
+#ifdef _WIN32
+      if(_h != INVALID_HANDLE_VALUE)
+        CloseHandle(_h);  // releases the lock
+#else
+      if(_fd != -1)
+        ::close(_fd);  // releases the lock
+#endif
+    }
+    //! Blocks until the lock upon `path` is held
+    result<void> lock(const std::string &path)
+    {
+      const std::string lockpath = path + ".lock";
+#ifdef _WIN32
+      _h = CreateFileA(lockpath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_ALWAYS,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+      OVERLAPPED ol;
+      memset(&ol, 0, sizeof(ol));
+      if(_h == INVALID_HANDLE_VALUE || !LockFileEx(_h, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &ol))
+        return from_portable_error(portable_error{portable_error::category_type::system, static_cast<int>(GetLastError())});
+#else
+      _fd = ::open(lockpath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+      if(_fd == -1)
+        return from_portable_error(portable_errno());
+      int ret;
+      while(-1 == (ret = ::flock(_fd, LOCK_EX)) && EINTR == errno)
+        ;
+      if(-1 == ret)
+        return from_portable_error(portable_errno());
+#endif
+      return success();
+    }
+  };
+  //! A name beside `path` unique to this process and call, to write a replacement of `path` to before renaming it over
+  inline std::string unique_temp_path(const std::string &path)
+  {
+    static std::atomic<unsigned> count(0);
+#ifdef _WIN32
+    const unsigned long long pid = GetCurrentProcessId();
+#else
+    const unsigned long long pid = static_cast<unsigned long long>(::getpid());
+#endif
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".%llu.%u.tmp", pid, count.fetch_add(1, std::memory_order_relaxed));
+    return path + suffix;
+  }
+  /*! Replaces the file at `path` with one whose contents are written by `write(FILE *)`, which
+  returns false if writing failed. The contents are written to a `unique_temp_path()` which is
+  renamed over `path`, so concurrent readers never see half a file. Those replacing a file shared
+  with others hold its `file_lock` throughout.
+  */
+  template <class Write> inline result<void> replace_file(const std::string &path, const char *mode, Write &&write)
+  {
+    const std::string temp = unique_temp_path(path);
+    FILE *f = fopen(temp.c_str(), mode);
+    if(f == nullptr)
+      return from_portable_error(portable_errno());
+    const bool ok = write(f);
+    if(0 != fclose(f) || !ok)
+    {
+      portable_error e = portable_errno();
+      remove(temp.c_str());
+      return from_portable_error(e);
+    }
+#ifdef _WIN32
+    // rename() will not replace an existing file on Windows, and removing it first would leave a window without one
+    if(!MoveFileExW(filesystem::path(temp).c_str(), filesystem::path(path).c_str(), MOVEFILE_REPLACE_EXISTING))
+    {
+      portable_error e{portable_error::category_type::system, static_cast<int>(GetLastError())};
+      remove(temp.c_str());
+      return from_portable_error(e);
+    }
+#else
+    if(0 != rename(temp.c_str(), path.c_str()))
+    {
+      portable_error e = portable_errno();
+      remove(temp.c_str());
+      return from_portable_error(e);
+    }
+#endif
+    return success();
+  }
+
+  //! Appends the results at `indices` which are present to the shard results file at `path`, for the table identified by `table`
+  template <class Outcome>
+  inline result<void> write_shard_results(const std::string &path, const std::string &table, const shard_options &shard, const permutation_results<Outcome> &results,
+                                          const std::vector<size_t> &indices)
+  {
+    shard_results_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, shard_results_magic, sizeof(header.magic));
+    header.key = shard_results_key<Outcome>(table, results.size());
+    header.table = fnv1a(table.data(), table.size());
+    header.size = results.size();
+    header.index = shard.index;
+    header.count = shard.count;
+    header.record_size = sizeof(shard_results_record<Outcome>);
+    for(size_t idx : indices)
+      header.entries += results.present(idx);
+    FILE *f = fopen(path.c_str(), "ab");
+    if(f == nullptr)
+      return from_portable_error(portable_errno());
+    bool ok = (1 == fwrite(&header, sizeof(header), 1, f));
+    for(size_t n = 0; ok && n < indices.size(); n++)
+    {
+      if(!results.present(indices[n]))
+        continue;
+      shard_results_record<Outcome> record;
+      memset(static_cast<void *>(&record), 0, sizeof(record));  // no uninitialised padding in the file
+      record.idx = indices[n];
+      record.result.store(results[indices[n]]);
+      ok = (1 == fwrite(&record, sizeof(record), 1, f));
+    }
+    if(!ok)
+    {
+      portable_error e = portable_errno();
+      fclose(f);
+      return from_portable_error(e);
+    }
+    if(0 != fclose(f))
+      return from_portable_error(portable_errno());
+    return success();
+  }
+
+  //! Assigns the results in the shard results file at `path` for the table identified by `table`, marking each in `seen`
+  template <class Outcome>
+  inline result<void> read_shard_results(const std::string &path, const std::string &table, permutation_results<Outcome> &results, std::vector<bool> &seen)
+  {
+    const uint64_t key = shard_results_key<Outcome>(table, results.size()), table_hash = fnv1a(table.data(), table.size());
+    FILE *f = fopen(path.c_str(), "rb");
+    if(f == nullptr)
+      return from_portable_error(portable_errno());
+    kerneltest_errc ec = kerneltest_errc::success;
+    shard_results_header header;
+    size_t got = 0;
+    while(kerneltest_errc::success == ec && sizeof(header) == (got = fread(&header, 1, sizeof(header), f)))
+    {
+      if(0 != memcmp(header.magic, shard_results_magic, sizeof(header.magic)))
+      {
+        ec = kerneltest_errc::shard_results_invalid;
+        break;
+      }
+      if(header.key != key || header.table != table_hash || header.size != results.size() || header.record_size != sizeof(shard_results_record<Outcome>))
+      {
+        // Some other table, whose records may be of some other size
+        if(0 != fseek(f, static_cast<long>(header.entries * header.record_size), SEEK_CUR))
+          ec = kerneltest_errc::shard_results_invalid;
+        continue;
+      }
+      for(uint64_t n = 0; n < header.entries; n++)
+      {
+        shard_results_record<Outcome> record;
+        if(1 != fread(&record, sizeof(record), 1, f) || record.idx >= results.size())
+        {
+          ec = kerneltest_errc::shard_results_invalid;
+          break;
+        }
+        if(seen[record.idx])
+        {
+          ec = kerneltest_errc::shard_results_incomplete;
+          break;
+        }
+        seen[record.idx] = true;
+        results.assign(record.idx, record.result.load());
+      }
+    }
+    if(kerneltest_errc::success == ec && (got != 0 || !feof(f)))
+      ec = kerneltest_errc::shard_results_invalid;  // truncated header
+    fclose(f);
+    if(kerneltest_errc::success != ec)
+      return make_error_code(ec);
+    return success();
+  }
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
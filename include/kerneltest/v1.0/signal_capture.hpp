@@ -0,0 +1,222 @@
+/* Capturing signals raised by permutations within the executing thread
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+
+#ifndef KERNELTEST_SIGNAL_CAPTURE_HPP
+#define KERNELTEST_SIGNAL_CAPTURE_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifndef _WIN32
+#include <setjmp.h>
+#include <signal.h>
+#endif
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+namespace detail
+{
+  //! The kerneltest_errc for a signal thrown during stage (0 = setup, 1 = kernel, 2 = teardown)
+  inline kerneltest_errc signal_errc(int stage) noexcept
+  {
+    if(1 == stage)
+      return kerneltest_errc::kernel_signal_thrown;
+    if(2 == stage)
+      return kerneltest_errc::teardown_signal_thrown;
+    return kerneltest_errc::setup_signal_thrown;
+  }
+
+#ifndef _WIN32
+  /* Somewhere the calling thread can jump back to if it raises a synchronous signal. Use as:
+
+  signal_recovery_point recovery;
+  if(sigsetjmp(recovery.buf, 0) != 0)
+  {
+    // recovery.signo was raised
+  }
+  else
+  {
+    recovery.arm();
+    ...
+  }
+
+  Recovery points nest, with the innermost armed one receiving the signal. Signals raised
+  when no recovery point is armed go to whatever handler was installed beforehand, as do
+  those sent rather than raised by a fault. Only synchronous signals raised by the calling
+  thread itself are received, as only then is the state the thread jumps out of known to be
+  the faulting code's own.
+  */
+  struct signal_recovery_point
+  {
+    sigjmp_buf buf;
+    volatile int signo{0};
+    volatile bool armed{false};
+    signal_recovery_point *previous;
+
+    static signal_recovery_point *&current() noexcept
+    {
+      static QUICKCPPLIB_THREAD_LOCAL signal_recovery_point *v;
+      return v;
+    }
+
+    signal_recovery_point() noexcept
+        : previous(current())
+    {
+      current() = this;
+    }
+    signal_recovery_point(const signal_recovery_point &) = delete;
+    signal_recovery_point &operator=(const signal_recovery_point &) = delete;
+    ~signal_recovery_point() { current() = previous; }
+
+    // Must only be called after sigsetjmp(buf) has returned zero
+    inline void arm() noexcept;
+  };
+
+  // The handlers in place before ours, to which signals not raised under a recovery point are passed
+  struct previous_signal_handlers
+  {
+    static constexpr int signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL};
+    struct sigaction actions[sizeof(signals) / sizeof(signals[0])];
+  };
+  inline previous_signal_handlers &previous_signal_handlers_instance() noexcept
+  {
+    static previous_signal_handlers v;
+    return v;
+  }
+
+  inline void signal_capture_handler(int signo, siginfo_t *info, void *context)
+  {
+    // Only faults raised by the kernel are the calling thread's own, not those sent by kill() or tgkill()
+    const bool is_fault = (info != nullptr && info->si_code > 0);
+    for(signal_recovery_point *p = signal_recovery_point::current(); is_fault && p != nullptr; p = p->previous)
+    {
+      if(p->armed)
+      {
+        p->armed = false;
+        p->signo = signo;
+        // SA_NODEFER means signo is not blocked, so the signal mask need not be restored
+        siglongjmp(p->buf, 1);
+      }
+    }
+    auto &prev = previous_signal_handlers_instance();
+    for(size_t n = 0; n < sizeof(prev.signals) / sizeof(prev.signals[0]); n++)
+    {
+      if(prev.signals[n] == signo)
+      {
+        const struct sigaction &sa = prev.actions[n];
+        if(sa.sa_flags & SA_SIGINFO)
+        {
+          sa.sa_sigaction(signo, info, context);
+          return;
+        }
+        if(sa.sa_handler == SIG_IGN)
+          return;
+        if(sa.sa_handler != SIG_DFL)
+        {
+          sa.sa_handler(signo);
+          return;
+        }
+        // Restore the default action and raise it again so the process dies as it would have
+        sigaction(signo, &sa, nullptr);
+        raise(signo);
+        return;
+      }
+    }
+  }
+
+  // Installs signal_capture_handler for the synchronous signals once per process
+  inline void install_signal_capture()
+  {
+    static std::once_flag flag;
+    std::call_once(flag,
+                   []
+                   {
+                     auto &prev = previous_signal_handlers_instance();
+                     struct sigaction sa;
+                     memset(&sa, 0, sizeof(sa));
+                     sa.sa_sigaction = &signal_capture_handler;
+                     sa.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_NODEFER;
+                     sigemptyset(&sa.sa_mask);
+                     for(size_t n = 0; n < sizeof(prev.signals) / sizeof(prev.signals[0]); n++)
+                       sigaction(prev.signals[n], &sa, &prev.actions[n]);
+                   });
+  }
+
+  // Gives the calling thread an alternate signal stack if it has none, so stack overflows can be captured
+  class signal_alternate_stack
+  {
+    void *_mem{nullptr};
+
+  public:
+    signal_alternate_stack()
+    {
+      stack_t existing;
+      if(-1 == sigaltstack(nullptr, &existing) || !(existing.ss_flags & SS_DISABLE))
+        return;
+      static constexpr size_t size = 65536;
+      _mem = malloc(size);
+      if(_mem == nullptr)
+        return;
+      stack_t ss;
+      memset(&ss, 0, sizeof(ss));
+      ss.ss_sp = _mem;
+      ss.ss_size = size;
+      if(-1 == sigaltstack(&ss, nullptr))
+      {
+        free(_mem);
+        _mem = nullptr;
+      }
+    }
+    signal_alternate_stack(const signal_alternate_stack &) = delete;
+    signal_alternate_stack &operator=(const signal_alternate_stack &) = delete;
+    ~signal_alternate_stack()
+    {
+      if(_mem != nullptr)
+      {
+        stack_t ss;
+        memset(&ss, 0, sizeof(ss));
+        ss.ss_flags = SS_DISABLE;
+        sigaltstack(&ss, nullptr);
+        free(_mem);
+      }
+    }
+  };
+
+  inline void signal_recovery_point::arm() noexcept
+  {
+    // Not QUICKCPPLIB_THREAD_LOCAL, which may be __thread and so cannot hold a type with a destructor
+    static thread_local signal_alternate_stack altstack;
+    (void) altstack;
+    armed = true;
+  }
+#endif
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
@@ -0,0 +1,217 @@
+/* Enforcing deadlines upon permutations
+(C) 2026 Niall Douglas <http://www.nedproductions.biz/> (1 commit)
+File Created: Oct 2026
+
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License in the accompanying file
+Licence.txt or at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+
+Distributed under the Boost Software License, Version 1.0.
+    (See accompanying file Licence.txt or copy at
+          http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#include "config.hpp"
+#include "signal_capture.hpp"
+
+#ifndef KERNELTEST_WATCHDOG_HPP
+#define KERNELTEST_WATCHDOG_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+KERNELTEST_V1_NAMESPACE_BEGIN
+
+namespace detail
+{
+  //! The kerneltest_errc for a deadline expiring during stage (0 = setup, 1 = kernel, 2 = teardown)
+  inline kerneltest_errc timeout_errc(int stage) noexcept
+  {
+    if(1 == stage)
+      return kerneltest_errc::kernel_timed_out;
+    if(2 == stage)
+      return kerneltest_errc::teardown_timed_out;
+    return kerneltest_errc::setup_timed_out;
+  }
+
+  // Deadlines are nanoseconds since the steady clock's epoch, which is shared by forked children
+  inline int64_t steady_now() noexcept
+  {
+    return static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+  //! The deadline of the permutation being executed by the calling thread, if it is being watched. Zero means no deadline.
+  inline std::atomic<int64_t> *&current_permutation_deadline() noexcept
+  {
+    static QUICKCPPLIB_THREAD_LOCAL std::atomic<int64_t> *v;
+    return v;
+  }
+  //! Sets the deadline of the permutation being executed by the calling thread to `timeout` from now, if it is being watched
+  inline void set_permutation_deadline(std::chrono::nanoseconds timeout) noexcept
+  {
+    std::atomic<int64_t> *deadline = current_permutation_deadline();
+    if(deadline != nullptr)
+      deadline->store(steady_now() + static_cast<int64_t>(timeout.count()), std::memory_order_release);
+  }
+
+  //! True if Hook sets permutation deadlines (see `hooks::timeout`)
+  template <class Hook, class = void> struct sets_permutation_deadline : std::false_type
+  {
+  };
+  template <class Hook>
+  struct sets_permutation_deadline<Hook, decltype((void) std::decay<Hook>::type::sets_permutation_deadline)>
+      : std::integral_constant<bool, std::decay<Hook>::type::sets_permutation_deadline>
+  {
+  };
+
+  // A permutation being executed under a permutation_watchdog
+  struct watched_permutation
+  {
+    size_t idx{0};
+    const volatile int *stage{nullptr};
+    std::thread::id thread;  // the thread executing it
+    std::atomic<int64_t> deadline{0};
+    std::atomic<bool> running{false}, expired{false}, abandoned{false};
+    std::atomic<int> expired_stage{0};  // the stage the permutation was in when it expired
+  };
+  //! The permutation being executed by the calling thread, if it is being watched by a permutation_watchdog
+  inline watched_permutation *&current_watched_permutation() noexcept
+  {
+    static QUICKCPPLIB_THREAD_LOCAL watched_permutation *v;
+    return v;
+  }
+  /*! Blocks the calling thread forever if the permutation it is executing was abandoned after its
+  deadline expired, as whatever the permutation would touch next may no longer exist.
+  */
+  inline void park_if_abandoned() noexcept
+  {
+    const watched_permutation *w = current_watched_permutation();
+    if(w == nullptr || !w->expired.load(std::memory_order_acquire) || !w->abandoned.load(std::memory_order_relaxed))
+      return;
+    for(;;)
+      std::this_thread::sleep_for(std::chrono::hours(24));
+  }
+
+  /* A thread which notices permutations running past their deadlines. Each expired permutation
+  is marked as such, with the stage it was in, and reported via the callback. The permutation
+  is never interrupted, as a thread cannot safely be made to leave whatever it is executing.
+  If the callback returns true, the permutation was abandoned along with its thread, which is
+  parked forever by `park_if_abandoned()` should the permutation return. Otherwise the worker
+  fails the permutation once it returns. Only killing an isolated child process is safe.
+
+  Exactly one of the watchdog and the worker wins the race to clear `running`, so a permutation
+  finishing as its deadline expires is either reported and failed, or neither.
+  */
+  class permutation_watchdog
+  {
+    std::chrono::nanoseconds _timeout;
+    std::function<bool(watched_permutation &)> _expired;
+    std::mutex _lock;
+    std::condition_variable _changed;
+    std::vector<watched_permutation *> _active;
+    bool _done{false};
+    std::thread _thread;
+
+    void _run()
+    {
+      std::unique_lock<std::mutex> g(_lock);
+      while(!_done)
+      {
+        const int64_t now = steady_now();
+        for(auto *w : _active)
+        {
+          const int64_t deadline = w->deadline.load(std::memory_order_acquire);
+          if(deadline != 0 && now >= deadline && w->running.exchange(false, std::memory_order_acq_rel))
+          {
+            w->expired_stage.store((w->stage != nullptr) ? *w->stage : 1, std::memory_order_relaxed);
+            w->abandoned.store(_expired(*w), std::memory_order_relaxed);
+            w->expired.store(true, std::memory_order_release);
+          }
+        }
+        // Hooks may change deadlines at any time, so poll
+        _changed.wait_for(g, std::chrono::milliseconds(10));
+      }
+    }
+
+  public:
+    /*! Watches permutations, giving each a deadline of `timeout` from when it begins unless zero.
+    `expired(watched_permutation &)` is called from the watchdog thread when the deadline of a
+    permutation expires, returning true if it abandoned the thread executing the permutation.
+    */
+    template <class F>
+    permutation_watchdog(std::chrono::nanoseconds timeout, F &&expired)
+        : _timeout(timeout)
+        , _expired(std::forward<F>(expired))
+    {
+      _thread = std::thread([this] { _run(); });
+    }
+    permutation_watchdog(const permutation_watchdog &) = delete;
+    permutation_watchdog &operator=(const permutation_watchdog &) = delete;
+    ~permutation_watchdog()
+    {
+      {
+        std::lock_guard<std::mutex> g(_lock);
+        _done = true;
+      }
+      _changed.notify_all();
+      _thread.join();
+    }
+
+    //! Begins watching permutation idx, executed by the calling thread, which publishes its progress into stage
+    void begin(watched_permutation &w, size_t idx, const volatile int *stage = nullptr)
+    {
+      w.idx = idx;
+      w.stage = stage;
+      w.thread = std::this_thread::get_id();
+      w.expired.store(false, std::memory_order_relaxed);
+      w.abandoned.store(false, std::memory_order_relaxed);
+      w.deadline.store((_timeout.count() > 0) ? steady_now() + static_cast<int64_t>(_timeout.count()) : 0, std::memory_order_relaxed);
+      w.running.store(true, std::memory_order_release);
+      current_permutation_deadline() = &w.deadline;
+      current_watched_permutation() = &w;
+      std::lock_guard<std::mutex> g(_lock);
+      _active.push_back(&w);
+    }
+    /*! Stops the deadline applying. Returns false if it had already expired, once the watchdog has
+    finished reporting the expiry. Touches nothing but `w`, so is safe to call once abandoned.
+    */
+    static bool finish(watched_permutation &w) noexcept
+    {
+      current_permutation_deadline() = nullptr;
+      if(w.running.exchange(false, std::memory_order_acq_rel))
+        return true;
+      while(!w.expired.load(std::memory_order_acquire))
+        std::this_thread::yield();
+      return false;
+    }
+    //! Stops watching a finished permutation
+    void end(watched_permutation &w)
+    {
+      current_watched_permutation() = nullptr;
+      std::lock_guard<std::mutex> g(_lock);
+      _active.erase(std::find(_active.begin(), _active.end(), &w));
+    }
+  };
+}  // namespace detail
+
+KERNELTEST_V1_NAMESPACE_END
+
+#endif
@@ -0,0 +1,140 @@
+/* Tests for tracking the heap allocations of each permutation made by operator new
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <sstream>
+
+KERNELTEST_TRACK_ALLOCATIONS()
+
+namespace allocations_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  // Allocates count blocks of 64 bytes, keeping them all alive until it returns
+  inline result<int> allocates(int count)
+  {
+    if(count < 0)
+      return make_error_code(std::errc::invalid_argument);
+    std::vector<std::unique_ptr<volatile char[]>> blocks;
+    blocks.reserve(count);
+    for(int n = 0; n < count; n++)
+    {
+      blocks.emplace_back(new volatile char[64]);
+      blocks.back()[0] = 1;
+    }
+    return count;
+  }
+}  // namespace allocations_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, allocations, tracked, "Tests that the allocations of each kernel are tracked only if asked", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table{{0, {0}}, {10, {10}}, {1000, {1000}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter(allocations_test::allocates, statistics);
+  for(auto &s : statistics)
+    BOOST_CHECK(!s.allocations.tracked && 0 == s.allocations.allocations);
+  permuter.options().allocations = true;
+  results = permuter(allocations_test::allocates, statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  for(auto &s : statistics)
+    BOOST_CHECK(s.allocations.tracked);
+  BOOST_CHECK(0 == statistics[0].allocations.allocations && 0 == statistics[0].allocations.bytes && 0 == statistics[0].allocations.peak_live_bytes);
+  // The blocks, and the vector holding them
+  BOOST_CHECK(11 == statistics[1].allocations.allocations && 11 == statistics[1].allocations.deallocations);
+  BOOST_CHECK(10 * 64 + 10 * sizeof(void *) == statistics[1].allocations.bytes);
+  BOOST_CHECK(1001 == statistics[2].allocations.allocations);
+  BOOST_CHECK(statistics[2].allocations.peak_live_bytes >= 1000 * 64 && statistics[2].allocations.peak_live_bytes > statistics[1].allocations.peak_live_bytes);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, allocations, threads, "Tests that concurrent permutations see only their own allocations", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 500; n++)
+    table.push_back({n % 50, {n % 50}});
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().allocations = true;
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter(allocations_test::allocates, statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  for(size_t n = 0; n < statistics.size(); n++)
+    BOOST_CHECK(statistics[n].allocations.allocations == ((n % 50) ? n % 50 + 1 : 0));
+  const allocation_statistics total = total_allocations(statistics);
+  BOOST_CHECK(total.tracked && total.allocations == total.deallocations && total.peak_live_bytes == statistics[49].allocations.peak_live_bytes);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, allocations, bounded, "Tests that passing kernels allocating beyond their limits fail", {
+  using row = parameters<result<int>, parameters<int>, hooks::bounded_allocations_parameters>;
+  const allocation_limits unbounded, none{0}, few{20}, small{(std::numeric_limits<uint64_t>::max)(), (std::numeric_limits<uint64_t>::max)(), 100};
+  std::vector<row> table{{0, {0}, {none}},
+                         {make_error_code(kerneltest_errc::allocations_exceeded), {10}, {none}},
+                         {10, {10}, {few}},
+                         {make_error_code(kerneltest_errc::allocations_exceeded), {100}, {few}},
+                         {make_error_code(kerneltest_errc::allocations_exceeded), {10}, {small}},
+                         {100, {100}, {unbounded}},
+                         // Failing kernels are not judged
+                         {make_error_code(std::errc::invalid_argument), {-1}, {none}}};
+  // Tracked whether asked or not
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>, hooks::bounded_allocations_parameters>(std::move(table), hooks::bounded_allocations());
+  auto results = permuter(allocations_test::allocates);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::allocations_exceeded) == 3);
+})
+
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(unit, kerneltest, allocations, crash, "Tests that allocations are tracked after permutations raising signals and within isolated ones", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 20; n++)
+    table.push_back({(5 == n) ? result<int>(make_error_code(kerneltest_errc::kernel_signal_thrown)) : result<int>(n), {n}});
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().allocations = true;
+  permuter.options().capture_signals = true;
+  auto kernel = [](int v)
+  {
+    if(5 == v)
+    {
+      // Abandoned mid kernel, with its allocations still live
+      volatile char *leaked = new volatile char[64];
+      leaked[0] = 1;
+      return permuter_test_kernels::crashes(v, 5);
+    }
+    return allocations_test::allocates(v);
+  };
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter(kernel, statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  for(size_t n = 6; n < statistics.size(); n++)
+    BOOST_CHECK(statistics[n].allocations.tracked && statistics[n].allocations.allocations == n + 1 && statistics[n].allocations.peak_live_bytes >= n * 64);
+  // Isolated permutations return their allocations from their processes
+  permuter.options().capture_signals = false;
+  permuter.options().isolation.emplace();
+  results = permuter(kernel, statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  for(size_t n = 6; n < statistics.size(); n++)
+    BOOST_CHECK(statistics[n].allocations.tracked && statistics[n].allocations.allocations == n + 1);
+})
+#endif
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, allocations, print, "Tests printing allocations and their limits", {
+  std::ostringstream s;
+  s << allocation_statistics();
+  BOOST_CHECK(s.str() == "allocations not tracked");
+  s.str(std::string());
+  allocation_statistics v;
+  v.tracked = true;
+  v.allocations = 2;
+  v.bytes = 48;
+  v.deallocations = 1;
+  v.peak_live_bytes = 64;
+  s << v;
+  BOOST_CHECK(s.str() == "2 allocations of 48 bytes, 1 deallocations, peak live 64 bytes");
+  s.str(std::string());
+  s << allocation_limits{0, (std::numeric_limits<uint64_t>::max)(), 10};
+  BOOST_CHECK(s.str() == "allocations <= 0, peak live bytes <= 10");
+  s.str(std::string());
+  s << allocation_limits();
+  BOOST_CHECK(s.str() == "unbounded allocations");
+  BOOST_CHECK(allocation_limits().permits(v) && !allocation_limits{1}.permits(v));
+})
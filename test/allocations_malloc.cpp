@@ -0,0 +1,64 @@
+/* Tests for tracking the heap allocations of each permutation made by malloc()
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <cstring>
+
+// Interposing malloc() is only supported on glibc
+#ifdef __GLIBC__
+KERNELTEST_TRACK_MALLOC()
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, allocations_malloc, tracked, "Tests that allocations by the C allocator are tracked", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table{{0, {0}}, {1, {1}}, {2, {2}}, {3, {3}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().allocations = true;
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter(
+  [](int v) -> result<int>
+  {
+    switch(v)
+    {
+    case 1:
+      free(strdup("hello"));
+      break;
+    case 2:
+    {
+      void *p = calloc(4, 16);
+      p = realloc(p, 1000);
+      free(p);
+      break;
+    }
+    case 3:
+      // operator new is seen too, as it calls malloc()
+      delete new volatile int(5);
+      break;
+    }
+    return v;
+  },
+  statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(statistics[0].allocations.tracked && 0 == statistics[0].allocations.allocations);
+  BOOST_CHECK(1 == statistics[1].allocations.allocations && 1 == statistics[1].allocations.deallocations && 6 == statistics[1].allocations.bytes);
+  // realloc() deallocates and allocates
+  BOOST_CHECK(2 == statistics[2].allocations.allocations && 2 == statistics[2].allocations.deallocations && 1064 == statistics[2].allocations.bytes);
+  BOOST_CHECK(statistics[2].allocations.peak_live_bytes >= 1000);
+  BOOST_CHECK(statistics[3].allocations.allocations >= 1);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, allocations_malloc, posix_memalign, "Tests that the interposed posix_memalign() rejects invalid alignments", {
+  void *p = nullptr;
+  BOOST_CHECK(EINVAL == posix_memalign(&p, 0, 16));
+  BOOST_CHECK(EINVAL == posix_memalign(&p, 3, 16));
+  BOOST_CHECK(EINVAL == posix_memalign(&p, 48, 16));
+  BOOST_CHECK(EINVAL == posix_memalign(&p, sizeof(void *) / 2, 16));
+  BOOST_CHECK(p == nullptr);
+  BOOST_REQUIRE(0 == posix_memalign(&p, 64, 16));
+  BOOST_CHECK(0 == reinterpret_cast<uintptr_t>(p) % 64);
+  free(p);
+  p = aligned_alloc(256, 512);
+  BOOST_CHECK(p != nullptr && 0 == reinterpret_cast<uintptr_t>(p) % 256);
+  free(p);
+})
+#endif
@@ -0,0 +1,200 @@
+/* Tests for test kernels which are coroutines
+*/
+
+#include "permuter_test_kernels.hpp"
+
+// Coroutine kernels are only supported on Linux
+#if KERNELTEST_HAVE_COROUTINES
+#include <cstdio>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace async_kernel_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  inline kernel_task<result<int>> doubled_later(int v)
+  {
+    co_await event_loop::current()->sleep_for(std::chrono::milliseconds(50));
+    co_return v * 2;
+  }
+  inline kernel_task<result<int>> five() { co_return 5; }
+
+  // A hook counting the most of its instances alive at once upon a single threaded permuter
+  template <bool interleavable> struct counting_hook
+  {
+    static constexpr bool is_interleavable = interleavable;
+    static inline int alive, most;
+    struct impl
+    {
+      bool owned{true};
+      impl() { most = std::max(most, ++alive); }
+      impl(impl &&o) noexcept { o.owned = false; }
+      impl(const impl &) = delete;
+      ~impl()
+      {
+        if(owned)
+          --alive;
+      }
+    };
+    template <class Parent, class RetType> impl operator()(Parent *, RetType &, size_t, int) const { return impl(); }
+    std::string print(int) const { return "counted"; }
+  };
+  template <bool interleavable> inline int most_hooks_alive()
+  {
+    using row = parameters<result<int>, parameters<int>, parameters<int>>;
+    std::vector<row> table;
+    for(int n = 0; n < 16; n++)
+      table.push_back({n * 2, {n}, {n}});
+    counting_hook<interleavable>::alive = counting_hook<interleavable>::most = 0;
+    auto permuter = st_permute_parameters<result<int>, parameters<int>, parameters<int>>(std::move(table), counting_hook<interleavable>());
+    permuter.options().max_in_flight = 8;
+    auto results = permuter([](int v) -> kernel_task<result<int>> { co_return co_await doubled_later(v); });
+    BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+    BOOST_CHECK(0 == counting_hook<interleavable>::alive);
+    return counting_hook<interleavable>::most;
+  }
+}  // namespace async_kernel_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, async_kernel, overlap, "Tests that suspended permutations overlap one another", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 400; n++)
+    table.push_back({(7 == n) ? result<int>(-1) : result<int>(n * 2), {n}});
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().max_in_flight = 1000;
+  const auto begin = std::chrono::steady_clock::now();
+  auto results = permuter([](int v) -> kernel_task<result<int>> { co_return co_await async_kernel_test::doubled_later(v); });
+  // Serially these would take twenty seconds
+  BOOST_CHECK(std::chrono::steady_clock::now() - begin < std::chrono::seconds(5));
+  size_t failures = 0;
+  permuter.check(results,
+                 [&](size_t idx, auto &, auto &)
+                 {
+                   BOOST_CHECK(7 == idx);
+                   failures++;
+                   return false;
+                 });
+  BOOST_CHECK(failures == 1);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, async_kernel, failures, "Tests that exceptions thrown by coroutines and awaiting moved from tasks fail", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table{{0, {0}}, {make_error_code(kerneltest_errc::kernel_exception_thrown), {1}}, {5, {2}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().max_in_flight = 4;
+  bool caught = false;
+  auto results = permuter(
+  [&](int v) -> kernel_task<result<int>>
+  {
+    if(1 == v)
+      throw std::runtime_error("kernel failed");
+    if(2 == v)
+    {
+      auto task = async_kernel_test::five();
+      auto moved = std::move(task);
+#ifdef __cpp_exceptions
+      try
+      {
+        (void) co_await task;
+      }
+      catch(const std::logic_error &)
+      {
+        caught = true;
+      }
+#endif
+      co_return co_await moved;
+    }
+    co_return v;
+  });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+#ifdef __cpp_exceptions
+  BOOST_CHECK(caught);
+#endif
+  // Synchronous kernels are unaffected
+  results = permuter([](int v) -> result<int> { return (2 == v) ? 5 : (1 == v) ? result<int>(make_error_code(kerneltest_errc::kernel_exception_thrown)) : v; });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, async_kernel, readable, "Tests awaiting file descriptors becoming readable", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 32; n++)
+    table.push_back({n, {n}});
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().max_in_flight = 16;
+  auto results = permuter(
+  [](int v) -> kernel_task<result<int>>
+  {
+    int fds[2];
+    if(-1 == socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+      co_return std::error_code(errno, std::system_category());
+    std::thread writer(
+    [&]
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      const char c = static_cast<char>(v);
+      (void) ::write(fds[1], &c, 1);
+    });
+    auto readable = co_await event_loop::current()->readable(fds[0]);
+    char c = 0;
+    if(readable)
+      (void) ::read(fds[0], &c, 1);
+    writer.join();
+    ::close(fds[0]);
+    ::close(fds[1]);
+    if(!readable)
+      co_return readable.error();
+    co_return static_cast<int>(c);
+  });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, async_kernel, unwatchable, "Tests that awaiting a descriptor which cannot be watched fails", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table{{1, {0}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().max_in_flight = 2;
+  auto results = permuter(
+  [](int) -> kernel_task<result<int>>
+  {
+    // Regular files are always ready, so cannot be watched
+    FILE *f = tmpfile();
+    if(f == nullptr)
+      co_return std::error_code(errno, std::system_category());
+    auto readable = co_await event_loop::current()->readable(fileno(f));
+    fclose(f);
+    co_return readable ? 0 : 1;
+  });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, async_kernel, hooks, "Tests that permutations only interleave if all their hooks may", {
+  BOOST_CHECK(1 == async_kernel_test::most_hooks_alive<false>());
+  BOOST_CHECK(8 == async_kernel_test::most_hooks_alive<true>());
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, async_kernel, stalled, "Tests that permutations awaiting what their loop can never resume fail rather than spin", {
+  using row = parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 20; n++)
+    table.push_back({(3 == n % 10) ? result<int>(make_error_code(kerneltest_errc::kernel_stalled)) : result<int>(n * 2), {n}, {n}});
+  static std::atomic<int> torn_down;
+  torn_down = 0;
+  auto permuter = st_permute_parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>(
+  std::move(table), hooks::custom([](auto &, auto &, size_t, int v) { return v; }, [](int) { torn_down++; }, "counted"));
+  permuter.options().max_in_flight = 8;
+  auto results = permuter(
+  [](int v) -> kernel_task<result<int>>
+  {
+    // Nothing ever resumes these, and they stall only once the others have slept
+    if(3 == v % 10)
+      co_await std::suspend_always();
+    co_return co_await async_kernel_test::doubled_later(v);
+  });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_stalled) == 2);
+  // Hooks of stalled permutations are torn down too
+  BOOST_CHECK(20 == torn_down);
+})
+#endif
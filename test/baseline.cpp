@@ -0,0 +1,218 @@
+/* Tests for failing permutations whose kernel times regress from a stored baseline
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+namespace baseline_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  static const char directory[] = "kerneltest_baseline_test";
+
+  using row = parameters<result<int>, parameters<int>>;
+  // Two passing permutations, one expected to fail, and one whose outcome is wrong
+  inline std::vector<row> table() { return {{0, {0}}, {1, {1}}, {make_error_code(std::errc::invalid_argument), {-2}}, {4, {3}}}; }
+  // Executes the table, sleeping for slow_ms in permutation slow and 1ms in the others
+  inline permutation_results<result<int>> execute(bool record, int slow = -1, int slow_ms = 1)
+  {
+    auto permuter = st_permute_parameters<result<int>, parameters<int>>(table());
+    permuter.options().baseline.emplace();
+    permuter.options().baseline->directory = directory;
+    permuter.options().baseline->record = record;
+    permuter.options().benchmark.emplace();
+    permuter.options().benchmark->warmup = 1;
+    permuter.options().benchmark->min_repetitions = 10;
+    permuter.options().benchmark->max_repetitions = 20;
+    return permuter([=](int v) { return permuter_test_kernels::sleeps(v, (v == slow || -v == slow) ? slow_ms : 1); });
+  }
+  inline filesystem::path baseline_file()
+  {
+    for(auto &i : filesystem::directory_iterator(directory))
+    {
+      if(i.path().extension() == ".ktbaseline")
+        return i.path();
+    }
+    return {};
+  }
+}  // namespace baseline_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, baseline, regressed, "Tests that only correct permutations slower than the baseline fail", {
+  using namespace baseline_test;
+  filesystem::remove_all(directory);
+  auto results = execute(true);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::performance_regressed) == 0);
+  // Unchanged and faster kernel times pass
+  results = execute(false);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::performance_regressed) == 0);
+  results = execute(false, 1, 0);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::performance_regressed) == 0);
+  results = execute(false, 1, 5);
+  BOOST_REQUIRE(results[1].has_value() && results[1]->has_error());
+  BOOST_CHECK(results[1]->error() == make_error_code(kerneltest_errc::performance_regressed));
+  BOOST_CHECK(results[1]->error() != make_error_code(kerneltest_errc::check_failed));
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::performance_regressed) == 1);
+  // Permutations correctly failing are judged, those with wrong outcomes are not
+  results = execute(false, 2, 5);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::performance_regressed) == 1);
+  results = execute(false, 3, 5);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::performance_regressed) == 0);
+  BOOST_CHECK(results[3]->value() == 3);
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, baseline, corrupt, "Tests that corrupt baselines judge nothing and are rewritten when recording", {
+  using namespace baseline_test;
+  filesystem::remove_all(directory);
+  execute(true);
+  const filesystem::path path = baseline_file();
+  BOOST_REQUIRE(!path.empty());
+  for(const std::string &corrupted : {std::string("junk"), std::string("0123456789abcdef 999 1 2 3\n"), std::string()})
+  {
+    {
+      std::ofstream s(path, std::ios::binary | std::ios::trunc);
+      s.write(corrupted.data(), corrupted.size());
+    }
+    auto results = execute(false, 1, 5);
+    BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::performance_regressed) == 0);
+    execute(true);
+    results = execute(false, 1, 5);
+    BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::performance_regressed) == 1);
+  }
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, baseline, concurrent, "Tests that concurrent recordings of the same table keep the distributions of every recorder", {
+  using namespace baseline_test;
+  filesystem::remove_all(directory);
+  baseline_options options;
+  options.directory = directory;
+  options.record = true;
+  std::atomic<size_t> failed{0};
+  std::vector<std::thread> threads;
+  for(int t = 0; t < 8; t++)
+  {
+    threads.emplace_back(
+    [&, t]
+    {
+      for(int n = 0; n < 10; n++)
+      {
+        detail::performance_baseline baseline(options, "concurrent", 1);
+        baseline.describe(0, std::to_string(t * 10 + n));
+        baseline.record(0, baseline.summarise(0, {std::chrono::nanoseconds(t * 10 + n + 1)}));
+        if(!baseline.save())
+          failed++;
+      }
+    });
+  }
+  for(auto &thread : threads)
+    thread.join();
+  BOOST_CHECK(failed == 0);
+  options.record = false;
+  detail::performance_baseline baseline(options, "concurrent", 80);
+  for(int idx = 0; idx < 80; idx++)
+  {
+    baseline.describe(idx, std::to_string(idx));
+    const detail::baseline_entry *e = baseline.find(idx);
+    BOOST_CHECK(e != nullptr && 1 == e->count && idx + 1 == e->ns[0]);
+  }
+  // No temporary files are left behind
+  for(auto &i : filesystem::directory_iterator(directory))
+    BOOST_CHECK(i.path().extension() != ".tmp");
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, baseline, hook_parameters, "Tests that permutations differing only in hook parameters have separate baselines", {
+  using namespace baseline_test;
+  filesystem::remove_all(directory);
+  using hook_row = parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>;
+  static int sleep_ms;
+  for(int run = 0; run < 2; run++)
+  {
+    // The hook prints only its description, whatever its parameter
+    auto permuter = st_permute_parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>(
+    std::vector<hook_row>{{0, {0}, {1}}, {0, {0}, {5}}}, hooks::custom([](auto &, auto &, size_t, int v) { return sleep_ms = v; }, [](int) {}, "sleep"));
+    permuter.options().baseline.emplace();
+    permuter.options().baseline->directory = directory;
+    permuter.options().baseline->record = (0 == run);
+    permuter.options().benchmark.emplace();
+    permuter.options().benchmark->warmup = 1;
+    permuter.options().benchmark->min_repetitions = 10;
+    permuter.options().benchmark->max_repetitions = 20;
+    auto results = permuter([](int v) { return permuter_test_kernels::sleeps(v, sleep_ms); });
+    BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  }
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, baseline, kernels, "Tests that different kernels and tables within one test kernel have separate baselines", {
+  using namespace baseline_test;
+  filesystem::remove_all(directory);
+  auto make = [](bool record, const char *name = "")
+  {
+    auto ret = st_permute_parameters<result<int>, parameters<int>>(std::vector<row>{{0, {0}}, {1, {1}}});
+    ret.options().table_name = name;
+    ret.options().baseline.emplace();
+    ret.options().baseline->directory = directory;
+    ret.options().baseline->record = record;
+    ret.options().benchmark.emplace();
+    ret.options().benchmark->warmup = 1;
+    ret.options().benchmark->min_repetitions = 10;
+    ret.options().benchmark->max_repetitions = 20;
+    return ret;
+  };
+  auto fast = [](int v) { return permuter_test_kernels::sleeps(v, 0); };
+  auto slow = [](int v) { return permuter_test_kernels::sleeps(v, 5); };
+  // Each kernel is judged against its own baseline only
+  make(true)(slow);
+  make(true)(fast);
+  BOOST_CHECK(permuter_test_kernels::count_errors(make(false)(slow), kerneltest_errc::performance_regressed) == 0);
+  // As is the same kernel over differently named tables
+  make(true, "second")(slow);
+  make(true, "first")(fast);
+  BOOST_CHECK(permuter_test_kernels::count_errors(make(false, "second")(slow), kerneltest_errc::performance_regressed) == 0);
+  BOOST_CHECK(permuter_test_kernels::count_errors(make(false, "first")(slow), kerneltest_errc::performance_regressed) == 2);
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, baseline, statistics, "Tests the recorded quantiles and the Mann-Whitney U test upon known samples", {
+  std::vector<std::chrono::nanoseconds> samples;
+  for(int n = 100; n > 0; n--)
+    samples.push_back(std::chrono::nanoseconds(n));
+  const detail::baseline_entry e = detail::baseline_quantiles(5, samples);
+  BOOST_CHECK(5 == e.key && detail::baseline_samples == e.count);
+  BOOST_CHECK(1 == e.ns[0] && 100 == e.ns[e.count - 1]);
+  BOOST_CHECK(std::is_sorted(e.ns, e.ns + e.count));
+  BOOST_CHECK(0 == detail::baseline_quantiles(5, {}).count);
+  // U = 100, mean 50, variance 175, so p = erfc(49.5 / sqrt(175) / sqrt(2)) / 2
+  std::vector<int64_t> a, b;
+  for(int64_t n = 1; n <= 10; n++)
+  {
+    a.push_back(n);
+    b.push_back(n + 10);
+  }
+  BOOST_CHECK(std::fabs(detail::mann_whitney_p_value(a, b) - std::erfc(49.5 / std::sqrt(175.0) / std::sqrt(2.0)) / 2) < 1e-12);
+  BOOST_CHECK(detail::mann_whitney_p_value(b, a) > 0.99);
+  BOOST_CHECK(detail::mann_whitney_p_value(a, a) > 0.4);
+  BOOST_CHECK(1 == detail::mann_whitney_p_value({}, b));
+  BOOST_CHECK(1 == detail::mann_whitney_p_value({7, 7}, {7, 7}));
+})
+
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(unit, kerneltest, baseline, environment, "Tests parsing the baseline options from the environment", {
+  unsetenv("KERNELTEST_BASELINE");
+  BOOST_CHECK(!baseline_options::from_environment());
+  setenv("KERNELTEST_BASELINE", "somewhere", 1);
+  setenv("KERNELTEST_BASELINE_RECORD", "1", 1);
+  setenv("KERNELTEST_BASELINE_THRESHOLD", "25", 1);
+  auto options = baseline_options::from_environment();
+  BOOST_REQUIRE(options);
+  BOOST_CHECK(options->directory == "somewhere" && options->record && std::fabs(options->threshold - 0.25) < 1e-9);
+  unsetenv("KERNELTEST_BASELINE");
+  unsetenv("KERNELTEST_BASELINE_RECORD");
+  unsetenv("KERNELTEST_BASELINE_THRESHOLD");
+})
+#endif
@@ -0,0 +1,118 @@
+/* Tests for test kernels executing many permutations per call
+*/
+
+#include "permuter_test_kernels.hpp"
+
+namespace batch_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  struct not_default_constructible
+  {
+    explicit not_default_constructible(int v)
+        : x(v)
+    {
+    }
+    int x;
+  };
+  inline std::ostream &operator<<(std::ostream &s, const not_default_constructible &v) { return s << v.x; }
+}  // namespace batch_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, batch, columns, "Tests that batched kernels see every permutation once, column wise", {
+  using row = parameters<result<int>, parameters<int, int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 10000; n++)
+    table.push_back({(77 == n) ? -1 : n * 3, {n, n * 2}});
+  auto permuter = mt_permute_parameters<result<int>, parameters<int, int>>(std::move(table));
+  static_assert(parameter_batch<parameters<int, int>>::is_columnar, "trivial parameters must be stored column wise");
+  std::atomic<size_t> calls{0}, oversized{0};
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter(batched(
+  [&](const parameter_batch<parameters<int, int>> &batch, span<optional<result<int>>> outcomes)
+  {
+    calls++;
+    if(batch.size() > 1000 || batch.size() != outcomes.size())
+      oversized++;
+    auto a = batch.column<0>(), b = batch.column<1>();
+    for(size_t n = 0; n < batch.size(); n++)
+      outcomes[n] = a[n] + b[n];
+  },
+  1000),
+  statistics);
+  BOOST_CHECK(calls == 10);
+  BOOST_CHECK(oversized == 0);
+  size_t failures = 0;
+  permuter.check(results,
+                 [&](size_t idx, auto &, auto &)
+                 {
+                   BOOST_CHECK(77 == idx);
+                   failures++;
+                   return false;
+                 });
+  BOOST_CHECK(failures == 1);
+  BOOST_CHECK(statistics[0].kernel == statistics[999].kernel);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, batch, zero, "Tests that batched kernels constructed with a size of zero execute one permutation per call", {
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(10));
+  size_t calls = 0, oversized = 0;
+  auto kernel = [&](const parameter_batch<parameters<int>> &batch, span<optional<result<int>>> outcomes)
+  {
+    calls++;
+    if(batch.size() != 1)
+      oversized++;
+    for(size_t n = 0; n < batch.size(); n++)
+      outcomes[n] = permuter_test_kernels::identity(batch.column<0>()[n]);
+  };
+  auto results = permuter(batched_kernel<decltype(kernel)>{kernel, 0});
+  BOOST_CHECK(calls == 10);
+  BOOST_CHECK(oversized == 0);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, batch, failures, "Tests that throwing batches and unassigned outcomes fail", {
+  using batch_test::not_default_constructible;
+  using row = parameters<result<int>, parameters<not_default_constructible>>;
+  std::vector<row> table;
+  for(int n = 0; n < 9; n++)
+    table.push_back({n, {not_default_constructible(n)}});
+  auto permuter = st_permute_parameters<result<int>, parameters<not_default_constructible>>(std::move(table));
+  static_assert(!parameter_batch<parameters<not_default_constructible>>::is_columnar, "non-trivial parameters must be stored row wise");
+  auto results = permuter(batched(
+  [](const parameter_batch<parameters<not_default_constructible>> &batch, span<optional<result<int>>> outcomes)
+  {
+    for(size_t n = 0; n < batch.size(); n++)
+    {
+      if(batch.get<0>(n).x != 4)
+        outcomes[n] = batch.get<0>(n).x;
+    }
+    if(6 == batch.indices()[0])
+      throw std::runtime_error("batch failed");
+  },
+  3));
+  BOOST_CHECK(results.size() == 9);
+  size_t failures = 0;
+  BOOST_CHECK(!permuter.check(results,
+                              [&](size_t idx, auto &, auto &)
+                              {
+                                BOOST_CHECK(4 == idx || idx >= 6);
+                                failures++;
+                                return false;
+                              }));
+  BOOST_CHECK(failures == 4);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_exception_thrown) == 3);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::outcome_unassigned) == 1);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, batch, fail_fast, "Tests that batches not begun after enough failures are skipped", {
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(1000));
+  permuter.options().fail_fast = 1;
+  auto results = permuter(batched(
+  [](const parameter_batch<parameters<int>> &batch, span<optional<result<int>>> outcomes)
+  {
+    for(size_t n = 0; n < batch.size(); n++)
+      outcomes[n] = -1;
+  },
+  100));
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::permutation_skipped) == 900);
+})
@@ -0,0 +1,64 @@
+/* Tests for the statistical benchmark mode
+*/
+
+#include "permuter_test_kernels.hpp"
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, benchmark, repetitions, "Tests that benchmarking repeats each permutation within the limits set", {
+  using row = parameters<result<int>, parameters<int>>;
+  static const row table[] = {{1000, {1000}}, {10000, {10000}}};
+  auto permuter = bench_permute_parameters(table);
+  permuter.options().benchmark->warmup = 2;
+  permuter.options().benchmark->min_repetitions = 5;
+  permuter.options().benchmark->max_repetitions = 50;
+  std::atomic<size_t> calls{0};
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter(
+  [&](int iterations)
+  {
+    calls++;
+    return permuter_test_kernels::spins(iterations);
+  },
+  statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  for(const auto &s : statistics)
+  {
+    BOOST_REQUIRE(s.benchmark);
+    BOOST_CHECK(s.benchmark->repetitions >= 5 && s.benchmark->repetitions <= 50);
+    BOOST_CHECK(s.benchmark->min <= s.benchmark->median && s.benchmark->median <= s.benchmark->p90 && s.benchmark->p90 <= s.benchmark->p99);
+  }
+  BOOST_CHECK(calls == statistics[0].benchmark->repetitions + statistics[1].benchmark->repetitions + 4);
+  // The kernel doing ten times the work should take longer
+  BOOST_CHECK(statistics[1].benchmark->median > statistics[0].benchmark->median);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, benchmark, time_cap, "Tests that the time cap takes precedence over the minimum repetitions", {
+  using row = parameters<result<int>, parameters<int>>;
+  static const row table[] = {{0, {0}}};
+  auto permuter = bench_permute_parameters(table);
+  permuter.options().benchmark->warmup = 0;
+  permuter.options().benchmark->min_repetitions = 1000;
+  permuter.options().benchmark->max_time = std::chrono::milliseconds(20);
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter([](int v) { return permuter_test_kernels::sleeps(v, 5); }, statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_REQUIRE(statistics[0].benchmark);
+  BOOST_CHECK(statistics[0].benchmark->repetitions < 10);
+  BOOST_CHECK(!statistics[0].benchmark->converged);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, benchmark, summarise, "Tests the summary statistics of known samples", {
+  std::vector<std::chrono::nanoseconds> samples;
+  for(int n = 100; n >= 1; n--)
+    samples.push_back(std::chrono::nanoseconds(n));
+  benchmark_options opts;
+  opts.min_repetitions = 10;
+  opts.relative_precision = 1;
+  const benchmark_statistics s = detail::summarise_samples(samples, opts);
+  BOOST_CHECK(s.repetitions == 100);
+  BOOST_CHECK(s.min.count() == 1);
+  BOOST_CHECK(s.median.count() == 50);
+  BOOST_CHECK(s.p90.count() == 90);
+  BOOST_CHECK(s.p99.count() == 99);
+  BOOST_CHECK(s.mad.count() == 25);
+  BOOST_CHECK(s.converged);
+})
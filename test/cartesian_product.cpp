@@ -0,0 +1,68 @@
+/* Tests for the lazily generated cartesian product of dimensions
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <array>
+
+namespace cartesian_product_test
+{
+  struct flag
+  {
+    unsigned v{0};
+    flag &operator|=(flag o)
+    {
+      v |= o.v;
+      return *this;
+    }
+  };
+  inline std::ostream &operator<<(std::ostream &s, flag f) { return s << "flag(" << f.v << ")"; }
+}  // namespace cartesian_product_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, cartesian_product, generate, "Tests that every combination of the dimensions is generated once, in order", {
+  using cartesian_product_test::flag;
+  using row = parameters<result<int>, parameters<int, int, flag>>;
+  std::vector<int> xs(100);
+  for(int n = 0; n < 100; n++)
+    xs[n] = n;
+  auto sequence = cartesian_product<row>([](int x, int y, flag f) { return row{x * 100000 + y * 16 + static_cast<int>(f.v), {x, y, f}}; }, xs,
+                                         std::array<int, 3>{{0, 1, 2}}, power_set<flag>{flag{1}, flag{2}, flag{4}, flag{8}});
+  BOOST_REQUIRE(sequence.size() == 100 * 3 * 16);
+  BOOST_CHECK(!sequence.empty());
+  // The last dimension varies fastest
+  BOOST_CHECK(std::get<0>(std::get<1>(sequence[0])) == 0 && std::get<2>(std::get<1>(sequence[0])).v == 0);
+  BOOST_CHECK(std::get<2>(std::get<1>(sequence[15])).v == 15);
+  BOOST_CHECK(std::get<1>(std::get<1>(sequence[16])) == 1);
+  BOOST_CHECK(std::get<0>(std::get<1>(sequence[48])) == 1);
+  BOOST_CHECK(std::distance(sequence.begin(), sequence.end()) == static_cast<std::ptrdiff_t>(sequence.size()));
+  auto permuter = mt_permute_parameters<result<int>, parameters<int, int, flag>>(std::move(sequence));
+  auto results = permuter([](int x, int y, flag f) -> result<int> { return x * 100000 + y * 16 + static_cast<int>(f.v); });
+  BOOST_CHECK(results.size() == 4800);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, cartesian_product, power_set, "Tests that a power set yields every combination of its flags", {
+  using cartesian_product_test::flag;
+  power_set<flag> flags{flag{1}, flag{2}, flag{4}};
+  BOOST_REQUIRE(flags.size() == 8);
+  for(size_t n = 0; n < flags.size(); n++)
+    BOOST_CHECK(flags[n].v == n);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, cartesian_product, empty, "Tests that an empty dimension yields an empty sequence", {
+  std::vector<int> big(1u << 20);
+  auto sequence = cartesian_product<int>([](int, int, int, int) { return 0; }, big, big, big, std::vector<int>{});
+  BOOST_CHECK(sequence.size() == 0);
+  BOOST_CHECK(sequence.empty());
+})
+
+#ifdef __cpp_exceptions
+KERNELTEST_TEST_KERNEL(unit, kerneltest, cartesian_product, overflow, "Tests that sizes not representable by size_t are rejected", {
+  std::vector<int> flags(std::numeric_limits<size_t>::digits, 1);
+  BOOST_CHECK_THROW((void) power_set<int>(flags), std::length_error);
+  flags.pop_back();
+  BOOST_CHECK(power_set<int>(flags).size() == (size_t(1) << (std::numeric_limits<size_t>::digits - 1)));
+  std::vector<int> big(1u << 20);
+  BOOST_CHECK_THROW(cartesian_product<int>([](int, int, int, int) { return 0; }, big, big, big, big), std::length_error);
+})
+#endif
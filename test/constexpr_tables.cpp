@@ -0,0 +1,73 @@
+/* Tests for constant sized tables of parameter sets
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <array>
+
+namespace constexpr_tables_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  enum class mode
+  {
+    read,
+    write,
+    append
+  };
+  enum class creation
+  {
+    open_existing,
+    if_needed
+  };
+  inline std::ostream &operator<<(std::ostream &s, mode m) { return s << "mode(" << static_cast<int>(m) << ")"; }
+  inline std::ostream &operator<<(std::ostream &s, creation c) { return s << "creation(" << static_cast<int>(c) << ")"; }
+  constexpr int expected(mode m, creation c) { return static_cast<int>(m) * 2 + static_cast<int>(c); }
+
+  static constexpr std::array<mode, 3> modes{{mode::read, mode::write, mode::append}};
+  static constexpr std::array<creation, 2> creations{{creation::open_existing, creation::if_needed}};
+
+  // The table is generated entirely at compile time
+  using literal_row = parameters<int, parameters<mode, creation>>;
+  static constexpr auto literal_table = cartesian_product_array<literal_row>([](mode m, creation c) { return literal_row{expected(m, c), {m, c}}; }, modes, creations);
+  static_assert(literal_table.size() == 6, "every combination must be generated");
+  static_assert(std::get<0>(literal_table[3]) == 3, "the last dimension must vary fastest");
+  static_assert(std::get<0>(std::get<1>(literal_table[5])) == mode::append && std::get<1>(std::get<1>(literal_table[5])) == creation::if_needed,
+                "the last row must be the last of each dimension");
+}  // namespace constexpr_tables_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, constexpr_tables, permute, "Tests that permuting a constant sized table yields constant sized results", {
+  using namespace constexpr_tables_test;
+  using row = parameters<result<int>, parameters<mode, creation>>;
+  auto table = cartesian_product_array<row>([](mode m, creation c) { return row{expected(m, c), {m, c}}; }, modes, creations);
+  table[4] = row{make_error_code(std::errc::invalid_argument), {mode::append, creation::open_existing}};
+  auto permuter = mt_permute_parameters<result<int>, parameters<mode, creation>>(std::move(table));
+  static_assert(decltype(permuter)::permutation_results_type_is_constant_sized, "results of a std::array table must be constant sized");
+  static_assert(decltype(permuter)::permutation_results_type_constant_size == 6, "results of a std::array table must have its size");
+  auto results = permuter(
+  [](mode m, creation c) -> result<int>
+  {
+    if(mode::append == m && creation::open_existing == c)
+      return make_error_code(std::errc::invalid_argument);
+    return expected(m, c);
+  });
+  BOOST_CHECK(results.size() == 6);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, constexpr_tables, mismatch, "Tests that results differing from a constant sized table are failures", {
+  using namespace constexpr_tables_test;
+  using row = parameters<result<int>, parameters<mode, creation>>;
+  auto table = cartesian_product_array<row>([](mode m, creation c) { return row{expected(m, c), {m, c}}; }, modes, creations);
+  auto permuter = st_permute_parameters<result<int>, parameters<mode, creation>>(std::move(table));
+  auto results = permuter([](mode m, creation c) -> result<int> { return (mode::write == m) ? -1 : expected(m, c); });
+  size_t failures = 0;
+  BOOST_CHECK(!permuter.check(results,
+                              [&](size_t idx, auto &, auto &)
+                              {
+                                failures++;
+                                BOOST_CHECK(idx == 2 || idx == 3);
+                                return false;
+                              }));
+  BOOST_CHECK(failures == 2);
+})
@@ -0,0 +1,110 @@
+/* Tests for counting the performance events of each permutation
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <sstream>
+
+namespace counters_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  // Touches every page of a newly allocated block of `bytes` bytes
+  inline result<int> touches(int bytes)
+  {
+    std::unique_ptr<volatile char[]> block(new volatile char[bytes]);
+    for(int n = 0; n < bytes; n += 4096)
+      block[n] = 1;
+    return bytes;
+  }
+  inline std::vector<parameters<result<int>, parameters<int>>> table() { return {{0, {0}}, {1 << 24, {1 << 24}}, {-1, {-1}}}; }
+  // Executes the table, sleeping in the last permutation
+  template <class Permuter> inline typename Permuter::statistics_sequence_type execute(Permuter &permuter)
+  {
+    typename Permuter::statistics_sequence_type statistics;
+    auto results = permuter(
+    [](int v)
+    {
+      if(v < 0)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return result<int>(v);
+      }
+      return touches(v);
+    },
+    statistics);
+    BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+    return statistics;
+  }
+}  // namespace counters_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, counters, counted, "Tests that the events of each permutation are counted only if asked", {
+  using namespace counters_test;
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(table());
+  auto statistics = execute(permuter);
+  for(auto &s : statistics)
+    BOOST_CHECK(!s.counters.any());
+  permuter.options().counters = true;
+  statistics = execute(permuter);
+#ifdef __linux__
+  // Software counters are always available, if only from getrusage()
+  for(auto &s : statistics)
+    BOOST_CHECK(s.counters.task_clock >= 0 && s.counters.page_faults >= 0 && s.counters.context_switches >= 0);
+  BOOST_CHECK(statistics[1].counters.page_faults > statistics[0].counters.page_faults);
+  BOOST_CHECK(statistics[2].counters.context_switches > 0);
+  if(statistics[1].counters.instructions >= 0)
+    BOOST_CHECK(statistics[1].counters.instructions > statistics[0].counters.instructions);
+#endif
+})
+
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(unit, kerneltest, counters, isolation, "Tests that the events of isolated permutations are returned from their processes", {
+  using namespace counters_test;
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(table());
+  permuter.options().counters = true;
+  permuter.options().isolation.emplace();
+  auto statistics = execute(permuter);
+#ifdef __linux__
+  for(auto &s : statistics)
+    BOOST_CHECK(s.counters.task_clock >= 0);
+  BOOST_CHECK(statistics[1].counters.page_faults > statistics[0].counters.page_faults);
+#else
+  (void) statistics;
+#endif
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, counters, crash, "Tests that permutations after one raising a signal are still counted", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 20; n++)
+    table.push_back({(5 == n) ? result<int>(make_error_code(kerneltest_errc::kernel_signal_thrown)) : result<int>(n), {n}});
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().counters = true;
+  permuter.options().capture_signals = true;
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter([](int v) { return permuter_test_kernels::crashes(v, 5); }, statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+#ifdef __linux__
+  for(size_t n = 6; n < statistics.size(); n++)
+    BOOST_CHECK(statistics[n].counters.task_clock >= 0);
+#endif
+})
+#endif
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, counters, totals, "Tests summing and printing the events counted", {
+  std::vector<permutation_statistics<0>> statistics(3);
+  statistics[0].counters.cycles = 100;
+  statistics[0].counters.instructions = 200;
+  statistics[1].counters.cycles = 50;
+  statistics[2].counters.page_faults = 7;
+  const performance_counters total = total_counters(statistics);
+  BOOST_CHECK(150 == total.cycles && 200 == total.instructions && 7 == total.page_faults);
+  // Events counted by no permutation remain uncounted
+  BOOST_CHECK(-1 == total.cache_misses && -1 == total.task_clock && -1 == total.context_switches);
+  std::ostringstream s;
+  s << total;
+  BOOST_CHECK(s.str() == "cycles 150, instructions 200 (IPC 1.33333), page faults 7");
+  s.str(std::string());
+  s << performance_counters();
+  BOOST_CHECK(s.str() == "no counters available");
+})
@@ -0,0 +1,97 @@
+/* Tests for t-way covering arrays of dimensions
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <array>
+#include <set>
+
+namespace covering_array_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  using row = parameters<result<int>, parameters<int, int, int, int, int, int, int>>;
+  inline row make_row(int a, int b, int c, int d, int e, int f, int g) { return row{a + b + c + d + e + f + g, {a, b, c, d, e, f, g}}; }
+  static const std::vector<int> three{0, 1, 2}, four{0, 1, 2, 3};
+  static const int sizes[7] = {3, 3, 4, 3, 4, 3, 2};
+
+  // The number of combinations of values of any `strength` dimensions not appearing in `sequence`
+  template <class Sequence> inline size_t missing(const Sequence &sequence, size_t strength)
+  {
+    std::vector<std::array<int, 7>> rows;
+    for(const row &r : sequence)
+    {
+      const auto &p = std::get<1>(r);
+      rows.push_back({{std::get<0>(p), std::get<1>(p), std::get<2>(p), std::get<3>(p), std::get<4>(p), std::get<5>(p), std::get<6>(p)}});
+    }
+    size_t ret = 0;
+    for(unsigned mask = 0; mask < 128; mask++)
+    {
+      size_t dims = 0, combinations = 1;
+      for(int n = 0; n < 7; n++)
+      {
+        if(mask & (1u << n))
+        {
+          dims++;
+          combinations *= sizes[n];
+        }
+      }
+      if(dims != strength)
+        continue;
+      std::set<std::vector<int>> seen;
+      for(const auto &r : rows)
+      {
+        std::vector<int> v;
+        for(int n = 0; n < 7; n++)
+        {
+          if(mask & (1u << n))
+            v.push_back(r[n]);
+        }
+        seen.insert(std::move(v));
+      }
+      ret += combinations - seen.size();
+    }
+    return ret;
+  }
+}  // namespace covering_array_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, covering_array, coverage, "Tests that every combination of values of any strength dimensions appears", {
+  using namespace covering_array_test;
+  for(size_t strength = 1; strength <= 4; strength++)
+  {
+    auto sequence = covering_array<row>(strength, 42, make_row, three, three, four, three, four, three, std::array<int, 2>{{0, 1}});
+    BOOST_CHECK(missing(sequence, strength) == 0);
+    // Far fewer than the 15552 of the full cartesian product
+    BOOST_CHECK(sequence.size() < 15552 / 4);
+    // The same seed must always generate the same sequence
+    auto again = covering_array<row>(strength, 42, make_row, three, three, four, three, four, three, std::array<int, 2>{{0, 1}});
+    BOOST_REQUIRE(again.size() == sequence.size());
+    size_t differing = 0;
+    for(size_t n = 0; n < sequence.size(); n++)
+      differing += !(sequence[n] == again[n]);
+    BOOST_CHECK(differing == 0);
+  }
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, covering_array, permute, "Tests that a pairwise sequence can be permuted", {
+  using namespace covering_array_test;
+  auto permuter = mt_permute_parameters<result<int>, parameters<int, int, int, int, int, int, int>>(
+  pairwise<row>(make_row, three, three, four, three, four, three, power_set<int>{1, 2}));
+  auto results = permuter([](int a, int b, int c, int d, int e, int f, int g) -> result<int> { return a + b + c + d + e + f + g; });
+  BOOST_CHECK(results.size() > 0);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, covering_array, degenerate, "Tests covering arrays of degenerate strengths and dimensions", {
+  using namespace covering_array_test;
+  // A strength beyond the number of dimensions is the full cartesian product
+  using small_row = parameters<result<int>, parameters<int, int>>;
+  auto full = covering_array<small_row>(5, 0, [](int a, int b) { return small_row{a + b, {a, b}}; }, three, four);
+  BOOST_CHECK(full.size() == 12);
+  // A strength of zero is treated as one
+  auto ones = covering_array<small_row>(0, 0, [](int a, int b) { return small_row{a + b, {a, b}}; }, three, four);
+  BOOST_CHECK(ones.size() >= 4 && ones.size() < 12);
+  // Any empty dimension yields an empty sequence
+  auto empty = pairwise<small_row>([](int a, int b) { return small_row{a + b, {a, b}}; }, three, std::vector<int>{});
+  BOOST_CHECK(empty.size() == 0 && empty.empty());
+})
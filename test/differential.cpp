@@ -0,0 +1,93 @@
+/* Tests for comparing two implementations of a test kernel over the same permutations
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <atomic>
+
+namespace differential_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  inline differential_options quick_options()
+  {
+    differential_options ret;
+    ret.benchmark.warmup = 1;
+    ret.benchmark.min_repetitions = 10;
+    ret.benchmark.max_repetitions = 20;
+    ret.benchmark.max_time = std::chrono::milliseconds(200);
+    return ret;
+  }
+  inline std::vector<std::chrono::nanoseconds> samples(std::initializer_list<int> v)
+  {
+    std::vector<std::chrono::nanoseconds> ret;
+    for(int i : v)
+      ret.push_back(std::chrono::nanoseconds(i));
+    return ret;
+  }
+}  // namespace differential_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, differential, agree, "Tests that outcomes are compared with each other, including failures", {
+  using namespace differential_test;
+  // The expected outcomes are ignored
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table{{99, {0}}, {99, {1}}, {99, {-2}}, {99, {3}}, {99, {4}}};
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  std::atomic<int> calls_a{0}, calls_b{0};
+  auto results = permuter.differential(
+  [&](int v) -> result<int>
+  {
+    calls_a++;
+    if(4 == v)
+      throw std::runtime_error("a failed");
+    return permuter_test_kernels::identity(v);
+  },
+  [&](int v) -> result<int>
+  {
+    calls_b++;
+    if(3 == v)
+      throw std::runtime_error("b failed");
+    return permuter_test_kernels::identity(v);
+  },
+  quick_options());
+  BOOST_REQUIRE(results.size() == 5);
+  BOOST_CHECK(results[0].agree && results[1].agree);
+  // Both failing identically agree
+  BOOST_CHECK(results[2].agree && results[2].a->has_error());
+  BOOST_CHECK(!results[3].agree && results[3].b->error() == make_error_code(kerneltest_errc::kernel_exception_thrown));
+  BOOST_CHECK(!results[4].agree && results[4].a->error() == make_error_code(kerneltest_errc::kernel_exception_thrown));
+  BOOST_CHECK(calls_a == calls_b);
+  for(auto &r : results)
+    BOOST_CHECK(r.timing.a.repetitions >= 10 && r.timing.a.repetitions <= 20 && r.timing.a.repetitions == r.timing.b.repetitions);
+  BOOST_CHECK(!pretty_print_differential(permuter, results));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, differential, speedup, "Tests that a faster second kernel is reported as a significant speedup", {
+  using namespace differential_test;
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table{{0, {0}}, {1, {1}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  auto results = permuter.differential([](int v) { return permuter_test_kernels::sleeps(v, 2); }, [](int v) { return permuter_test_kernels::identity(v); },
+                                       quick_options());
+  for(auto &r : results)
+  {
+    BOOST_CHECK(r.agree);
+    BOOST_CHECK(r.timing.speedup > 10);
+    BOOST_CHECK(r.timing.significant && r.timing.p_value < 0.05);
+    BOOST_CHECK(r.timing.a.median >= std::chrono::milliseconds(2));
+  }
+  BOOST_CHECK(pretty_print_differential(permuter, results));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, differential, signed_rank, "Tests the Wilcoxon signed rank test upon known samples", {
+  using namespace differential_test;
+  // Every difference positive: W+ = 55, mean 27.5, variance 96.25, so p = erfc(27 / sqrt(96.25) / sqrt(2))
+  const auto a = samples({1, 2, 3, 4, 5, 6, 7, 8, 9, 10}), zeros = samples({0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+  const double p = detail::signed_rank_p_value(a, zeros);
+  BOOST_CHECK(std::fabs(p - std::erfc(27 / std::sqrt(96.25) / std::sqrt(2.0))) < 1e-9);
+  BOOST_CHECK(std::fabs(p - detail::signed_rank_p_value(zeros, a)) < 1e-12);
+  // Identical samples, and differences balanced in sign, are not significant
+  BOOST_CHECK(1 == detail::signed_rank_p_value(a, a));
+  BOOST_CHECK(detail::signed_rank_p_value(samples({5, 5, 5, 5, 5, 5}), samples({4, 6, 3, 7, 2, 8})) > 0.5);
+  BOOST_CHECK(1 == detail::signed_rank_p_value({}, {}));
+})
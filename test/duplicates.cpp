@@ -0,0 +1,122 @@
+/* Tests for reusing the outcomes of permutations duplicating earlier permutations
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <atomic>
+
+namespace duplicates_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  // A kernel parameter which cannot be printed
+  struct unprintable
+  {
+    int v;
+  };
+
+  using row = parameters<result<int>, parameters<int>>;
+  inline std::vector<row> table() { return {{1, {1}}, {2, {2}}, {1, {1}}, {1, {1}}, {3, {2}}, {4, {4}}, {make_error_code(std::errc::invalid_argument), {-1}}, {make_error_code(std::errc::invalid_argument), {-1}}}; }
+}  // namespace duplicates_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, duplicates, policies, "Tests that duplicates are executed once unless told otherwise, and checked against their own expected outcomes", {
+  using namespace duplicates_test;
+  for(auto policy : {duplicate_policy::execute, duplicate_policy::reuse, duplicate_policy::reuse_and_warn})
+  {
+    auto permuter = st_permute_parameters<result<int>, parameters<int>>(table());
+    permuter.options().duplicates = policy;
+    std::atomic<int> calls{0};
+    auto results = permuter(
+    [&](int v)
+    {
+      calls++;
+      return permuter_test_kernels::identity(v);
+    });
+    BOOST_CHECK(calls == ((duplicate_policy::execute == policy) ? 8 : 4));
+    BOOST_REQUIRE(results.size() == 8);
+    for(size_t n = 0; n < results.size(); n++)
+      BOOST_CHECK(results[n]);
+    // The duplicate expecting a different outcome still fails
+    size_t failures = 0;
+    permuter.check(results,
+                   [&](size_t idx, auto &, auto &)
+                   {
+                     BOOST_CHECK(4 == idx);
+                     failures++;
+                     return false;
+                   });
+    BOOST_CHECK(failures == 1);
+    BOOST_CHECK(permuter_test_kernels::count_if(results, [](const result<int> &v) { return v.has_error() && v.error() == std::errc::invalid_argument; }) == 2);
+  }
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, duplicates, hooks, "Tests that permutations differing only in hook parameters are not duplicates", {
+  using hook_row = parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>;
+  std::vector<hook_row> table{{1, {1}, {0}}, {1, {1}, {1}}, {1, {1}, {0}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>(
+  std::move(table), hooks::custom([](auto &, auto &, size_t, int v) { return v; }, [](int) {}, "hook"));
+  permuter.options().duplicates = duplicate_policy::reuse;
+  std::atomic<int> calls{0};
+  auto results = permuter(
+  [&](int v)
+  {
+    calls++;
+    return permuter_test_kernels::identity(v);
+  });
+  BOOST_CHECK(calls == 2);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, duplicates, unprintable, "Tests that duplicates of unprintable parameters are always executed", {
+  using namespace duplicates_test;
+  using unprintable_row = parameters<result<int>, parameters<unprintable>>;
+  std::vector<unprintable_row> table{{1, {unprintable{1}}}, {1, {unprintable{1}}}, {1, {unprintable{1}}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<unprintable>>(std::move(table));
+  permuter.options().duplicates = duplicate_policy::reuse;
+  std::atomic<int> calls{0};
+  auto results = permuter(
+  [&](unprintable v)
+  {
+    calls++;
+    return permuter_test_kernels::identity(v.v);
+  });
+  BOOST_CHECK(calls == 3);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, duplicates, stream, "Tests that streamed checks see every duplicate of a concurrently executed table", {
+  using many_row = parameters<result<int>, parameters<int, int>>;
+  std::vector<many_row> table;
+  for(int n = 0; n < 2000; n++)
+    table.push_back({n % 7, {n % 7, n % 3}});
+  auto permuter = mt_permute_parameters<result<int>, parameters<int, int>>(std::move(table));
+  permuter.options().duplicates = duplicate_policy::reuse;
+  std::atomic<int> calls{0};
+  std::atomic<size_t> checked{0};
+  BOOST_CHECK(permuter.stream(
+  [&](int a, int)
+  {
+    calls++;
+    return permuter_test_kernels::identity(a);
+  },
+  [&](size_t, auto &, auto &)
+  {
+    checked++;
+    return false;
+  }));
+  BOOST_CHECK(calls == 21);
+  BOOST_CHECK(checked == 0);
+})
+
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(unit, kerneltest, duplicates, crash, "Tests that duplicates of a crashing permutation all fail", {
+  using namespace duplicates_test;
+  std::vector<row> table{{0, {0}}, {make_error_code(kerneltest_errc::kernel_signal_thrown), {5}}, {0, {0}}, {make_error_code(kerneltest_errc::kernel_signal_thrown), {5}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().duplicates = duplicate_policy::reuse;
+  permuter.options().isolation.emplace();
+  auto results = permuter([](int v) { return permuter_test_kernels::crashes(v, 5); });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_signal_thrown) == 2);
+})
+#endif
@@ -0,0 +1,102 @@
+/* Tests for the persistent work stealing executor
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <atomic>
+#include <set>
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, executor, run, "Tests that run() calls every position exactly once", {
+  permutation_executor executor(4);
+  BOOST_CHECK(executor.concurrency() == 4);
+  std::vector<std::atomic<int>> calls(10000);
+  std::atomic<size_t> bad_worker{0};
+  executor.run(calls.size(),
+               [&](size_t pos, size_t worker)
+               {
+                 calls[pos]++;
+                 if(worker >= 4)
+                   bad_worker++;
+               });
+  size_t wrong = 0;
+  for(auto &i : calls)
+    wrong += (i.load() != 1);
+  BOOST_CHECK(wrong == 0);
+  BOOST_CHECK(bad_worker == 0);
+  // An empty run must return immediately
+  executor.run(0, [&](size_t, size_t) { bad_worker++; });
+  BOOST_CHECK(bad_worker == 0);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, executor, run_in_order, "Tests that run_in_order() begins positions in ascending order", {
+  permutation_executor executor(4);
+  std::mutex lock;
+  std::vector<size_t> begun;
+  executor.run_in_order(1000,
+                        [&](size_t pos, size_t)
+                        {
+                          std::lock_guard<std::mutex> g(lock);
+                          begun.push_back(pos);
+                        });
+  BOOST_CHECK(begun.size() == 1000);
+  // Each worker may be descheduled between claiming and recording, so only approximately ordered
+  size_t far_out = 0;
+  for(size_t n = 0; n < begun.size(); n++)
+    far_out += (begun[n] + 8 < n || n + 8 < begun[n]);
+  BOOST_CHECK(far_out == 0);
+  BOOST_CHECK(std::set<size_t>(begun.begin(), begun.end()).size() == 1000);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, executor, set_concurrency, "Tests that changing the concurrency replaces the workers", {
+  permutation_executor executor(2);
+  BOOST_CHECK(executor.concurrency() == 2);
+  executor.set_concurrency(5);
+  BOOST_CHECK(executor.concurrency() == 5);
+  std::mutex lock;
+  std::set<size_t> workers;
+  executor.run(
+  1000,
+  [&](size_t, size_t worker)
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    std::lock_guard<std::mutex> g(lock);
+    workers.insert(worker);
+  },
+  1);
+  BOOST_CHECK(!workers.empty() && *workers.rbegin() < 5);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, executor, permuter, "Tests that a multithreaded permuter executes every permutation upon the executor", {
+  permutation_executor executor(3);
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(5000));
+  permuter.options().executor = &executor;
+  std::atomic<size_t> calls{0}, elsewhere{0};
+  auto results = permuter(
+  [&](int v)
+  {
+    calls++;
+    // Test assertions are not thread safe, so are only made once the permuter returns
+    if(detail::this_thread_executor() != &executor)
+      elsewhere++;
+    return permuter_test_kernels::identity(v);
+  });
+  BOOST_CHECK(calls == 5000);
+  BOOST_CHECK(elsewhere == 0);
+  BOOST_CHECK(results.size() == 5000);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, executor, current_test_kernel, "Tests that workers see the calling thread's current test kernel", {
+  permutation_executor executor(3);
+  const std::string expected = detail::current_test_kernel_path();
+  BOOST_REQUIRE(expected != "////");
+  std::atomic<size_t> mismatched{0};
+  executor.run(1000,
+               [&](size_t, size_t)
+               {
+                 std::this_thread::sleep_for(std::chrono::microseconds(10));
+                 if(detail::current_test_kernel_path() != expected)
+                   mismatched++;
+               });
+  BOOST_CHECK(mismatched == 0);
+})
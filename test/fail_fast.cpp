@@ -0,0 +1,95 @@
+/* Tests for cancelling the remaining permutations once enough have failed
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <atomic>
+
+namespace fail_fast_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  // Every third permutation fails unexpectedly
+  inline result<int> every_third_fails(int v)
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    return (0 == v % 3) ? -1 : v;
+  }
+  inline std::vector<parameters<result<int>, parameters<int>>> table()
+  {
+    std::vector<parameters<result<int>, parameters<int>>> ret;
+    for(int n = 0; n < 1000; n++)
+      ret.push_back({n, {n}});
+    return ret;
+  }
+}  // namespace fail_fast_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, fail_fast, call, "Tests that permutations not begun after enough failures are skipped", {
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(fail_fast_test::table());
+  permuter.options().fail_fast = 5;
+  std::atomic<size_t> ran{0};
+  auto results = permuter(
+  [&](int v)
+  {
+    ran++;
+    return fail_fast_test::every_third_fails(v);
+  });
+  const size_t skipped = permuter_test_kernels::count_errors(results, kerneltest_errc::permutation_skipped);
+  BOOST_CHECK(skipped > 0);
+  BOOST_CHECK(ran + skipped == 1000);
+  size_t failures = 0;
+  BOOST_CHECK(!permuter.check(results,
+                              [&](size_t, auto &, auto &)
+                              {
+                                failures++;
+                                return false;
+                              }));
+  // Skipped permutations are not reported, and permutations already executing may also fail
+  BOOST_CHECK(failures >= 5 && failures <= 5 + permuter.executor().concurrency());
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, fail_fast, stream, "Tests that streaming stops beginning permutations after enough failures", {
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(fail_fast_test::table());
+  permuter.options().fail_fast = 5;
+  std::atomic<size_t> ran{0};
+  size_t failures = 0;
+  BOOST_CHECK(!permuter.stream(
+  [&](int v)
+  {
+    ran++;
+    return fail_fast_test::every_third_fails(v);
+  },
+  [&](size_t, auto &, auto &)
+  {
+    failures++;
+    return false;
+  }));
+  BOOST_CHECK(ran < 1000);
+  BOOST_CHECK(failures >= 5 && failures < ran);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, fail_fast, passing, "Tests that nothing is skipped if too few permutations fail", {
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(1000));
+  permuter.options().fail_fast = 1;
+  auto results = permuter(permuter_test_kernels::identity);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::permutation_skipped) == 0);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(unit, kerneltest, fail_fast, isolation, "Tests that crashes in child processes count towards failing fast", {
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(fail_fast_test::table());
+  permuter.options().fail_fast = 5;
+  permuter.options().isolation.emplace();
+  permuter.options().isolation->processes = 4;
+  auto results = permuter(
+  [](int v)
+  {
+    if(0 == v % 3)
+      abort();
+    return fail_fast_test::every_third_fails(v);
+  });
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_signal_thrown) >= 5);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::permutation_skipped) > 0);
+})
+#endif
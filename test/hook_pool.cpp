@@ -0,0 +1,164 @@
+/* Tests for reusing the instances of resettable hooks between permutations
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+
+namespace hook_pool_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  // A resettable hook counting its instances and how often they were reset and released
+  static std::atomic<int> created{0}, alive{0}, resets{0}, releases{0};
+  struct counting_hook
+  {
+    static constexpr bool is_resettable = true;
+    template <class Parent, class RetType> struct impl
+    {
+      bool owner{true};
+      impl() { created++, alive++; }
+      impl(impl &&o) noexcept : owner(o.owner) { o.owner = false; }
+      ~impl()
+      {
+        if(owner)
+          alive--;
+      }
+      void reset(Parent *, RetType &, size_t) { resets++; }
+      void release() { releases++; }
+    };
+    template <class Parent, class RetType> auto operator()(Parent *, RetType &, size_t, int) const { return impl<Parent, RetType>(); }
+    std::string print(int v) const { return std::to_string(v); }
+  };
+  inline void reset_counts() { created = alive = resets = releases = 0; }
+
+  static const char directory[] = "kerneltest_hook_pool_test";
+
+  inline std::string contents_of(const char *path)
+  {
+    std::ifstream s(path);
+    return std::string(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>());
+  }
+  // Creates the workspace templates of this test, and makes them the templates used by `filesystem_setup()`
+  inline void make_templates()
+  {
+    filesystem::remove_all(directory);
+    const filesystem::path base = filesystem::absolute(directory);
+    const filesystem::path templates = base / "test" / "tests" / "hook_pool";
+    filesystem::create_directories(templates / "existing1" / "sub");
+    filesystem::create_directories(templates / "existing2");
+    std::ofstream(templates / "existing1" / "a.txt") << "hello";
+    std::ofstream(templates / "existing1" / "sub" / "b.txt") << "world";
+    std::ofstream(templates / "existing2" / "z.txt") << "two";
+    setenv("KERNELTEST_KERNELTEST_HOME", base.string().c_str(), 1);
+  }
+}  // namespace hook_pool_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, hook_pool, reuse, "Tests that one instance per distinct hook parameters is reset and reused", {
+  using namespace hook_pool_test;
+  reset_counts();
+  using row = parameters<result<int>, parameters<int>, parameters<int>>;
+  std::vector<row> table{{0, {0}, {0}}, {1, {1}, {1}}, {2, {2}, {2}}, {3, {3}, {0}}, {4, {4}, {1}}, {5, {5}, {2}}, {6, {6}, {0}}, {7, {7}, {0}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>, parameters<int>>(std::move(table), counting_hook{});
+  auto results = permuter(permuter_test_kernels::identity);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(created == 3);
+  BOOST_CHECK(resets == 5);
+  BOOST_CHECK(releases == 8);
+  // The pool is destroyed with the run
+  BOOST_CHECK(alive == 0);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, hook_pool, workers, "Tests that each worker keeps its own instances", {
+  using namespace hook_pool_test;
+  reset_counts();
+  using row = parameters<result<int>, parameters<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 3000; n++)
+    table.push_back({n, {n}, {n % 3}});
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>, parameters<int>>(std::move(table), counting_hook{});
+  auto results = permuter(permuter_test_kernels::identity);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(created >= 3 && static_cast<size_t>(created) <= 3 * permuter.executor().concurrency());
+  BOOST_CHECK(created + resets == 3000);
+  BOOST_CHECK(alive == 0);
+})
+
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(unit, kerneltest, hook_pool, isolation, "Tests that instances are never reused by isolated permutations", {
+  using namespace hook_pool_test;
+  reset_counts();
+  using row = parameters<result<int>, parameters<int>, parameters<int>>;
+  std::vector<row> table{{0, {0}, {0}}, {1, {1}, {0}}, {2, {2}, {0}}, {3, {3}, {0}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>, parameters<int>>(std::move(table), counting_hook{});
+  permuter.options().isolation.emplace();
+  auto results = permuter([](int v) { return (resets != 0) ? result<int>(-1) : permuter_test_kernels::identity(v); });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(resets == 0);
+})
+#endif
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, hook_pool, workspace, "Tests that reused workspaces are restored to their template between permutations", {
+  using namespace hook_pool_test;
+  make_templates();
+  const filesystem::path starting = filesystem::current_path();
+  using row = parameters<result<int>, parameters<int>, hooks::filesystem_setup_parameters>;
+  std::vector<row> table;
+  for(int n = 0; n < 12; n++)
+    table.push_back({0, {n}, {(n % 3) ? "existing1" : "existing2"}});
+  auto permuter = st_permute_parameters<result<int>, parameters<int>, hooks::filesystem_setup_parameters>(std::move(table), hooks::filesystem_setup());
+  auto results = permuter(
+  [&](int v) -> result<int>
+  {
+    int bad = 0;
+    if(filesystem::current_path() == starting)
+      bad |= 1;
+    if(v % 3)
+    {
+      if(contents_of("a.txt") != "hello" || contents_of("sub/b.txt") != "world" || filesystem::exists("c.txt"))
+        bad |= 2;
+      // Remove, modify and add files, and add a directory
+      filesystem::remove("a.txt");
+      std::ofstream("sub/b.txt") << "changed by " << v;
+      std::ofstream("c.txt") << "added";
+      filesystem::create_directory("newdir");
+      std::ofstream("newdir/d.txt") << "added";
+    }
+    else
+    {
+      if(contents_of("z.txt") != "two" || filesystem::exists("a.txt"))
+        bad |= 4;
+      std::ofstream("z.txt") << "t";
+    }
+    return bad;
+  });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  // The working directory is restored after each permutation, and the workspaces removed with the run
+  BOOST_CHECK(filesystem::current_path() == starting);
+  for(auto &i : filesystem::directory_iterator(starting))
+    BOOST_CHECK(i.path().filename().string().compare(0, 21, "kerneltest_workspace_") != 0);
+  filesystem::remove_all(directory);
+})
+
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(unit, kerneltest, hook_pool, rewritten, "Tests that files rewritten with the same size and modification time are restored", {
+  using namespace hook_pool_test;
+  make_templates();
+  using row = parameters<result<int>, parameters<int>, hooks::filesystem_setup_parameters>;
+  std::vector<row> table{{0, {0}, {"existing1"}}, {0, {1}, {"existing1"}}, {0, {2}, {"existing1"}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>, hooks::filesystem_setup_parameters>(std::move(table), hooks::filesystem_setup());
+  auto results = permuter(
+  [](int) -> result<int>
+  {
+    const int bad = (contents_of("a.txt") != "hello") ? 1 : 0;
+    const auto modified = filesystem::last_write_time("a.txt");
+    std::ofstream("a.txt") << "HELLO";
+    filesystem::last_write_time("a.txt", modified);
+    return bad;
+  });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  filesystem::remove_all(directory);
+})
+#endif
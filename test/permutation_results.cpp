@@ -0,0 +1,109 @@
+/* Tests for the cache line chunked container of permutation results
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <memory>
+#include <stdexcept>
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, permutation_results, optional_like, "Tests that results behave like the optionals of earlier versions", {
+  permutation_results<result<int>> results(200);
+  const auto &c = results;
+  BOOST_CHECK(results.size() == 200);
+  BOOST_CHECK(!c[0].has_value() && !c[0]);
+  results[3] = result<int>(5);
+  results[4] = optional<result<int>>(result<int>(6));
+  results[5].emplace(7);
+  auto &&ref = results[6];
+  ref = result<int>(1);
+  BOOST_CHECK(results.present(6));
+  ref.reset();
+  results[7] = results[3];
+  results[8] = optional<result<int>>();
+  BOOST_CHECK(c[3].value().value() == 5);
+  BOOST_CHECK(results[4]->value() == 6);
+  BOOST_CHECK((*results[5]).value() == 7);
+  BOOST_CHECK(!c[6].has_value() && !results.present(6));
+  BOOST_CHECK(c[7].value().value() == 5);
+  BOOST_CHECK(!c[8].has_value());
+  BOOST_CHECK(c[0].value_or(result<int>(42)).value() == 42);
+  // Writing through a reference must not change the copy it was copied from
+  results[3].value() = result<int>(9);
+  BOOST_CHECK(c[3]->value() == 9 && c[7]->value() == 5);
+  optional<result<int>> copied = results[3];
+  BOOST_CHECK(copied && copied->value() == 9);
+  size_t present = 0;
+  for(auto i : c)
+    present += i.has_value();
+  BOOST_CHECK(present == 4);
+  BOOST_CHECK(detail::make_permutation_results_type<permutation_results<int>>(10).size() == 10);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, permutation_results, status, "Tests that the status of each result is kept without reading the outcomes", {
+  permutation_results<result<int>> results(100);
+  results.assign(1, result<int>(5));
+  results.assign(2, result<int>(make_error_code(std::errc::invalid_argument)));
+  results[3] = result<int>(6);
+  BOOST_CHECK(results.status(0) == permutation_status::absent);
+  BOOST_CHECK(results.status(1) == permutation_status::value);
+  BOOST_CHECK(results.status(2) == permutation_status::error);
+  BOOST_CHECK(results.status(3) == permutation_status::value);
+  // Replacing, resetting and modifying in place update the status
+  results.assign(1, result<int>(make_error_code(std::errc::invalid_argument)));
+  results.reset(2);
+  results[3].value() = result<int>(make_error_code(std::errc::invalid_argument));
+  BOOST_CHECK(results.status(1) == permutation_status::error);
+  BOOST_CHECK(results.status(2) == permutation_status::absent);
+  BOOST_CHECK(results.status(3) == permutation_status::error);
+  auto copy = results;
+  BOOST_CHECK(copy.status(1) == permutation_status::error && copy.status(2) == permutation_status::absent);
+#if !KERNELTEST_EXPERIMENTAL_STATUS_CODE && defined(__cpp_exceptions)
+  permutation_results<outcome<int>> outcomes(2);
+  outcomes.assign(0, outcome<int>(std::make_exception_ptr(std::runtime_error("failed"))));
+  BOOST_CHECK(outcomes.status(0) == permutation_status::exception);
+  BOOST_CHECK(outcomes.status(1) == permutation_status::absent);
+#endif
+  // Outcomes which are not results always have values
+  permutation_results<int> ints(1);
+  ints.assign(0, 0);
+  BOOST_CHECK(ints.status(0) == permutation_status::value);
+})
+
+#ifdef __cpp_exceptions
+KERNELTEST_TEST_KERNEL(unit, kerneltest, permutation_results, absent, "Tests that accessing the value of an absent result throws", {
+  permutation_results<result<int>> results(10);
+  const auto &c = results;
+  BOOST_CHECK_THROW((void) c[0].value(), std::bad_optional_access);
+  BOOST_CHECK_THROW((void) results[9].value(), std::bad_optional_access);
+})
+#endif
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, permutation_results, lifetime, "Tests that outcomes are destroyed when replaced, reset, or the container is", {
+  auto tracker = std::make_shared<int>(0);
+  {
+    permutation_results<std::shared_ptr<int>> results(1000);
+    for(size_t n = 0; n < results.size(); n += 3)
+      results.assign(n, tracker);
+    BOOST_CHECK(tracker.use_count() == 1 + 334);
+    results.assign(0, std::make_shared<int>(1));
+    results.reset(3);
+    BOOST_CHECK(tracker.use_count() == 1 + 332);
+    auto copy = results;
+    BOOST_CHECK(tracker.use_count() == 1 + 664);
+    auto moved = std::move(copy);
+    BOOST_CHECK(tracker.use_count() == 1 + 664);
+    BOOST_CHECK(moved.size() == 1000 && *moved[0].value() == 1);
+  }
+  BOOST_CHECK(tracker.use_count() == 1);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, permutation_results, permuter, "Tests that a permuter fills every result", {
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(10000));
+  auto results = permuter(permuter_test_kernels::identity);
+  BOOST_CHECK(results.size() == 10000);
+  size_t present = 0;
+  for(size_t n = 0; n < results.size(); n++)
+    present += results.present(n);
+  BOOST_CHECK(present == 10000);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
@@ -0,0 +1,98 @@
+/* Small test kernels exercising the features of the permuter
+*/
+
+#include "../include/kerneltest.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace permuter_test_kernels
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  //! Returns its argument, or fails with `invalid_argument` if it is negative
+  inline result<int> identity(int v) noexcept
+  {
+    if(v < 0)
+      return make_error_code(std::errc::invalid_argument);
+    return v;
+  }
+  //! The expected outcome of `identity()`
+  inline result<int> identity_expected(int v) noexcept
+  {
+    if(v < 0)
+      return make_error_code(std::errc::invalid_argument);
+    return v;
+  }
+  //! As `identity()`, but dereferences a null pointer if its argument is `crash_on`
+  inline result<int> crashes(int v, int crash_on) noexcept
+  {
+    if(v == crash_on)
+    {
+      volatile int *p = nullptr;
+      *p = v;
+    }
+    return identity(v);
+  }
+  //! As `identity()`, but sleeps for `ms` milliseconds first
+  inline result<int> sleeps(int v, int ms) noexcept
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    return identity(v);
+  }
+  //! Never returns
+  inline result<int> hangs(int) noexcept
+  {
+    for(;;)
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+  }
+  //! Spins for roughly `iterations` iterations, returning how many it did
+  inline result<int> spins(int iterations) noexcept
+  {
+    volatile int n = 0;
+    while(n < iterations)
+      n = n + 1;
+    return n;
+  }
+  //! Allocates `count` blocks of `bytes` bytes, returning how many it allocated
+  inline result<int> allocates(int count, int bytes)
+  {
+    std::vector<std::unique_ptr<char[]>> blocks;
+    for(int n = 0; n < count; n++)
+      blocks.emplace_back(new char[bytes]);
+    return static_cast<int>(blocks.size());
+  }
+
+  //! A table of `count` permutations of `identity()`, every seventh of which is expected to fail
+  inline std::vector<parameters<result<int>, parameters<int>>> identity_table(int count)
+  {
+    std::vector<parameters<result<int>, parameters<int>>> ret;
+    ret.reserve(count);
+    for(int n = 0; n < count; n++)
+    {
+      const int v = (6 == n % 7) ? -n : n;
+      ret.push_back({identity_expected(v), {v}});
+    }
+    return ret;
+  }
+  //! The number of failures in `results` for which `pred(outcome)` is true
+  template <class Results, class Pred> inline size_t count_if(const Results &results, Pred &&pred)
+  {
+    size_t ret = 0;
+    for(size_t n = 0; n < results.size(); n++)
+    {
+      if(results[n] && pred(*results[n]))
+        ret++;
+    }
+    return ret;
+  }
+  //! The number of outcomes in `results` which failed with `code`
+  template <class Results> inline size_t count_errors(const Results &results, kerneltest_errc code)
+  {
+    return count_if(results, [code](const auto &v) { return v.has_error() && v.error() == make_error_code(code); });
+  }
+}  // namespace permuter_test_kernels
@@ -0,0 +1,104 @@
+/* Tests for pinning the worker threads of an executor to CPUs
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <set>
+
+namespace placement_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  inline bool in_topology(int cpu)
+  {
+    const auto &topology = detail::cpu_topology();
+    return std::any_of(topology.begin(), topology.end(), [cpu](const detail::cpu_info &i) { return i.cpu == cpu; });
+  }
+}  // namespace placement_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, placement, policies, "Tests that every policy selects CPUs within the affinity mask", {
+  const auto &topology = detail::cpu_topology();
+  BOOST_CHECK(detail::placement_cpus(worker_placement_options(), 4).empty());
+#ifdef __linux__
+  BOOST_REQUIRE(!topology.empty());
+  for(auto policy : {placement_policy::compact, placement_policy::scatter, placement_policy::physical_cores})
+  {
+    worker_placement_options options;
+    options.policy = policy;
+    const size_t workers = topology.size() * 2 + 1;
+    auto cpus = detail::placement_cpus(options, workers);
+    BOOST_REQUIRE(cpus.size() == workers);
+    for(int cpu : cpus)
+      BOOST_CHECK(placement_test::in_topology(cpu));
+    // Workers wrap around once every selected CPU is taken
+    const size_t distinct = std::set<int>(cpus.begin(), cpus.end()).size();
+    BOOST_CHECK(cpus[distinct] == cpus[0]);
+    if(placement_policy::physical_cores == policy)
+      BOOST_CHECK(distinct == detail::physical_core_count());
+    else
+      BOOST_CHECK(distinct == topology.size());
+  }
+#else
+  (void) topology;
+#endif
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, placement, cpus, "Tests that explicitly listed CPUs outside the affinity mask are skipped", {
+  worker_placement_options options;
+  options.policy = placement_policy::cpus;
+  options.cpus = {9999, -3, 100000};
+  BOOST_CHECK(detail::placement_cpus(options, 3).empty());
+#ifdef __linux__
+  const int first = detail::cpu_topology().front().cpu;
+  options.cpus = {9999, first, -3};
+  auto cpus = detail::placement_cpus(options, 3);
+  BOOST_CHECK((cpus == std::vector<int>{first, first, first}));
+#endif
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, placement, executor, "Tests that permutations record where they executed and can use their worker's scratch memory", {
+  worker_placement_options options;
+  options.policy = placement_policy::compact;
+  options.scratch_bytes = 1 << 20;
+  permutation_executor executor(3, options);
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(100));
+  permuter.options().executor = &executor;
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter(
+  [](int v) -> result<int>
+  {
+    if(permutation_executor::worker_scratch() == nullptr || permutation_executor::worker_scratch_size() != (1 << 20))
+      return make_error_code(std::errc::not_enough_memory);
+    return permuter_test_kernels::identity(v);
+  },
+  statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  for(const auto &s : statistics)
+  {
+    BOOST_CHECK(s.placement.worker >= 0 && s.placement.worker < 3);
+#ifdef __linux__
+    BOOST_CHECK(s.placement.pinned && placement_test::in_topology(s.placement.cpu));
+#endif
+  }
+  // The calling thread is not a worker
+  BOOST_CHECK(permutation_executor::worker_scratch() == nullptr);
+})
+
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(unit, kerneltest, placement, environment, "Tests parsing the placement from the environment", {
+  setenv("KERNELTEST_PLACEMENT", "scatter", 1);
+  setenv("KERNELTEST_SCRATCH_BYTES", "4096", 1);
+  auto options = worker_placement_options::from_environment();
+  BOOST_CHECK(placement_policy::scatter == options.policy && 4096 == options.scratch_bytes);
+  setenv("KERNELTEST_PLACEMENT", "0,2,5", 1);
+  options = worker_placement_options::from_environment();
+  BOOST_CHECK(placement_policy::cpus == options.policy && (options.cpus == std::vector<int>{0, 2, 5}));
+  setenv("KERNELTEST_PLACEMENT", "nonsense", 1);
+  options = worker_placement_options::from_environment();
+  BOOST_CHECK(placement_policy::none == options.policy && options.cpus.empty());
+  unsetenv("KERNELTEST_PLACEMENT");
+  unsetenv("KERNELTEST_SCRATCH_BYTES");
+  options = worker_placement_options::from_environment();
+  BOOST_CHECK(placement_policy::none == options.policy && 0 == options.scratch_bytes);
+})
+#endif
@@ -0,0 +1,151 @@
+/* Tests for executing permutations in crash isolated child processes
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <fstream>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, process_isolation, crash, "Tests that crashing permutations fail without killing the test", {
+  using row = parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 50; n++)
+    table.push_back({n, {n}, {0}});
+  // Crashes in the kernel
+  table[7] = {make_error_code(kerneltest_errc::kernel_signal_thrown), {7}, {0}};
+  table[31] = {make_error_code(kerneltest_errc::kernel_signal_thrown), {7}, {0}};
+  // Crashes in the hook setup
+  table[8] = {make_error_code(kerneltest_errc::setup_signal_thrown), {8}, {1}};
+  // Fails normally
+  table[9] = {make_error_code(std::errc::invalid_argument), {-9}, {0}};
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>(
+  std::move(table), hooks::custom(
+                    [](auto &, auto &, size_t, int crash)
+                    {
+                      if(crash)
+                        std::raise(SIGSEGV);
+                      return crash;
+                    },
+                    [](int) {}, "crashes"));
+  permuter.options().isolation.emplace();
+  permuter.options().isolation->processes = 3;
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter([](int v) { return permuter_test_kernels::crashes(v, 7); }, statistics);
+  BOOST_CHECK(results.size() == 50);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_signal_thrown) == 2);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::setup_signal_thrown) == 1);
+  // Statistics of permutations which completed are returned from the children
+  BOOST_CHECK(statistics[5].kernel.count() > 0);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, process_isolation, exit, "Tests that permutations exiting their process fail", {
+  using row = parameters<result<int>, parameters<int>>;
+  static const row table[] = {{1, {1}}, {make_error_code(kerneltest_errc::kernel_signal_thrown), {2}}, {3, {3}}};
+  auto permuter = st_permute_parameters(table);
+  permuter.options().isolation.emplace();
+  auto results = permuter(
+  [](int v)
+  {
+    if(2 == v)
+      _exit(0);
+    return permuter_test_kernels::identity(v);
+  });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, process_isolation, exception, "Tests that exceptions thrown within children are transported to the parent", {
+  using row = parameters<result<int>, parameters<int>>;
+  static const row table[] = {{1, {1}}, {make_error_code(kerneltest_errc::kernel_exception_thrown), {2}}};
+  auto permuter = st_permute_parameters(table);
+  permuter.options().isolation.emplace();
+  auto results = permuter(
+  [](int v) -> result<int>
+  {
+    if(2 == v)
+      throw std::runtime_error("kernel failed");
+    return v;
+  });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, process_isolation, own_children, "Tests that child processes not created by the permuter are not reaped by it", {
+  const pid_t mine = fork();
+  if(0 == mine)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    _exit(7);
+  }
+  using row = parameters<result<int>, parameters<int>>;
+  static const row table[] = {{1, {1}}, {2, {2}}, {3, {3}}, {make_error_code(kerneltest_errc::kernel_signal_thrown), {4}}};
+  auto permuter = st_permute_parameters(table);
+  permuter.options().isolation.emplace();
+  permuter.options().isolation->processes = 2;
+  auto results = permuter(
+  [](int v)
+  {
+    // Keep both children busy while the unrelated child exits
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    return permuter_test_kernels::crashes(v, 4);
+  });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  int status = 0;
+  BOOST_REQUIRE(waitpid(mine, &status, 0) == mine);
+  BOOST_CHECK(WIFEXITED(status) && 7 == WEXITSTATUS(status));
+})
+KERNELTEST_TEST_KERNEL(unit, kerneltest, process_isolation, not_transportable, "Tests that outcome values which cannot be transported fail rather than being fabricated", {
+  using row = parameters<result<std::string>, parameters<int>>;
+  std::vector<row> table;
+  table.emplace_back(std::string("1"), parameters<int>{1});
+  table.emplace_back(make_error_code(std::errc::invalid_argument), parameters<int>{-1});
+  auto permuter = st_permute_parameters<result<std::string>, parameters<int>>(std::move(table));
+  permuter.options().isolation.emplace();
+  auto results = permuter(
+  [](int v) -> result<std::string>
+  {
+    if(v < 0)
+      return make_error_code(std::errc::invalid_argument);
+    return std::to_string(v);
+  });
+  BOOST_REQUIRE(results[0].has_value() && results[0]->has_error());
+  BOOST_CHECK(results[0]->error() == make_error_code(kerneltest_errc::outcome_not_transportable));
+  // Errors are still transported
+  BOOST_REQUIRE(results[1].has_value() && results[1]->has_error());
+  BOOST_CHECK(results[1]->error() == make_error_code(std::errc::invalid_argument));
+})
+#ifdef __linux__
+KERNELTEST_TEST_KERNEL(unit, kerneltest, process_isolation, fork_server, "Tests that children are forked by a single threaded fork server", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 20; n++)
+    table.push_back({(5 == n) ? result<int>(make_error_code(kerneltest_errc::kernel_signal_thrown)) : result<int>(1), {n}});
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().isolation.emplace();
+  permuter.options().isolation->processes = 4;
+  // Make sure the calling process is multithreaded
+  permuter.executor().run(permuter.executor().concurrency(), [](size_t, size_t) {});
+  const pid_t parent = getpid();
+  // Returns the number of threads of the process forking this child, which must not be the test's
+  auto results = permuter(
+  [&](int v) -> result<int>
+  {
+    if(5 == v)
+      return permuter_test_kernels::crashes(v, 5);
+    if(getppid() == parent)
+      return -1;
+    std::ifstream s("/proc/" + std::to_string(getppid()) + "/status");
+    for(std::string line; std::getline(s, line);)
+    {
+      if(0 == line.compare(0, 8, "Threads:"))
+        return atoi(line.c_str() + 8);
+    }
+    return -2;
+  });
+  // Including children replacing one which crashed
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+#endif
+#endif
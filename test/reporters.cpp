@@ -0,0 +1,155 @@
+/* Tests for reporting the results of permutations
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <sstream>
+
+namespace reporters_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  inline size_t count_of(const std::string &s, const std::string &what)
+  {
+    size_t ret = 0;
+    for(size_t at = s.find(what); at != std::string::npos; at = s.find(what, at + what.size()))
+      ret++;
+    return ret;
+  }
+  using row = parameters<result<int>, parameters<int>>;
+  // Permutation 2 fails
+  inline std::vector<row> table() { return {{1, {1}}, {2, {2}}, {5, {3}}, {4, {4}}}; }
+}  // namespace reporters_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, reporters, console, "Tests that the console reporter prints failures, and successes only if asked", {
+  using namespace reporters_test;
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(table());
+  auto results = permuter(permuter_test_kernels::identity);
+  std::ostringstream out;
+  {
+    console_reporter r(false, &out);
+    BOOST_CHECK(!report(permuter, results, r));
+  }
+  BOOST_CHECK(1 == count_of(out.str(), "FAILED") && 0 == count_of(out.str(), "PASSED"));
+  BOOST_CHECK(1 == count_of(out.str(), "kernel(3)"));
+  BOOST_CHECK(1 == count_of(out.str(), "3 passed, 1 failed"));
+  out.str(std::string());
+  {
+    console_reporter r(true, &out);
+    report(permuter, results, r);
+  }
+  BOOST_CHECK(1 == count_of(out.str(), "FAILED") && 3 == count_of(out.str(), "PASSED"));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, reporters, json_lines, "Tests that every permutation is written as a line of JSON", {
+  using namespace reporters_test;
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(table());
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter(permuter_test_kernels::identity, statistics);
+  std::ostringstream out;
+  json_lines_reporter r(&out);
+  BOOST_CHECK(!report(permuter, results, r, &statistics, "a \"quoted\"\ttest"));
+  BOOST_CHECK(4 == count_of(out.str(), "\n") && 4 == count_of(out.str(), "\"kernel_ns\":"));
+  BOOST_CHECK(4 == count_of(out.str(), "{\"test\":\"a \\\"quoted\\\"\\ttest\",\"index\":"));
+  BOOST_CHECK(1 == count_of(out.str(), "\"index\":2,\"count\":4,\"permutation\":\"kernel(3)\",\"passed\":false,\"skipped\":false,\"outcome\":\"3\",\"expected\":\"5\""));
+  BOOST_CHECK(3 == count_of(out.str(), "\"passed\":true"));
+  // Kernel times are omitted without statistics
+  out.str(std::string());
+  report(permuter, results, r);
+  BOOST_CHECK(4 == count_of(out.str(), "\n") && 0 == count_of(out.str(), "\"kernel_ns\":"));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, reporters, junit, "Tests that permutations are written as a JUnit test suite once ended", {
+  using namespace reporters_test;
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(100));
+  permuter.options().fail_fast = 1;
+  auto results = permuter([](int v) -> result<int> { return (50 == v) ? 0 : permuter_test_kernels::identity(v); });
+  std::ostringstream out;
+  junit_reporter r(&out);
+  BOOST_CHECK(!report(permuter, results, r, nullptr, "suite<1> & \"2\""));
+  const std::string s = out.str();
+  BOOST_CHECK(s.size() == r.written());
+  BOOST_CHECK(1 == count_of(s, "<testsuite name=\"suite&lt;1&gt; &amp; &quot;2&quot;\" tests=\"100\" failures=\"1\" errors=\"0\" skipped=\"49\""));
+  BOOST_CHECK(100 == count_of(s, "<testcase ") && 49 == count_of(s, "<skipped/>"));
+  BOOST_CHECK(1 == count_of(s, "name=\"51: kernel(50)\"><failure message=\"should be 50, was 0\"/>"));
+  BOOST_CHECK(1 == count_of(s, "</testsuites>"));
+  // Nothing is written until the totals are known
+  out.str(std::string());
+  r.begin("suite", results.size());
+  permuter.check(results, report_failure(permuter, r), report_success(permuter, r));
+  BOOST_CHECK(out.str().empty());
+  r.end();
+  BOOST_CHECK(1 == count_of(out.str(), "tests=\"51\" failures=\"1\" errors=\"0\" skipped=\"0\""));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, reporters, batching, "Tests that output is written in batches", {
+  using namespace reporters_test;
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(1000));
+  std::ostringstream out;
+  {
+    json_lines_reporter r(&out);
+    r.begin("batching", 1000);
+    BOOST_CHECK(permuter.stream(permuter_test_kernels::identity, report_failure(permuter, r), report_success(permuter, r)));
+    BOOST_CHECK(0 == r.written());
+    r.end();
+    BOOST_CHECK(r.written() == out.str().size());
+  }
+  BOOST_CHECK(1000 == count_of(out.str(), "\n"));
+  out.str(std::string());
+  json_lines_reporter r(&out, 4096);
+  r.begin("batching", 1000);
+  size_t writes = 0, last = 0;
+  permuter.check(permuter(permuter_test_kernels::identity), report_failure(permuter, r),
+                 [&](size_t idx, auto &result, auto &shouldbe)
+                 {
+                   report_success(permuter, r)(idx, result, shouldbe);
+                   if(r.written() != last)
+                   {
+                     BOOST_CHECK(r.written() - last >= 4096);
+                     last = r.written();
+                     writes++;
+                   }
+                   return true;
+                 });
+  r.end();
+  BOOST_CHECK(writes > 10 && writes < 1000);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, reporters, errors, "Tests reporting failed, absent and mismatched results", {
+  using namespace reporters_test;
+  using error_row = parameters<result<int>, parameters<int>>;
+  std::vector<error_row> errors{{0, {0}}, {1, {1}}, {2, {2}}, {3, {3}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(errors));
+  shard_options shard;
+  shard.index = 0;
+  shard.count = 2;
+  permuter.options().shard = shard;
+#ifndef _WIN32
+  permuter.options().capture_signals = true;
+#endif
+  auto results = permuter(
+  [](int v) -> result<int>
+  {
+#ifndef _WIN32
+    return permuter_test_kernels::crashes(v, 0);
+#else
+    return (0 == v) ? result<int>(make_error_code(kerneltest_errc::kernel_signal_thrown)) : v;
+#endif
+  });
+  std::ostringstream out;
+  json_lines_reporter r(&out);
+  BOOST_CHECK(!report(permuter, results, r));
+  // Only this shard's results are reported
+  BOOST_CHECK(2 == count_of(out.str(), "\n"));
+  BOOST_CHECK(1 == count_of(out.str(), "\"passed\":false,\"skipped\":false,\"outcome\":\"" + print(result<int>(make_error_code(kerneltest_errc::kernel_signal_thrown)))));
+  // Absent results of this shard are reported as not executed
+  std::ostringstream absent_out;
+  json_lines_reporter absent(&absent_out);
+  BOOST_CHECK(!report(permuter, permutation_results<result<int>>(4), absent));
+  BOOST_CHECK(2 == count_of(absent_out.str(), "\n"));
+  BOOST_CHECK(2 == count_of(absent_out.str(), "\"passed\":false,\"skipped\":false,\"outcome\":\"" + print(result<int>(make_error_code(kerneltest_errc::permutation_not_executed)))));
+#ifdef __cpp_exceptions
+  auto mismatched = permutation_results<result<int>>(3);
+  BOOST_CHECK_THROW(report(permuter, mismatched, r), std::invalid_argument);
+#endif
+})
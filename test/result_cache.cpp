@@ -0,0 +1,319 @@
+/* Tests for reusing the outcomes of permutations from earlier runs
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+namespace result_cache_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  static const char directory[] = "kerneltest_result_cache_test";
+
+  inline auto make_permuter(optional<shard_options> shard = {})
+  {
+    auto ret = mt_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(1000));
+    ret.options().cache.emplace();
+    ret.options().cache->directory = directory;
+    ret.options().shard = std::move(shard);
+    return ret;
+  }
+  // Executes the permuter, returning how many permutations were actually executed
+  template <class Permuter> inline size_t execute(Permuter &permuter, bool &ok)
+  {
+    std::atomic<size_t> ret{0};
+    auto results = permuter(
+    [&](int v)
+    {
+      ret++;
+      return permuter_test_kernels::identity(v);
+    });
+    ok = permuter.check(results, [](size_t, auto &, auto &) { return false; });
+    return ret;
+  }
+  // The cache file of the table
+  inline filesystem::path cache_file()
+  {
+    for(auto &i : filesystem::directory_iterator(directory))
+    {
+      if(i.path().extension() == ".ktcache")
+        return i.path();
+    }
+    return {};
+  }
+}  // namespace result_cache_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, result_cache, reuse, "Tests that outcomes are reused by later runs of the same build", {
+  using namespace result_cache_test;
+  filesystem::remove_all(directory);
+  bool ok = false;
+  {
+    auto permuter = make_permuter();
+    BOOST_CHECK(execute(permuter, ok) == 1000);
+    BOOST_CHECK(ok);
+  }
+  {
+    // Both values and errors are reused
+    auto permuter = make_permuter();
+    BOOST_CHECK(execute(permuter, ok) == 0);
+    BOOST_CHECK(ok);
+  }
+  {
+    auto permuter = make_permuter();
+    permuter.options().cache->rerun = true;
+    BOOST_CHECK(execute(permuter, ok) == 1000);
+    BOOST_CHECK(ok);
+  }
+  {
+    auto permuter = make_permuter();
+    permuter.options().cache->build_identity = "some other build";
+    BOOST_CHECK(execute(permuter, ok) == 1000);
+  }
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, result_cache, shards, "Tests that the shards of a table merge their outcomes into the same cache", {
+  using namespace result_cache_test;
+  filesystem::remove_all(directory);
+  bool ok = false;
+  for(size_t n = 0; n < 2; n++)
+  {
+    shard_options shard;
+    shard.index = n;
+    shard.count = 2;
+    auto permuter = make_permuter(shard);
+    BOOST_CHECK(execute(permuter, ok) == 500);
+  }
+  auto permuter = make_permuter();
+  BOOST_CHECK(execute(permuter, ok) == 0);
+  BOOST_CHECK(ok);
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, result_cache, concurrent, "Tests that concurrent saves of the same table keep the outcomes of every saver", {
+  using namespace result_cache_test;
+  filesystem::remove_all(directory);
+  result_cache_options options;
+  options.directory = directory;
+  std::atomic<size_t> failed{0};
+  std::vector<std::thread> threads;
+  for(uint64_t t = 0; t < 8; t++)
+  {
+    threads.emplace_back(
+    [&, t]
+    {
+      for(uint64_t n = 0; n < 10; n++)
+      {
+        detail::result_cache<result<int>> cache(options, "concurrent");
+        detail::portable_outcome<result<int>> outcome;
+        outcome.store(optional<result<int>>(result<int>(static_cast<int>(t * 10 + n))));
+        cache.insert(t * 10 + n, outcome);
+        if(!cache.save())
+          failed++;
+      }
+    });
+  }
+  for(auto &thread : threads)
+    thread.join();
+  BOOST_CHECK(failed == 0);
+  detail::result_cache<result<int>> cache(options, "concurrent");
+  for(uint64_t key = 0; key < 80; key++)
+  {
+    auto outcome = cache.find(key);
+    BOOST_CHECK(outcome && outcome->has_value() && outcome->value() == static_cast<int>(key));
+  }
+  // No temporary files are left behind
+  for(auto &i : filesystem::directory_iterator(directory))
+    BOOST_CHECK(i.path().extension() != ".tmp");
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, result_cache, corrupt, "Tests that corrupt cache files are discarded and rewritten", {
+  using namespace result_cache_test;
+  filesystem::remove_all(directory);
+  bool ok = false;
+  {
+    auto permuter = make_permuter();
+    execute(permuter, ok);
+  }
+  const filesystem::path path = cache_file();
+  BOOST_REQUIRE(!path.empty());
+  std::string contents;
+  {
+    std::ifstream s(path, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>());
+  }
+  auto corrupt_with = [&](const std::string &corrupted)
+  {
+    std::ofstream s(path, std::ios::binary | std::ios::trunc);
+    s.write(corrupted.data(), corrupted.size());
+  };
+  std::string bad_magic(contents);
+  bad_magic[0] ^= 0xff;
+  for(const std::string &corrupted : {contents.substr(0, contents.size() / 2), bad_magic, std::string("junk"), std::string()})
+  {
+    corrupt_with(corrupted);
+    auto permuter = make_permuter();
+    BOOST_CHECK(execute(permuter, ok) == 1000);
+    BOOST_CHECK(ok);
+    // The rewritten cache is intact again
+    auto again = make_permuter();
+    BOOST_CHECK(execute(again, ok) == 0);
+    BOOST_CHECK(ok);
+  }
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, result_cache, timed_out, "Tests that timed out outcomes are never reused", {
+  using namespace result_cache_test;
+  filesystem::remove_all(directory);
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table{{0, {0}}, {make_error_code(kerneltest_errc::kernel_timed_out), {1}}};
+  for(int run = 0; run < 2; run++)
+  {
+    auto permuter = mt_permute_parameters<result<int>, parameters<int>>(std::vector<row>(table));
+    permuter.options().cache.emplace();
+    permuter.options().cache->directory = directory;
+    permuter.options().timeout = std::chrono::milliseconds(20);
+    // The abandoned worker sleeping in the kernel outlives this
+    static std::atomic<size_t> executed;
+    executed = 0;
+    auto results = permuter(
+    [&](int v)
+    {
+      executed++;
+      return permuter_test_kernels::sleeps(v, v * 100);
+    });
+    BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+    BOOST_CHECK(executed == (run ? 1 : 2));
+  }
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, result_cache, regressed, "Tests that outcomes regressed from the baseline are never reused", {
+  using namespace result_cache_test;
+  filesystem::remove_all(directory);
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table{{0, {0}}, {1, {1}}};
+  // The permutations executed, once each however many times the benchmark repeats them
+  std::vector<int> executed;
+  auto execute_slowing = [&](bool record, bool cache, int slow)
+  {
+    auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::vector<row>(table));
+    permuter.options().baseline.emplace();
+    permuter.options().baseline->directory = directory;
+    permuter.options().baseline->record = record;
+    permuter.options().benchmark.emplace();
+    permuter.options().benchmark->warmup = 1;
+    permuter.options().benchmark->min_repetitions = 10;
+    permuter.options().benchmark->max_repetitions = 20;
+    if(cache)
+    {
+      permuter.options().cache.emplace();
+      permuter.options().cache->directory = directory;
+    }
+    executed.clear();
+    return permuter(
+    [&, slow](int v)
+    {
+      if(std::find(executed.begin(), executed.end(), v) == executed.end())
+        executed.push_back(v);
+      return permuter_test_kernels::sleeps(v, (v == slow) ? 5 : 1);
+    });
+  };
+  execute_slowing(true, false, -1);
+  // The regression fails the permutation, and the other's outcome is cached
+  auto results = execute_slowing(false, true, 1);
+  BOOST_CHECK(executed.size() == 2);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::performance_regressed) == 1);
+  // So only the regressed permutation is executed again, and now passes
+  results = execute_slowing(false, true, -1);
+  BOOST_CHECK(executed == std::vector<int>{1});
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::performance_regressed) == 0);
+  BOOST_REQUIRE(results[1].has_value());
+  BOOST_CHECK(results[1]->has_value() && results[1]->value() == 1);
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, result_cache, hook_parameters, "Tests that permutations differing only in hook parameters are cached separately", {
+  using namespace result_cache_test;
+  filesystem::remove_all(directory);
+  using row = parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>;
+  std::vector<row> table{{1, {1}, {0}}, {2, {1}, {1}}};
+  static int offset;
+  for(int run = 0; run < 2; run++)
+  {
+    // The hook prints only its description, whatever its parameter
+    auto permuter = st_permute_parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>(
+    std::vector<row>(table), hooks::custom([](auto &, auto &, size_t, int v) { return offset = v; }, [](int) {}, "offset"));
+    permuter.options().cache.emplace();
+    permuter.options().cache->directory = directory;
+    std::atomic<size_t> executed{0};
+    auto results = permuter(
+    [&](int v)
+    {
+      executed++;
+      return permuter_test_kernels::identity(v + offset);
+    });
+    BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+    BOOST_CHECK(executed == (run ? 0 : 2));
+  }
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, result_cache, kernels, "Tests that different kernels and tables within one test kernel are cached separately", {
+  using namespace result_cache_test;
+  filesystem::remove_all(directory);
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table{{0, {0}}, {1, {1}}};
+  auto make = [&](std::vector<row> t, const char *name = "")
+  {
+    auto ret = st_permute_parameters<result<int>, parameters<int>>(std::move(t));
+    ret.options().cache.emplace();
+    ret.options().cache->directory = directory;
+    ret.options().table_name = name;
+    return ret;
+  };
+  for(int run = 0; run < 2; run++)
+  {
+    size_t executed = 0;
+    auto permuter = make(table);
+    auto results = permuter(
+    [&](int v)
+    {
+      executed++;
+      return permuter_test_kernels::identity(v);
+    });
+    BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+    BOOST_CHECK(executed == (run ? 0 : 2));
+    // Another kernel over the same table never sees the outcomes of the first
+    executed = 0;
+    results = permuter(
+    [&](int v)
+    {
+      executed++;
+      return permuter_test_kernels::identity(v * 100);
+    });
+    BOOST_CHECK(executed == (run ? 0 : 2));
+    BOOST_REQUIRE(results[1].has_value());
+    BOOST_CHECK(results[1]->value() == 100);
+  }
+  // The same kernel over two tables of the same type is told apart by naming them
+  size_t executed = 0;
+  auto kernel = [&](int v)
+  {
+    executed++;
+    return permuter_test_kernels::identity(v);
+  };
+  auto first = make(table, "first"), second = make({{0, {0}}, {1, {1}}}, "second");
+  first(kernel);
+  BOOST_CHECK(executed == 2);
+  auto results = second(kernel);
+  BOOST_CHECK(second.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(executed == 4);
+  filesystem::remove_all(directory);
+})
@@ -0,0 +1,142 @@
+/* Tests for beginning the longest permutations first
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <fstream>
+#include <mutex>
+
+namespace schedule_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  static const char directory[] = "kerneltest_schedule_test";
+
+  // Executes a table of 64 permutations upon a single worker, returning the order they began in
+  template <class Permuter> inline std::vector<int> begin_order(Permuter &permuter, int slow_from)
+  {
+    permutation_executor executor(1);
+    permuter.options().executor = &executor;
+    std::mutex lock;
+    std::vector<int> ret;
+    auto results = permuter(
+    [&](int v)
+    {
+      {
+        std::lock_guard<std::mutex> g(lock);
+        ret.push_back(v);
+      }
+      return permuter_test_kernels::sleeps(v, (v >= slow_from) ? 20 : 0);
+    });
+    BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+    permuter.options().executor = nullptr;
+    return ret;
+  }
+  inline auto make_permuter()
+  {
+    std::vector<parameters<result<int>, parameters<int>>> table;
+    for(int n = 0; n < 64; n++)
+      table.push_back({n, {n}});
+    auto ret = mt_permute_parameters<result<int>, parameters<int>>(std::move(table));
+    ret.options().table_name = "schedule";
+    return ret;
+  }
+  // Identifies the table of make_permuter() within the current test kernel
+  inline std::string table() { return detail::current_test_kernel_path() + "schedule"; }
+}  // namespace schedule_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, schedule, longest_first, "Tests that positions are ordered by descending duration, ties by position", {
+  std::vector<std::chrono::nanoseconds> durations{std::chrono::nanoseconds(5), std::chrono::nanoseconds(9), std::chrono::nanoseconds(5),
+                                                  std::chrono::nanoseconds(1), std::chrono::nanoseconds(9)};
+  auto order = detail::longest_first(durations.size(), durations, [](size_t n) { return n; });
+  BOOST_CHECK((order == std::vector<size_t>{1, 4, 0, 2, 3}));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, schedule, durations, "Tests that permutations with the longest predicted durations begin first", {
+  auto permuter = schedule_test::make_permuter();
+  permuter.options().schedule.emplace();
+  for(int n = 0; n < 64; n++)
+    permuter.options().schedule->durations.push_back(std::chrono::nanoseconds(n));
+  auto order = schedule_test::begin_order(permuter, 64);
+  BOOST_REQUIRE(order.size() == 64);
+  for(int n = 0; n < 64; n++)
+    BOOST_CHECK(63 - n == order[n]);
+  // Durations of the wrong length are ignored
+  permuter.options().schedule->durations.pop_back();
+  order = schedule_test::begin_order(permuter, 64);
+  for(int n = 0; n < 64; n++)
+    BOOST_CHECK(n == order[n]);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, schedule, record, "Tests that measured durations are recorded and used by later runs", {
+  using namespace schedule_test;
+  filesystem::remove_all(directory);
+  auto permuter = make_permuter();
+  permuter.options().schedule.emplace();
+  permuter.options().schedule->directory = directory;
+  // Nothing is recorded yet, so the first run is in order of index
+  auto order = begin_order(permuter, 60);
+  BOOST_CHECK(order.front() == 0);
+  auto durations = detail::read_durations(directory, table(), 64);
+  BOOST_REQUIRE(durations.size() == 64);
+  BOOST_CHECK(durations[60] >= std::chrono::milliseconds(20) && durations[0] < std::chrono::milliseconds(20));
+  order = begin_order(permuter, 60);
+  std::sort(order.begin(), order.begin() + 4);
+  BOOST_CHECK((std::vector<int>(order.begin(), order.begin() + 4) == std::vector<int>{60, 61, 62, 63}));
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, schedule, corrupt, "Tests that corrupt duration files are ignored and rewritten", {
+  using namespace schedule_test;
+  filesystem::remove_all(directory);
+  auto permuter = make_permuter();
+  permuter.options().schedule.emplace();
+  permuter.options().schedule->directory = directory;
+  begin_order(permuter, 60);
+  const std::string path = detail::durations_path(directory, table(), 64);
+  std::string contents;
+  {
+    std::ifstream s(path, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>());
+  }
+  std::string bad_magic(contents);
+  bad_magic[0] ^= 0xff;
+  for(const std::string &corrupted : {contents.substr(0, contents.size() - 1), bad_magic, std::string("junk")})
+  {
+    {
+      std::ofstream s(path, std::ios::binary | std::ios::trunc);
+      s.write(corrupted.data(), corrupted.size());
+    }
+    BOOST_CHECK(detail::read_durations(directory, table(), 64).empty());
+    BOOST_CHECK(begin_order(permuter, 60).front() == 0);
+    BOOST_CHECK(detail::read_durations(directory, table(), 64).size() == 64);
+  }
+  filesystem::remove_all(directory);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, schedule, shards, "Tests that recording durations neither unbalances shards nor loses those of other shards", {
+  using namespace schedule_test;
+  filesystem::remove_all(directory);
+  for(int run = 0; run < 2; run++)
+  {
+    for(size_t n = 0; n < 2; n++)
+    {
+      auto permuter = make_permuter();
+      permuter.options().schedule.emplace();
+      permuter.options().schedule->directory = directory;
+      shard_options shard;
+      shard.index = n;
+      shard.count = 2;
+      permuter.options().shard = shard;
+      auto results = permuter([](int v) { return permuter_test_kernels::sleeps(v, 1); });
+      // Recorded durations never become costs, so each shard is its contiguous half of the table
+      for(size_t idx = 0; idx < results.size(); idx++)
+        BOOST_CHECK(results.present(idx) == (idx / 32 == n));
+    }
+    // Both shards' durations were recorded
+    auto durations = detail::read_durations(directory, table(), 64);
+    BOOST_REQUIRE(durations.size() == 64);
+    BOOST_CHECK(std::count(durations.begin(), durations.end(), std::chrono::nanoseconds(0)) == 0);
+  }
+  filesystem::remove_all(directory);
+})
@@ -0,0 +1,218 @@
+/* Tests for splitting the permutations of a table across processes
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace sharding_test
+{
+  using namespace KERNELTEST_V1_NAMESPACE;
+
+  using row = parameters<result<int>, parameters<int>>;
+  inline auto make_permuter(const std::string &name = std::string())
+  {
+    auto ret = mt_permute_parameters<result<int>, parameters<int>>(cartesian_product<row>([](int v) { return row{(77 == v) ? -1 : v, {v}}; },
+                                                                                          power_set<int>{1, 2, 4, 8, 16, 32, 64, 128, 256}));
+    ret.options().table_name = name;
+    return ret;
+  }
+  // Executes every shard of the table, returning the files written, which are replaced unless appending
+  inline std::vector<std::string> execute_shards(size_t count, const std::vector<std::chrono::nanoseconds> &costs, size_t &executed,
+                                                 const std::string &name = std::string(), bool append = false)
+  {
+    std::vector<std::string> ret;
+    executed = 0;
+    for(size_t n = 0; n < count; n++)
+    {
+      auto permuter = make_permuter(name);
+      shard_options shard;
+      shard.index = n;
+      shard.count = count;
+      shard.costs = costs;
+      shard.output = "kerneltest_sharding_test_" + std::to_string(n) + ".bin";
+      if(!append)
+        remove(shard.output.c_str());
+      permuter.options().shard = shard;
+      auto results = permuter(permuter_test_kernels::identity);
+      for(size_t i = 0; i < results.size(); i++)
+        executed += results.present(i);
+      ret.push_back(shard.output);
+    }
+    return ret;
+  }
+  inline void remove_all(const std::vector<std::string> &paths)
+  {
+    for(const auto &path : paths)
+      remove(path.c_str());
+  }
+}  // namespace sharding_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, sharding, merge, "Tests that the shards of a table cover it exactly once and merge back together", {
+  std::vector<std::chrono::nanoseconds> costs;
+  for(int n = 0; n < 512; n++)
+    costs.push_back(std::chrono::nanoseconds(n * n));
+  for(int balanced = 0; balanced < 2; balanced++)
+  {
+    size_t executed = 0;
+    auto paths = sharding_test::execute_shards(3, balanced ? costs : std::vector<std::chrono::nanoseconds>(), executed);
+    BOOST_CHECK(executed == 512);
+    auto permuter = sharding_test::make_permuter();
+    auto merged = permuter.merge_shards(permuter_test_kernels::identity, paths);
+    BOOST_REQUIRE(merged);
+    size_t failures = 0;
+    permuter.check(merged.value(),
+                   [&](size_t idx, auto &, auto &)
+                   {
+                     BOOST_CHECK(77 == idx);
+                     failures++;
+                     return false;
+                   });
+    BOOST_CHECK(failures == 1);
+    sharding_test::remove_all(paths);
+  }
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, sharding, absent, "Tests that only the results of permutations executed by other shards may be absent", {
+  auto permuter = sharding_test::make_permuter();
+  shard_options shard;
+  shard.index = 1;
+  shard.count = 3;
+  permuter.options().shard = shard;
+  auto results = permuter(permuter_test_kernels::identity);
+  const std::vector<bool> executed = permuter.in_shard();
+  BOOST_CHECK(static_cast<size_t>(std::count(executed.begin(), executed.end(), true)) == detail::shard_indices(512, shard).size());
+  size_t failures = 0, not_executed = 0;
+  auto fail = [&](size_t, auto &result, auto &)
+  {
+    failures++;
+    if(result->has_error() && result->error() == make_error_code(kerneltest_errc::permutation_not_executed))
+      not_executed++;
+    return false;
+  };
+  permuter.check(results, fail);
+  BOOST_CHECK(failures == (executed[77] ? 1u : 0u));
+  BOOST_CHECK(not_executed == 0);
+  // Absent results of this shard fail as not executed
+  failures = 0;
+  BOOST_CHECK(!permuter.check(permutation_results<result<int>>(512), fail));
+  BOOST_CHECK(failures == detail::shard_indices(512, shard).size());
+  BOOST_CHECK(not_executed == failures);
+  // As do all absent results if not sharded
+  permuter.options().shard = shard_options();
+  failures = not_executed = 0;
+  BOOST_CHECK(!permuter.check(permutation_results<result<int>>(512), fail));
+  BOOST_CHECK(failures == 512);
+  BOOST_CHECK(not_executed == 512);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, sharding, tables, "Tests that the shards of two tables of the same size written to the same files merge apart", {
+  std::vector<std::chrono::nanoseconds> costs;
+  for(int n = 0; n < 512; n++)
+    costs.push_back(std::chrono::nanoseconds(n * n));
+  size_t executed = 0;
+  auto paths = sharding_test::execute_shards(3, {}, executed, "contiguous");
+  BOOST_CHECK(executed == 512);
+  // Balanced differently, so a merge mixing the tables would see some permutations twice
+  sharding_test::execute_shards(3, costs, executed, "balanced", true);
+  BOOST_CHECK(executed == 512);
+  for(const char *name : {"contiguous", "balanced"})
+  {
+    auto permuter = sharding_test::make_permuter(name);
+    auto merged = permuter.merge_shards(permuter_test_kernels::identity, paths);
+    BOOST_REQUIRE(merged);
+    size_t failures = 0;
+    permuter.check(merged.value(),
+                   [&](size_t idx, auto &, auto &)
+                   {
+                     BOOST_CHECK(77 == idx);
+                     failures++;
+                     return false;
+                   });
+    BOOST_CHECK(failures == 1);
+  }
+  sharding_test::remove_all(paths);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, sharding, incomplete, "Tests that merging too few or too many shards fails", {
+  size_t executed = 0;
+  auto paths = sharding_test::execute_shards(3, {}, executed);
+  auto permuter = sharding_test::make_permuter();
+  auto missing = paths;
+  missing.pop_back();
+  auto merged = permuter.merge_shards(permuter_test_kernels::identity, missing);
+  BOOST_REQUIRE(!merged);
+  BOOST_CHECK(merged.error() == make_error_code(kerneltest_errc::shard_results_incomplete));
+  auto duplicated = paths;
+  duplicated.push_back(paths.front());
+  merged = permuter.merge_shards(permuter_test_kernels::identity, duplicated);
+  BOOST_REQUIRE(!merged);
+  BOOST_CHECK(merged.error() == make_error_code(kerneltest_errc::shard_results_incomplete));
+  merged = permuter.merge_shards(permuter_test_kernels::identity, {"kerneltest_sharding_test_nonexistent.bin"});
+  BOOST_CHECK(!merged && merged.error() != make_error_code(kerneltest_errc::shard_results_incomplete));
+  sharding_test::remove_all(paths);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, sharding, corrupt, "Tests that merging corrupt shard files fails", {
+  size_t executed = 0;
+  auto paths = sharding_test::execute_shards(2, {}, executed);
+  auto permuter = sharding_test::make_permuter();
+  std::string contents;
+  {
+    std::ifstream s(paths[1], std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>());
+  }
+  BOOST_REQUIRE(contents.size() > 64);
+  auto merge_with = [&](const std::string &corrupted)
+  {
+    {
+      std::ofstream s(paths[1], std::ios::binary | std::ios::trunc);
+      s.write(corrupted.data(), corrupted.size());
+    }
+    return permuter.merge_shards(permuter_test_kernels::identity, paths);
+  };
+  const auto invalid = make_error_code(kerneltest_errc::shard_results_invalid);
+  // Bad magic
+  std::string bad_magic(contents);
+  bad_magic[0] ^= 0xff;
+  auto merged = merge_with(bad_magic);
+  BOOST_CHECK(!merged && merged.error() == invalid);
+  // Truncated within a record
+  merged = merge_with(contents.substr(0, contents.size() - 3));
+  BOOST_CHECK(!merged && merged.error() == invalid);
+  // Trailing bytes too few to be a header
+  merged = merge_with(contents + "junk");
+  BOOST_CHECK(!merged && merged.error() == invalid);
+  // Intact once more
+  merged = merge_with(contents);
+  BOOST_CHECK(merged);
+  sharding_test::remove_all(paths);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, sharding, indices, "Tests that shard indices are disjoint and cover every permutation", {
+  std::vector<std::chrono::nanoseconds> costs;
+  for(int n = 0; n < 100; n++)
+    costs.push_back(std::chrono::nanoseconds((n % 10) * 1000));
+  for(int balanced = 0; balanced < 2; balanced++)
+  {
+    std::vector<int> covered(100);
+    for(size_t n = 0; n < 7; n++)
+    {
+      shard_options shard;
+      shard.index = n;
+      shard.count = 7;
+      if(balanced)
+        shard.costs = costs;
+      for(auto idx : detail::shard_indices(100, shard))
+        covered[idx]++;
+    }
+    BOOST_CHECK(std::count(covered.begin(), covered.end(), 1) == 100);
+  }
+  // An index beyond the count executes nothing
+  shard_options beyond;
+  beyond.index = 7;
+  beyond.count = 7;
+  BOOST_CHECK(detail::shard_indices(100, beyond).empty());
+})
@@ -0,0 +1,148 @@
+/* Tests for capturing signals raised by permutations within the test process
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#ifndef _WIN32
+namespace signal_capture_test
+{
+  // Overflows the stack, as n never becomes negative before then
+  static int recurse(volatile int n)
+  {
+    if(n < 0)
+      return 0;
+    volatile char buffer[1024];
+    buffer[0] = static_cast<char>(n);
+    return recurse(n + 1) + buffer[0];
+  }
+
+  // A resettable hook counting how many of its instances remain alive
+  static std::atomic<int> created{0}, alive{0};
+  struct counting_hook
+  {
+    static constexpr bool is_resettable = true;
+    template <class Parent, class RetType> struct impl
+    {
+      bool owner{true};
+      impl() { created++, alive++; }
+      impl(impl &&o) noexcept : owner(o.owner) { o.owner = false; }
+      ~impl()
+      {
+        if(owner)
+          alive--;
+      }
+      void reset(Parent *, RetType &, size_t) {}
+    };
+    template <class Parent, class RetType> auto operator()(Parent *, RetType &, size_t, int) const { return impl<Parent, RetType>(); }
+    std::string print(int v) const { return std::to_string(v); }
+  };
+}  // namespace signal_capture_test
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, signal_capture, crash, "Tests that permutations raising signals fail and the remainder still execute", {
+  using row = parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 200; n++)
+    table.push_back({n, {n}, {0}});
+  for(int n = 0; n < 40; n += 4)
+  {
+    table[n + 7] = {make_error_code(kerneltest_errc::kernel_signal_thrown), {-1}, {0}};
+    table[n + 8] = {make_error_code(kerneltest_errc::setup_signal_thrown), {n + 8}, {1}};
+    table[n + 9] = {make_error_code(kerneltest_errc::kernel_signal_thrown), {-2}, {0}};
+    table[n + 10] = {make_error_code(kerneltest_errc::kernel_signal_thrown), {-3}, {0}};
+  }
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>(
+  std::move(table), hooks::custom(
+                    [](auto &, auto &, size_t, int crash)
+                    {
+                      if(crash)
+                      {
+                        volatile int *p = nullptr;
+                        *p = crash;
+                      }
+                      return crash;
+                    },
+                    [](int) {}, "crashes"));
+  permuter.options().capture_signals = true;
+  auto kernel = [](int v) -> result<int>
+  {
+    if(-2 == v)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      // Only faults are captured, not signals sent by raise(), and only x86 faults upon integer division by zero
+      volatile int zero = 0;
+      return v / zero;
+#else
+      return permuter_test_kernels::crashes(v, v);
+#endif
+    }
+    if(-3 == v)
+      return signal_capture_test::recurse(0);
+    return permuter_test_kernels::crashes(v, -1);
+  };
+  // The handlers must be reinstalled each time the permuter is called
+  for(int pass = 0; pass < 2; pass++)
+  {
+    auto results = permuter(kernel);
+    BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+    BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_signal_thrown) == 30);
+    BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::setup_signal_thrown) == 10);
+  }
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, signal_capture, cleanup, "Tests that recovering from a signal discards pooled hooks and restores the allocation tally", {
+  using signal_capture_test::alive;
+  using signal_capture_test::created;
+  using row = parameters<result<int>, parameters<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 20; n++)
+    table.push_back({(5 == n) ? result<int>(make_error_code(kerneltest_errc::kernel_signal_thrown)) : result<int>(n), {n}, {n % 2}});
+  {
+    auto permuter = st_permute_parameters<result<int>, parameters<int>, parameters<int>>(std::move(table), signal_capture_test::counting_hook{});
+    permuter.options().capture_signals = true;
+    permuter.options().allocations = true;
+    permuter.options().counters = true;
+    auto results = permuter(
+    [](int v)
+    {
+      std::vector<int> block(100);
+      return permuter_test_kernels::crashes(v + static_cast<int>(block.size()) - 100, 5);
+    });
+    BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+    // One instance per parameter, plus the replacement for the one discarded by the crash
+    BOOST_CHECK(created == 3);
+  }
+  BOOST_CHECK(alive == 0);
+  BOOST_CHECK(detail::this_thread_allocations().active == 0);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, signal_capture, sent, "Tests that signals sent rather than raised by a fault are passed to the previous handler", {
+  detail::install_signal_capture();
+  auto &prev = detail::previous_signal_handlers_instance();
+  size_t bus = 0;
+  while(prev.signals[bus] != SIGBUS)
+    bus++;
+  // Ignored by the previous handler, so the test survives it being passed on
+  const struct sigaction saved = prev.actions[bus];
+  memset(&prev.actions[bus], 0, sizeof(prev.actions[bus]));
+  prev.actions[bus].sa_handler = SIG_IGN;
+  siginfo_t info;
+  memset(&info, 0, sizeof(info));
+  info.si_signo = SIGBUS;
+  volatile bool recovered = false;
+  for(int si_code : {SI_USER, SI_QUEUE})
+  {
+    info.si_code = si_code;
+    detail::signal_recovery_point recovery;
+    if(sigsetjmp(recovery.buf, 0) != 0)
+      recovered = true;
+    else
+    {
+      recovery.arm();
+      detail::signal_capture_handler(SIGBUS, &info, nullptr);
+      recovery.armed = false;
+    }
+  }
+  prev.actions[bus] = saved;
+  BOOST_CHECK(!recovered);
+})
+#endif
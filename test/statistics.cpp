@@ -0,0 +1,67 @@
+/* Tests for the per-permutation stage timings
+*/
+
+#include "permuter_test_kernels.hpp"
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, statistics, stages, "Tests that the setup, kernel and teardown of each permutation are timed", {
+  using row = parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 8; n++)
+    table.push_back({n, {n}, {n % 2}});
+  auto permuter = st_permute_parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>(
+  std::move(table), hooks::custom(
+                    [](auto &, auto &, size_t, int slow)
+                    {
+                      // Setup takes 2ms when slow
+                      if(slow)
+                        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                      return slow;
+                    },
+                    [](int slow)
+                    {
+                      // Teardown takes 3ms when slow
+                      if(slow)
+                        std::this_thread::sleep_for(std::chrono::milliseconds(3));
+                    },
+                    "sleeps"));
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter([](int v) { return permuter_test_kernels::sleeps(v, 1); }, statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_REQUIRE(statistics.size() == 8);
+  for(size_t n = 0; n < statistics.size(); n++)
+  {
+    const auto &s = statistics[n];
+    BOOST_CHECK(s.kernel >= std::chrono::milliseconds(1));
+    if(n % 2)
+    {
+      BOOST_CHECK(s.hook_setup[0] >= std::chrono::milliseconds(2));
+      BOOST_CHECK(s.hook_teardown[0] >= std::chrono::milliseconds(3));
+    }
+    else
+    {
+      BOOST_CHECK(s.hook_setup[0] < std::chrono::milliseconds(2));
+      BOOST_CHECK(s.hook_teardown[0] < std::chrono::milliseconds(3));
+    }
+    BOOST_CHECK(s.total() == s.setup() + s.kernel + s.teardown());
+  }
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, statistics, failures, "Tests that failing and throwing permutations are still timed", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table{{0, {0}}, {make_error_code(std::errc::invalid_argument), {-1}}, {make_error_code(kerneltest_errc::kernel_exception_thrown), {-2}}};
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  decltype(permuter)::statistics_sequence_type statistics;
+  auto results = permuter(
+  [](int v) -> result<int>
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if(-2 == v)
+      throw std::runtime_error("kernel failed");
+    return permuter_test_kernels::identity(v);
+  },
+  statistics);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_REQUIRE(statistics.size() == 3);
+  BOOST_CHECK(statistics[0].kernel >= std::chrono::milliseconds(1));
+  BOOST_CHECK(statistics[1].kernel >= std::chrono::milliseconds(1));
+})
@@ -0,0 +1,70 @@
+/* Tests for checking results as each permutation completes
+*/
+
+#include "permuter_test_kernels.hpp"
+
+#include <set>
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, stream, check, "Tests that streaming calls fail or pass exactly once per permutation", {
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(10000));
+  std::set<size_t> seen;
+  size_t passes = 0, duplicates = 0;
+  const bool ok = permuter.stream(
+  [](int v) { return (77 == v || 5000 == v) ? result<int>(-1) : permuter_test_kernels::identity(v); },
+  [&](size_t idx, auto &result, auto &)
+  {
+    // Calls are serialised, so no locking is needed here
+    duplicates += !seen.insert(idx).second;
+    BOOST_CHECK(77 == idx || 5000 == idx);
+    BOOST_CHECK(result && result->value() == -1);
+    return false;
+  },
+  [&](size_t idx, auto &, auto &)
+  {
+    duplicates += !seen.insert(idx).second;
+    passes++;
+    return true;
+  });
+  BOOST_CHECK(!ok);
+  BOOST_CHECK(passes == 9998);
+  BOOST_CHECK(seen.size() == 10000 && duplicates == 0);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, stream, pass, "Tests that streaming returns true if every result matches", {
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(100));
+  BOOST_CHECK(permuter.stream(permuter_test_kernels::identity, [](size_t, auto &, auto &) { return false; }));
+  // A pass callback returning false also fails the stream
+  BOOST_CHECK(!permuter.stream(
+  permuter_test_kernels::identity, [](size_t, auto &, auto &) { return false; }, [](size_t idx, auto &, auto &) { return idx != 50; }));
+})
+
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(unit, kerneltest, stream, isolation, "Tests that streaming isolated permutations reports crashes", {
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(20));
+  permuter.options().isolation.emplace();
+  std::vector<size_t> failed;
+  BOOST_CHECK(!permuter.stream([](int v) { return permuter_test_kernels::crashes(v, 4); },
+                               [&](size_t idx, auto &result, auto &)
+                               {
+                                 failed.push_back(idx);
+                                 BOOST_CHECK(result && result->error() == make_error_code(kerneltest_errc::kernel_signal_thrown));
+                                 return false;
+                               }));
+  BOOST_CHECK(failed.size() == 1 && 4 == failed[0]);
+})
+#endif
+
+#ifdef __cpp_exceptions
+KERNELTEST_TEST_KERNEL(unit, kerneltest, stream, throwing_callback, "Tests that an exception thrown by a callback propagates out of the stream", {
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(permuter_test_kernels::identity_table(1000));
+  BOOST_CHECK_THROW(permuter.stream(
+                    permuter_test_kernels::identity, [](size_t, auto &, auto &) { return false; },
+                    [](size_t idx, auto &, auto &) -> bool
+                    {
+                      if(500 == idx)
+                        throw std::runtime_error("callback failed");
+                      return true;
+                    }),
+                    std::runtime_error);
+})
+#endif
@@ -0,0 +1,95 @@
+/* Tests for failing permutations which exceed their deadline
+*/
+
+#include "permuter_test_kernels.hpp"
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, timeout, kernel, "Tests that slow kernels fail as having timed out", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 200; n++)
+    table.push_back({(7 == n % 50) ? result<int>(make_error_code(kerneltest_errc::kernel_timed_out)) : result<int>(n), {n}});
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().timeout = std::chrono::milliseconds(50);
+  auto results = permuter([](int v) { return permuter_test_kernels::sleeps(v, (7 == v % 50) ? 150 : 0); });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_timed_out) == 4);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, timeout, setup, "Tests that slow hook setups fail as having timed out during setup", {
+  using row = parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>;
+  std::vector<row> table{{0, {0}, {0}}, {make_error_code(kerneltest_errc::setup_timed_out), {1}, {150}}, {2, {2}, {0}}};
+  auto permuter = st_permute_parameters<result<int>, parameters<int>, hooks::custom_parameters<int>>(
+  std::move(table), hooks::custom(
+                    [](auto &, auto &, size_t, int ms)
+                    {
+                      std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+                      return ms;
+                    },
+                    [](int) {}, "sleeps"));
+  permuter.options().timeout = std::chrono::milliseconds(50);
+  auto results = permuter(permuter_test_kernels::identity);
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, timeout, hook, "Tests that the timeout hook overrides the deadline per permutation", {
+  using row = parameters<result<int>, parameters<int>, hooks::timeout_parameters>;
+  std::vector<row> table;
+  for(int n = 0; n < 8; n++)
+  {
+    if(n < 4)
+      table.push_back({make_error_code(kerneltest_errc::kernel_timed_out), {n}, {std::chrono::milliseconds(20)}});
+    else
+      table.push_back({n, {n}, {std::chrono::milliseconds(500)}});
+  }
+  auto permuter = st_permute_parameters<result<int>, parameters<int>, hooks::timeout_parameters>(std::move(table), hooks::timeout());
+  auto results = permuter([](int v) { return permuter_test_kernels::sleeps(v, 100); });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, timeout, abandon, "Tests that workers stuck in permutations which never return are abandoned and replaced", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 100; n++)
+    table.push_back({(5 == n % 50) ? result<int>(make_error_code(kerneltest_errc::kernel_timed_out)) : result<int>(n), {n}});
+  permutation_executor executor(4);
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().executor = &executor;
+  permuter.options().timeout = std::chrono::milliseconds(50);
+  auto results = permuter([](int v) { return (5 == v % 50) ? permuter_test_kernels::hangs(v) : permuter_test_kernels::identity(v); });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_timed_out) == 2);
+  // The replacement workers execute later runs as normal
+  BOOST_CHECK(executor.concurrency() == 4);
+  permuter.options().timeout = std::chrono::nanoseconds(0);
+  results = permuter(permuter_test_kernels::identity);
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_timed_out) == 0);
+})
+
+#ifndef _WIN32
+KERNELTEST_TEST_KERNEL(unit, kerneltest, timeout, hangs, "Tests that permutations which never return are killed even if isolation was not asked for", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 10; n++)
+    table.push_back({(3 == n) ? result<int>(make_error_code(kerneltest_errc::kernel_timed_out)) : result<int>(n), {n}});
+  auto permuter = st_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().timeout = std::chrono::milliseconds(50);
+  BOOST_REQUIRE(!permuter.options().isolation);
+  auto results = permuter([](int v) { return (3 == v) ? permuter_test_kernels::hangs(v) : permuter_test_kernels::identity(v); });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_timed_out) == 1);
+})
+
+KERNELTEST_TEST_KERNEL(unit, kerneltest, timeout, isolation, "Tests that isolated permutations which never return are killed", {
+  using row = parameters<result<int>, parameters<int>>;
+  std::vector<row> table;
+  for(int n = 0; n < 40; n++)
+    table.push_back({(9 == n % 20) ? result<int>(make_error_code(kerneltest_errc::kernel_timed_out)) : result<int>(n), {n}});
+  auto permuter = mt_permute_parameters<result<int>, parameters<int>>(std::move(table));
+  permuter.options().timeout = std::chrono::milliseconds(50);
+  permuter.options().isolation.emplace();
+  permuter.options().isolation->processes = 4;
+  auto results = permuter([](int v) { return (9 == v % 20) ? permuter_test_kernels::hangs(v) : permuter_test_kernels::identity(v); });
+  BOOST_CHECK(permuter.check(results, [](size_t, auto &, auto &) { return false; }));
+  BOOST_CHECK(permuter_test_kernels::count_errors(results, kerneltest_errc::kernel_timed_out) == 2);
+})
+#endif